@@ -27,75 +27,78 @@
  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include "AStar.h"
-#include <math.h>
+#include "AStarPrivate.h"
 #include <string.h>
 #include <stdint.h>
-
-struct __ASNeighborList {
-    const ASPathNodeSource *source;
-    size_t capacity;
-    size_t count;
-    float *costs;
-    void *nodeKeys;
-};
-
-struct __ASPath {
-    size_t nodeSize;
-    size_t count;
-    float* costs;
-    void *nodeKeys;
-};
-
-typedef struct {
-    unsigned isClosed:1;
-    unsigned isOpen:1;
-    unsigned isGoal:1;
-    unsigned hasParent:1;
-    unsigned hasEstimatedCost:1;
-    float estimatedCost;
-    float cost;
-    size_t openIndex;
-    size_t parentIndex;
-    int8_t nodeKey[];
-} NodeRecord;
-
-struct __VisitedNodes {
-    const ASPathNodeSource *source;
-    void *context;
-    size_t nodeRecordsCapacity;
-    size_t nodeRecordsCount;
-    void *nodeRecords;
-    size_t *nodeRecordsIndex;           // array of nodeRecords indexes, kept sorted by nodeRecords[i]->nodeKey using source->nodeComparator
-    size_t openNodesCapacity;
-    size_t openNodesCount;
-    size_t *openNodes;                  // binary heap of nodeRecords indexes, sorted by the nodeRecords[i]->rank
-};
-typedef struct __VisitedNodes *VisitedNodes;
-
-typedef struct {
-    VisitedNodes nodes;
-    size_t index;
-} Node;
+#include <time.h>
 
 static const Node NodeNull = {NULL, -1};
 
 /********************************************/
 
-static inline VisitedNodes VisitedNodesCreate(const ASPathNodeSource *source, void *context)
+void *ResizeSearchBuffer(SearchMemory *memory, void *buffer, size_t bytes, size_t grownBytes)
+{
+    // returns the resized buffer, or NULL with buffer left as it was
+    if (!TakeSearchMemory(memory, grownBytes - bytes)) {
+        return NULL;
+    }
+
+    void *grown = realloc(buffer, grownBytes);
+    if (!grown) {
+        memory->used -= grownBytes - bytes;
+        memory->exceeded = 1;
+    }
+    return grown;
+}
+
+void *GrowSearchBuffer(SearchMemory *memory, void *buffer, size_t *capacity, size_t elementSize)
 {
-    VisitedNodes nodes = calloc(1, sizeof(struct __VisitedNodes));
+    // makes room for at least one more element, returns the grown buffer and updates capacity or returns NULL and leaves both
+    const size_t grownCapacity = GrowSearchCapacity(memory, *capacity, *capacity + 1, elementSize);
+    void *grown = grownCapacity? ResizeSearchBuffer(memory, buffer, *capacity * elementSize, grownCapacity * elementSize) : NULL;
+
+    if (grown) {
+        *capacity = grownCapacity;
+    }
+    return grown;
+}
+
+static inline size_t NodeRecordSize(const ASPathNodeSource *source)
+{
+    return sizeof(NodeRecord) + source->nodeSize;
+}
+
+static inline void VisitedNodesBind(VisitedNodes nodes, const ASPathNodeSource *source, void *context, const ASSearchOptions *options)
+{
+    // the buffers are kept at their high-water size, only the counts are cleared
+    // records are zeroed one by one as GetNode() hands them out, so nothing has to be wiped here
     nodes->source = source;
     nodes->context = context;
-    return nodes;
+    nodes->nodeRecordsCapacity = nodes->nodeRecordsSize / NodeRecordSize(source);
+    nodes->nodeRecordsCount = 0;
+    nodes->openNodesCount = 0;
+    nodes->openEntries.count = 0;
+    memset(&nodes->stats, 0, sizeof(ASSearchStats));
+
+    // the d-ary heaps only order by rank, so the cooperative tie-break keeps the binary heap, and so does the bucket queue
+    const int dAry = (options->openSet == ASOpenSet4AryHeap || options->openSet == ASOpenSet8AryHeap);
+    nodes->openSet = (dAry && !nodes->tieBreakHigherCost)? options->openSet : ASOpenSetBinaryHeap;
+    nodes->openEntries.arity = (options->openSet == ASOpenSet8AryHeap)? 8 : 4;
+
+    if (++nodes->indexGeneration == 0) {
+        // the generation wrapped around, so old stamps could look current again
+        memset(nodes->indexSlots, 0, nodes->indexSlotsCapacity * sizeof(IndexSlot));
+        nodes->indexGeneration = 1;
+    }
 }
 
-static inline void VisitedNodesDestroy(VisitedNodes visitedNodes)
+static inline void VisitedNodesFree(VisitedNodes visitedNodes)
 {
     free(visitedNodes->nodeRecordsIndex);
+    free(visitedNodes->indexSlots);
     free(visitedNodes->nodeRecords);
     free(visitedNodes->openNodes);
-    free(visitedNodes);
+    free(visitedNodes->openEntries.entries);
 }
 
 static inline int NodeIsNull(Node n)
@@ -110,7 +113,7 @@ static inline Node NodeMake(VisitedNodes nodes, size_t index)
 
 static inline NodeRecord *NodeGetRecord(Node node)
 {
-    return node.nodes->nodeRecords + (node.index * (node.nodes->source->nodeSize + sizeof(NodeRecord)));
+    return node.nodes->nodeRecords + (node.index * NodeRecordSize(node.nodes->source));
 }
 
 static inline void *GetNodeKey(Node node)
@@ -196,6 +199,10 @@ static inline int NodeRankCompare(Node n1, Node n2)
         return -1;
     } else if (rank1 > rank2) {
         return 1;
+    } else if (n1.nodes->tieBreakHigherCost) {
+        const float cost1 = GetNodeCost(n1);
+        const float cost2 = GetNodeCost(n2);
+        return (cost1 > cost2)? -1 : (cost1 < cost2);
     } else {
         return 0;
     }
@@ -219,11 +226,111 @@ static inline int NodeKeyCompare(Node node, void *nodeKey)
     }
 }
 
+static inline Node AddNodeRecord(VisitedNodes nodes, void *nodeKey)
+{
+    // returns NodeNull if the records cannot grow
+    if (nodes->nodeRecordsCount == nodes->nodeRecordsCapacity) {
+        const size_t recordSize = NodeRecordSize(nodes->source);
+        const size_t capacity = GrowSearchCapacity(nodes->memory, nodes->nodeRecordsCapacity, nodes->nodeRecordsCount + 1, recordSize);
+        void *records = capacity? ResizeSearchBuffer(nodes->memory, nodes->nodeRecords, nodes->nodeRecordsSize, capacity * recordSize) : NULL;
+        if (!records) {
+            return NodeNull;
+        }
+        nodes->nodeRecords = records;
+        nodes->nodeRecordsCapacity = capacity;
+        nodes->nodeRecordsSize = capacity * recordSize;
+    }
+
+    Node node = NodeMake(nodes, nodes->nodeRecordsCount);
+    nodes->nodeRecordsCount++;
+
+    NodeRecord *record = NodeGetRecord(node);
+    memset(record, 0, sizeof(NodeRecord));
+    memcpy(record->nodeKey, nodeKey, nodes->source->nodeSize);
+
+    return node;
+}
+
+static inline size_t MixHash(size_t hash)
+{
+    // spreads weak hashes (such as plain node ids) over the low bits used to pick a slot
+    uint64_t h = hash;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (size_t)h;
+}
+
+static inline int GrowIndexSlots(VisitedNodes nodes)
+{
+    // the old slots are moved over to the new ones, so both count against the limit until the old ones are freed
+    const size_t capacity = nodes->indexSlotsCapacity? nodes->indexSlotsCapacity * 2 : 64;
+    if (!TakeSearchMemory(nodes->memory, capacity * sizeof(IndexSlot))) {
+        return 0;
+    }
+
+    IndexSlot *slots = calloc(capacity, sizeof(IndexSlot));
+    if (!slots) {
+        nodes->memory->used -= capacity * sizeof(IndexSlot);
+        nodes->memory->exceeded = 1;
+        return 0;
+    }
+
+    for (size_t i=0; i<nodes->indexSlotsCapacity; i++) {
+        if (nodes->indexSlots[i].generation == nodes->indexGeneration) {
+            size_t slot = nodes->indexSlots[i].hash & (capacity - 1);
+            while (slots[slot].generation == nodes->indexGeneration) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            slots[slot] = nodes->indexSlots[i];
+        }
+    }
+
+    free(nodes->indexSlots);
+    nodes->memory->used -= nodes->indexSlotsCapacity * sizeof(IndexSlot);
+    nodes->indexSlots = slots;
+    nodes->indexSlotsCapacity = capacity;
+    return 1;
+}
+
+static inline Node GetHashedNode(VisitedNodes nodes, void *nodeKey)
+{
+    // looks it up in the hash index, if it's not found it inserts a new record in the first free slot of its probe sequence
+    if (2 * (nodes->nodeRecordsCount + 1) > nodes->indexSlotsCapacity && !GrowIndexSlots(nodes)) {
+        return NodeNull;
+    }
+
+    const size_t hash = MixHash(nodes->source->nodeHash(nodeKey, nodes->context));
+    const size_t mask = nodes->indexSlotsCapacity - 1;
+    size_t slot = hash & mask;
+
+    while (nodes->indexSlots[slot].generation == nodes->indexGeneration) {
+        if (nodes->indexSlots[slot].hash == hash) {
+            Node node = NodeMake(nodes, nodes->indexSlots[slot].recordIndex);
+            if (NodeKeyCompare(node, nodeKey) == 0) {
+                return node;
+            }
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    Node node = AddNodeRecord(nodes, nodeKey);
+    if (!NodeIsNull(node)) {
+        nodes->indexSlots[slot] = (IndexSlot){hash, node.index, nodes->indexGeneration};
+    }
+
+    return node;
+}
+
 static inline Node GetNode(VisitedNodes nodes, void *nodeKey)
 {
     if (!nodeKey) {
         return NodeNull;
     }
+
+    if (nodes->source->nodeHash) {
+        return GetHashedNode(nodes, nodeKey);
+    }
     
     // looks it up in the index, if it's not found it inserts a new record in the sorted index and the nodeRecords array and returns a reference to it
     size_t first = 0;
@@ -246,22 +353,23 @@ static inline Node GetNode(VisitedNodes nodes, void *nodeKey)
             }
         }
     }
-    
-    if (nodes->nodeRecordsCount == nodes->nodeRecordsCapacity) {
-        nodes->nodeRecordsCapacity = 1 + (nodes->nodeRecordsCapacity * 2);
-        nodes->nodeRecords = realloc(nodes->nodeRecords, nodes->nodeRecordsCapacity * (sizeof(NodeRecord) + nodes->source->nodeSize));
-        nodes->nodeRecordsIndex = realloc(nodes->nodeRecordsIndex, nodes->nodeRecordsCapacity * sizeof(size_t));
+
+    if (nodes->nodeRecordsCount == nodes->nodeRecordsIndexCapacity) {
+        size_t *index = GrowSearchBuffer(nodes->memory, nodes->nodeRecordsIndex, &nodes->nodeRecordsIndexCapacity, sizeof(size_t));
+        if (!index) {
+            return NodeNull;
+        }
+        nodes->nodeRecordsIndex = index;
     }
-    
-    Node node = NodeMake(nodes, nodes->nodeRecordsCount);
-    nodes->nodeRecordsCount++;
-    
-    memmove(&nodes->nodeRecordsIndex[first+1], &nodes->nodeRecordsIndex[first], (nodes->nodeRecordsCapacity - first - 1) * sizeof(size_t));
+
+    Node node = AddNodeRecord(nodes, nodeKey);
+    if (NodeIsNull(node)) {
+        return NodeNull;
+    }
+
+    // node.index is the number of records there were before it
+    memmove(&nodes->nodeRecordsIndex[first+1], &nodes->nodeRecordsIndex[first], (node.index - first) * sizeof(size_t));
     nodes->nodeRecordsIndex[first] = node.index;
-    
-    NodeRecord *record = NodeGetRecord(node);
-    memset(record, 0, sizeof(NodeRecord));
-    memcpy(record->nodeKey, nodeKey, nodes->source->nodeSize);
 
     return node;
 }
@@ -305,30 +413,48 @@ static inline void DidRemoveFromOpenSetAtIndex(VisitedNodes nodes, size_t index)
     } while (smallestIndex != index);
 }
 
+static inline void DidInsertIntoOpenSetAtIndex(VisitedNodes nodes, size_t index)
+{
+    while (index > 0) {
+        const size_t parentIndex = floorf((index-1) / 2);
+        
+        if (NodeRankCompare(NodeMake(nodes, nodes->openNodes[parentIndex]), NodeMake(nodes, nodes->openNodes[index])) < 0) {
+            break;
+        } else {
+            SwapOpenSetNodesAtIndexes(nodes, parentIndex, index);
+            index = parentIndex;
+        }
+    }
+}
+
+static inline int OpenEntryIsCurrent(VisitedNodes nodes, OpenEntry entry)
+{
+    const Node n = NodeMake(nodes, entry.id);
+    return NodeIsInOpenSet(n) && entry.rank == GetNodeRank(n);
+}
+
 static inline void RemoveNodeFromOpenSet(Node n)
 {
     NodeRecord *record = NodeGetRecord(n);
 
-    if (record->isOpen) {
+    if (record->isOpen && n.nodes->openSet != ASOpenSetBinaryHeap) {
+        // entries are deleted lazily, only the top one is popped right away
+        record->isOpen = 0;
+        if (n.nodes->openEntries.entries[0].id == n.index) {
+            PopOpenEntry(&n.nodes->openEntries, &n.nodes->stats);
+        }
+    } else if (record->isOpen) {
         record->isOpen = 0;
         n.nodes->openNodesCount--;
+        n.nodes->stats.pops++;
         
         const size_t index = record->openIndex;
         SwapOpenSetNodesAtIndexes(n.nodes, index, n.nodes->openNodesCount);
         DidRemoveFromOpenSetAtIndex(n.nodes, index);
-    }
-}
 
-static inline void DidInsertIntoOpenSetAtIndex(VisitedNodes nodes, size_t index)
-{
-    while (index > 0) {
-        const size_t parentIndex = floorf((index-1) / 2);
-        
-        if (NodeRankCompare(NodeMake(nodes, nodes->openNodes[parentIndex]), NodeMake(nodes, nodes->openNodes[index])) < 0) {
-            break;
-        } else {
-            SwapOpenSetNodesAtIndexes(nodes, parentIndex, index);
-            index = parentIndex;
+        // the node moved into the hole came from the bottom of the heap, so it may also have to move up
+        if (index < n.nodes->openNodesCount) {
+            DidInsertIntoOpenSetAtIndex(n.nodes, index);
         }
     }
 }
@@ -344,9 +470,29 @@ static inline void AddNodeToOpenSet(Node n, float cost, Node parent)
         record->hasParent = 0;
     }
 
+    if (n.nodes->openSet != ASOpenSetBinaryHeap) {
+        // the entries hold 32 bit ids, so a search visiting more nodes than that stops as out of memory
+        if (n.index > UINT32_MAX) {
+            n.nodes->memory->exceeded = 1;
+            return;
+        }
+        record->cost = cost;
+        if (!PushOpenEntry(&n.nodes->openEntries, n.nodes->memory, (uint32_t)n.index, GetNodeRank(n))) {
+            return;
+        }
+        record->isOpen = 1;
+        CountOpenSetPush(&n.nodes->stats);
+        TraceSearchEvent(n.nodes, ASTraceOpen, GetNodeKey(n), cost);
+        return;
+    }
+
     if (n.nodes->openNodesCount == n.nodes->openNodesCapacity) {
-        n.nodes->openNodesCapacity = 1 + (n.nodes->openNodesCapacity * 2);
-        n.nodes->openNodes = realloc(n.nodes->openNodes, n.nodes->openNodesCapacity * sizeof(size_t));
+        size_t *openNodes = GrowSearchBuffer(n.nodes->memory, n.nodes->openNodes, &n.nodes->openNodesCapacity, sizeof(size_t));
+        if (!openNodes) {
+            // the node stays out of the open set, the search stops as out of memory
+            return;
+        }
+        n.nodes->openNodes = openNodes;
     }
 
     const size_t openIndex = n.nodes->openNodesCount;
@@ -356,42 +502,232 @@ static inline void AddNodeToOpenSet(Node n, float cost, Node parent)
     record->openIndex = openIndex;
     record->isOpen = 1;
     record->cost = cost;
+    CountOpenSetPush(&n.nodes->stats);
+    TraceSearchEvent(n.nodes, ASTraceOpen, GetNodeKey(n), cost);
 
     DidInsertIntoOpenSetAtIndex(n.nodes, openIndex);
 }
 
 static inline int HasOpenNode(VisitedNodes nodes)
 {
+    if (nodes->openSet != ASOpenSetBinaryHeap) {
+        while (nodes->openEntries.count > 0 && !OpenEntryIsCurrent(nodes, nodes->openEntries.entries[0])) {
+            PopOpenEntry(&nodes->openEntries, &nodes->stats);
+        }
+        return nodes->openEntries.count > 0;
+    }
     return nodes->openNodesCount > 0;
 }
 
 static inline Node GetOpenNode(VisitedNodes nodes)
 {
+    if (nodes->openSet != ASOpenSetBinaryHeap) {
+        return NodeMake(nodes, nodes->openEntries.entries[0].id);
+    }
     return NodeMake(nodes, nodes->openNodes[0]);
 }
 
-static inline ASNeighborList NeighborListCreate(const ASPathNodeSource *source)
+static void *NeighborListGetNodeKey(ASNeighborList list, size_t index)
 {
-    ASNeighborList list = calloc(1, sizeof(struct __ASNeighborList));
-    list->source = source;
-    return list;
+    return list->nodeKeys + (index * list->nodeSize);
 }
 
-static inline void NeighborListDestroy(ASNeighborList list)
+static inline void DenseNodesFree(DenseNodes nodes)
 {
-    free(list->costs);
-    free(list->nodeKeys);
-    free(list);
+    free(nodes->records);
+    free(nodes->openNodes);
+    free(nodes->openEntries.entries);
+    free(nodes->buckets);
+    free(nodes->bucketEntries);
 }
 
-static inline float NeighborListGetEdgeCost(ASNeighborList list, size_t index)
+static inline size_t PathKeysOffset(size_t count)
 {
-    return list->costs[index];
+    // the node keys follow the costs, aligned for any structure the caller may be using as a node
+    const size_t align = sizeof(long double);
+    const size_t offset = sizeof(struct __ASPath) + (count * sizeof(float));
+    return (offset + align - 1) / align * align;
 }
 
-static void *NeighborListGetNodeKey(ASNeighborList list, size_t index)
+
+static inline float GetGoalsHeuristic(Node n, const Node *goals, size_t goalCount)
+{
+    // the closest goal is admissible for all of them, so a search towards several goals uses the minimum
+    float estimate = (goalCount > 0)? GetPathCostHeuristic(n, goals[0]) : 0;
+
+    for (size_t i=1; i<goalCount; i++) {
+        const float goalEstimate = GetPathCostHeuristic(n, goals[i]);
+        if (goalEstimate < estimate) {
+            estimate = goalEstimate;
+        }
+    }
+
+    return estimate;
+}
+
+static inline void ExpandNode(ASNeighborList neighborList, Node current, Node prev_node, const Node *goals, size_t goalCount)
+{
+    VisitedNodes visitedNodes = current.nodes;
+
+    RemoveNodeFromOpenSet(current);
+    AddNodeToClosedSet(current);
+    visitedNodes->stats.expanded++;
+    TraceSearchEvent(visitedNodes, ASTraceExpand, GetNodeKey(current), GetNodeCost(current));
+    
+    // search neighbors
+    neighborList->count = 0;
+
+    visitedNodes->source->nodeNeighbors(neighborList, GetNodeKey(current), GetNodeCost(current), GetNodeKey(prev_node), visitedNodes->context);
+    
+    visitedNodes->stats.generated += neighborList->count;
+
+    // iterate all neighbors
+    for (size_t n=0; n<neighborList->count; n++) {
+        const float cost = GetNodeCost(current) + NeighborListGetEdgeCost(neighborList, n);
+        Node neighbor = GetNode(visitedNodes, NeighborListGetNodeKey(neighborList, n));
+        if (NodeIsNull(neighbor)) {
+            // out of memory, the search stops after this node
+            break;
+        }
+        
+        if (!NodeHasEstimatedCost(neighbor)) {
+            SetNodeEstimatedCost(neighbor, GetGoalsHeuristic(neighbor, goals, goalCount));
+        }
+        
+        if (NodeIsInOpenSet(neighbor) && cost < GetNodeCost(neighbor)) {
+            RemoveNodeFromOpenSet(neighbor);
+        }
+        
+        if (NodeIsInClosedSet(neighbor) && cost < GetNodeCost(neighbor)) {
+            RemoveNodeFromClosedSet(neighbor);
+            visitedNodes->stats.reopened++;
+            TraceSearchEvent(visitedNodes, ASTraceReopen, GetNodeKey(neighbor), cost);
+        }
+        
+        if (!NodeIsInOpenSet(neighbor) && !NodeIsInClosedSet(neighbor)) {
+            AddNodeToOpenSet(neighbor, cost, current);
+        }
+    }
+}
+
+static ASPath PathCreateToNode(Node node)
 {
-    return list->nodeKeys + (index * list->source->nodeSize);
+    // with nodeID set the path keeps a 4 byte id per node instead of a copy of the node
+    const ASPathNodeSource *source = node.nodes->source;
+    const size_t nodeSize = source->nodeID? sizeof(uint32_t) : source->nodeSize;
+    size_t count = 0;
+    Node n = node;
+    
+    while (!NodeIsNull(n)) {
+        count++;
+        n = GetParentNode(n);
+    }
+    
+    ASPath path = ASPathAlloc(nodeSize, count);
+    if (!path) {
+        node.nodes->memory->exceeded = 1;
+        return NULL;
+    }
+    
+    n = node;
+    for (size_t i=count; i>0; i--) {
+        path->costs[i-1] = GetNodeCost(n);
+        if (source->nodeID) {
+            ((uint32_t *)path->nodeKeys)[i-1] = source->nodeID(GetNodeKey(n), node.nodes->context);
+        } else {
+            memcpy(path->nodeKeys + ((i - 1) * nodeSize), GetNodeKey(n), nodeSize);
+        }
+        n = GetParentNode(n);
+    }
+
+    return path;
+}
+
+static inline int BeginDensePathOutput(DensePathOutput *output, size_t count, SearchMemory *memory)
+{
+    // returns whether the path is to be written -- a caller's buffer that is too small only gets the count, like snprintf()
+    output->count = count;
+
+    if (!output->nodes) {
+        output->path = ASPathAlloc(sizeof(uint32_t), count);
+        if (!output->path) {
+            output->count = 0;
+            memory->exceeded = 1;
+            return 0;
+        }
+        output->nodes = output->path->nodeKeys;
+        output->costs = output->path->costs;
+        return 1;
+    }
+
+    return count <= output->capacity;
+}
+
+static void WritePathToDenseNode(DenseNodes nodes, uint32_t node, DensePathOutput *output)
+{
+    size_t count = 0;
+    
+    for (uint32_t n = node; n != ASNodeIDNull; n = nodes->records[n].parent) {
+        count++;
+    }
+    
+    if (!BeginDensePathOutput(output, count, nodes->memory)) {
+        return;
+    }
+    
+    uint32_t n = node;
+    for (size_t i=count; i>0; i--) {
+        if (output->costs) {
+            output->costs[i-1] = nodes->records[n].cost;
+        }
+        output->nodes[i-1] = n;
+        n = nodes->records[n].parent;
+    }
+}
+
+static ASPath PathCreateToDenseNode(DenseNodes nodes, uint32_t node)
+{
+    DensePathOutput output = {NULL};
+    WritePathToDenseNode(nodes, node, &output);
+    return output.path;
+}
+
+static void WritePathThroughDenseNode(DenseNodes forward, DenseNodes backward, uint32_t node, DensePathOutput *output)
+{
+    // the forward half's path to node followed by the backward half's path from node to its goal
+    size_t forwardCount = 0;
+    size_t backwardCount = 0;
+
+    for (uint32_t n = node; n != ASNodeIDNull; n = forward->records[n].parent) {
+        forwardCount++;
+    }
+    for (uint32_t n = backward->records[node].parent; n != ASNodeIDNull; n = backward->records[n].parent) {
+        backwardCount++;
+    }
+
+    if (!BeginDensePathOutput(output, forwardCount + backwardCount, forward->memory)) {
+        return;
+    }
+
+    const float cost = forward->records[node].cost + backward->records[node].cost;
+
+    uint32_t n = node;
+    for (size_t i=forwardCount; i>0; i--) {
+        if (output->costs) {
+            output->costs[i-1] = forward->records[n].cost;
+        }
+        output->nodes[i-1] = n;
+        n = forward->records[n].parent;
+    }
+
+    n = backward->records[node].parent;
+    for (size_t i=forwardCount; i<forwardCount + backwardCount; i++) {
+        if (output->costs) {
+            output->costs[i] = cost - backward->records[n].cost;
+        }
+        output->nodes[i] = n;
+        n = backward->records[n].parent;
+    }
 }
 
 /********************************************/
@@ -399,28 +735,283 @@ static void *NeighborListGetNodeKey(ASNeighborList list, size_t index)
 void ASNeighborListAdd(ASNeighborList list, void *node, float edgeCost)
 {
     if (list->count == list->capacity) {
-        list->capacity = 1 + (list->capacity * 2);
-        list->costs = realloc(list->costs, sizeof(float) * list->capacity);
-        list->nodeKeys = realloc(list->nodeKeys, list->source->nodeSize * list->capacity);
+        // a neighbor that does not fit is dropped, a search through a workspace then stops as out of memory
+        SearchMemory unlimited = {0};
+        SearchMemory *memory = list->memory? list->memory : &unlimited;
+        const size_t capacity = GrowSearchCapacity(memory, list->capacity, list->count + 1, sizeof(float) + list->nodeSize);
+        // both buffers are counted together and given back together, so used always matches capacity
+        const size_t grownBytes = (sizeof(float) + list->nodeSize) * (capacity - list->capacity);
+        if (!capacity || !TakeSearchMemory(memory, grownBytes)) {
+            return;
+        }
+
+        // both new buffers are allocated before either old one is let go, so a failure leaves the list as it was
+        float *costs = malloc(sizeof(float) * capacity);
+        void *nodeKeys = malloc(list->nodeSize * capacity);
+        if (!costs || !nodeKeys) {
+            free(costs);
+            free(nodeKeys);
+            memory->used -= grownBytes;
+            memory->exceeded = 1;
+            return;
+        }
+        if (list->count > 0) {
+            memcpy(costs, list->costs, sizeof(float) * list->count);
+            memcpy(nodeKeys, list->nodeKeys, list->nodeSize * list->count);
+        }
+        free(list->costs);
+        free(list->nodeKeys);
+        list->costs = costs;
+        list->nodeKeys = nodeKeys;
+        list->capacity = capacity;
     }
     list->costs[list->count] = edgeCost;
-    memcpy(list->nodeKeys + (list->count * list->source->nodeSize), node, list->source->nodeSize);
+    memcpy(list->nodeKeys + (list->count * list->nodeSize), node, list->nodeSize);
     list->count++;
 }
 
+void ASNeighborListAddID(ASNeighborList list, uint32_t node, float edgeCost)
+{
+    ASNeighborListAdd(list, &node, edgeCost);
+}
+
+ASSearchWorkspace ASSearchWorkspaceCreate(void)
+{
+    ASSearchWorkspace workspace = calloc(1, sizeof(struct __ASSearchWorkspace));
+
+    if (workspace) {
+        workspace->visitedNodes.memory = &workspace->memory;
+        workspace->denseNodes.memory = &workspace->memory;
+        workspace->reverseDenseNodes.memory = &workspace->memory;
+        workspace->neighborList.memory = &workspace->memory;
+    }
+
+    return workspace;
+}
+
+static void ReleaseDenseNodes(DenseNodes nodes)
+{
+    DenseNodesFree(nodes);
+    nodes->records = NULL;
+    nodes->recordsCapacity = 0;
+    nodes->openNodes = NULL;
+    nodes->openNodesCapacity = 0;
+    nodes->openNodesCount = 0;
+    nodes->openEntries.entries = NULL;
+    nodes->openEntries.capacity = 0;
+    nodes->openEntries.count = 0;
+    nodes->buckets = NULL;
+    nodes->bucketsCapacity = 0;
+    nodes->bucketsUsed = 0;
+    nodes->bucketsFirst = 0;
+    nodes->bucketEntries = NULL;
+    nodes->bucketEntriesCapacity = 0;
+    nodes->bucketEntriesCount = 0;
+}
+
+static void ReleaseWorkspaceBuffers(ASSearchWorkspace workspace)
+{
+    // frees every scratch buffer, the next search allocates them again
+    VisitedNodes visitedNodes = &workspace->visitedNodes;
+    VisitedNodesFree(visitedNodes);
+    visitedNodes->nodeRecords = NULL;
+    visitedNodes->nodeRecordsSize = 0;
+    visitedNodes->nodeRecordsCapacity = 0;
+    visitedNodes->nodeRecordsCount = 0;
+    visitedNodes->nodeRecordsIndex = NULL;
+    visitedNodes->nodeRecordsIndexCapacity = 0;
+    visitedNodes->indexSlots = NULL;
+    visitedNodes->indexSlotsCapacity = 0;
+    visitedNodes->openNodes = NULL;
+    visitedNodes->openNodesCapacity = 0;
+    visitedNodes->openNodesCount = 0;
+    visitedNodes->openEntries.entries = NULL;
+    visitedNodes->openEntries.capacity = 0;
+    visitedNodes->openEntries.count = 0;
+
+    ReleaseDenseNodes(&workspace->denseNodes);
+    ReleaseDenseNodes(&workspace->reverseDenseNodes);
+
+    NeighborListFree(&workspace->neighborList);
+    workspace->neighborList.costs = NULL;
+    workspace->neighborList.nodeKeys = NULL;
+    workspace->neighborList.capacity = 0;
+    workspace->neighborList.count = 0;
+
+    free(workspace->goalNodes);
+    workspace->goalNodes = NULL;
+    workspace->goalNodesCapacity = 0;
+
+    workspace->memory.used = 0;
+}
+
+void ASSearchWorkspaceReset(ASSearchWorkspace workspace)
+{
+    if (workspace) {
+        workspace->visitedNodes.nodeRecordsCount = 0;
+        workspace->visitedNodes.openNodesCount = 0;
+        workspace->visitedNodes.openEntries.count = 0;
+        workspace->denseNodes.visitedCount = 0;
+        workspace->denseNodes.openNodesCount = 0;
+        workspace->denseNodes.openEntries.count = 0;
+        ClearDenseBuckets(&workspace->denseNodes);
+        workspace->reverseDenseNodes.visitedCount = 0;
+        workspace->reverseDenseNodes.openNodesCount = 0;
+        workspace->reverseDenseNodes.openEntries.count = 0;
+        ClearDenseBuckets(&workspace->reverseDenseNodes);
+        workspace->neighborList.count = 0;
+    }
+}
+
+void ASSearchWorkspaceSetOptions(ASSearchWorkspace workspace, const ASSearchOptions *options)
+{
+    if (workspace) {
+        if (options) {
+            workspace->options = *options;
+        } else {
+            memset(&workspace->options, 0, sizeof(ASSearchOptions));
+        }
+
+        workspace->memory.limit = workspace->options.memoryLimit;
+        if (workspace->memory.limit && workspace->memory.used > workspace->memory.limit) {
+            ReleaseWorkspaceBuffers(workspace);
+        }
+    }
+}
+
+size_t ASSearchWorkspaceGetVisitedCount(ASSearchWorkspace workspace)
+{
+    return workspace? workspace->visitedCount : 0;
+}
+
+ASSearchStatus ASSearchWorkspaceGetStatus(ASSearchWorkspace workspace)
+{
+    return workspace? workspace->status : ASSearchCompleted;
+}
+
+size_t ASSearchWorkspaceGetMemorySize(ASSearchWorkspace workspace)
+{
+    return workspace? workspace->memory.used : 0;
+}
+
+#ifdef ASTAR_TRACE
+void ASSearchWorkspaceSetTraceCallback(ASSearchWorkspace workspace, ASTraceCallback callback, void *context)
+{
+    if (workspace) {
+        workspace->visitedNodes.traceCallback = callback;
+        workspace->visitedNodes.traceContext = context;
+        workspace->denseNodes.traceCallback = callback;
+        workspace->denseNodes.traceContext = context;
+        workspace->reverseDenseNodes.traceCallback = callback;
+        workspace->reverseDenseNodes.traceContext = context;
+    }
+}
+#endif
+
+void ASSearchWorkspaceDestroy(ASSearchWorkspace workspace)
+{
+    if (workspace) {
+        VisitedNodesFree(&workspace->visitedNodes);
+        DenseNodesFree(&workspace->denseNodes);
+        DenseNodesFree(&workspace->reverseDenseNodes);
+        NeighborListFree(&workspace->neighborList);
+        free(workspace->goalNodes);
+        free(workspace);
+    }
+}
+
+static inline double GetSearchClock(ASSearchWorkspace workspace)
+{
+    // the clock is only read for callers that asked for statistics
+    if (!workspace->options.stats) {
+        return 0;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+double BeginSearch(ASSearchWorkspace workspace)
+{
+    workspace->memory.exceeded = 0;
+    return GetSearchClock(workspace);
+}
+
+static void FinishSearch(ASSearchWorkspace workspace, double begin)
+{
+    VisitedNodes nodes = &workspace->visitedNodes;
+    workspace->visitedCount = nodes->nodeRecordsCount;
+    workspace->status = workspace->memory.exceeded? ASSearchOutOfMemory : ASSearchCompleted;
+
+    if (workspace->options.stats) {
+        ASSearchStats *stats = workspace->options.stats;
+        *stats = nodes->stats;
+        stats->peakRecordBytes = nodes->nodeRecordsCount * NodeRecordSize(nodes->source);
+        stats->peakRecordBytes += nodes->source->nodeHash? nodes->indexSlotsCapacity * sizeof(IndexSlot) : nodes->nodeRecordsCount * sizeof(size_t);
+        stats->seconds = GetSearchClock(workspace) - begin;
+    }
+}
+
+void FinishDenseSearch(ASSearchWorkspace workspace, double begin, DenseNodes forward, DenseNodes backward)
+{
+    // backward is the other half of a bidirectional search or NULL, the stats are the sum of both halves
+    workspace->visitedCount = forward->visitedCount + (backward? backward->visitedCount : 0);
+    workspace->status = workspace->memory.exceeded? ASSearchOutOfMemory : ASSearchCompleted;
+
+    if (workspace->options.stats) {
+        ASSearchStats *stats = workspace->options.stats;
+        *stats = forward->stats;
+        stats->peakRecordBytes = forward->nodeCount * sizeof(DenseRecord);
+
+        if (backward) {
+            stats->expanded += backward->stats.expanded;
+            stats->generated += backward->stats.generated;
+            stats->reopened += backward->stats.reopened;
+            stats->pushes += backward->stats.pushes;
+            stats->pops += backward->stats.pops;
+            stats->peakOpenCount += backward->stats.peakOpenCount;
+            stats->peakRecordBytes += backward->nodeCount * sizeof(DenseRecord);
+        }
+        stats->seconds = GetSearchClock(workspace) - begin;
+    }
+}
+
 ASPath ASPathCreate(const ASPathNodeSource *source, void *context, void *startNodeKey, void *goalNodeKey)
 {
     if (!startNodeKey || !source || !source->nodeNeighbors || source->nodeSize == 0) {
         return NULL;
     }
+
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    ASPath path = ASPathCreateWithWorkspace(workspace, source, context, startNodeKey, goalNodeKey);
+    ASSearchWorkspaceDestroy(workspace);
+
+    return path;
+}
+
+ASPath ASPathCreateWithWorkspace(ASSearchWorkspace workspace, const ASPathNodeSource *source, void *context, void *startNodeKey, void *goalNodeKey)
+{
+    if (!workspace || !startNodeKey || !source || !source->nodeNeighbors || source->nodeSize == 0) {
+        return NULL;
+    }
     
-    VisitedNodes visitedNodes = VisitedNodesCreate(source, context);
-    ASNeighborList neighborList = NeighborListCreate(source);
+    const double begin = BeginSearch(workspace);
+    VisitedNodes visitedNodes = &workspace->visitedNodes;
+    ASNeighborList neighborList = &workspace->neighborList;
+    VisitedNodesBind(visitedNodes, source, context, &workspace->options);
+    NeighborListBind(neighborList, source->nodeSize);
     Node current = GetNode(visitedNodes, startNodeKey);
     Node prev_node = NodeNull;
     Node goalNode = GetNode(visitedNodes, goalNodeKey);
     ASPath path = NULL;
 
+    // with a tight memory limit there may not even be room for the start and goal
+    if (NodeIsNull(current) || (goalNodeKey && NodeIsNull(goalNode))) {
+        FinishSearch(workspace, begin);
+        return NULL;
+    }
+
     // mark the goal node as the goal
     SetNodeIsGoal(goalNode);
     
@@ -431,7 +1022,7 @@ ASPath ASPathCreate(const ASPathNodeSource *source, void *context, void *startNo
     
     // perform the A* algorithm
     prev_node = current;
-    while (HasOpenNode(visitedNodes) && !NodeIsGoal((current = GetOpenNode(visitedNodes)))) {
+    while (!workspace->memory.exceeded && HasOpenNode(visitedNodes) && !NodeIsGoal((current = GetOpenNode(visitedNodes)))) {
         if (source->earlyExit) {
             const int shouldExit = source->earlyExit(visitedNodes->nodeRecordsCount, GetNodeKey(current), goalNodeKey, context);
 
@@ -443,96 +1034,484 @@ ASPath ASPathCreate(const ASPathNodeSource *source, void *context, void *startNo
             }
         }
 
-        RemoveNodeFromOpenSet(current);
-        AddNodeToClosedSet(current);
-        
-        // search neighbors
-        neighborList->count = 0;
+        ExpandNode(neighborList, current, prev_node, &goalNode, 1);
+        prev_node = current;
+    }
+    
+    if (NodeIsNull(goalNode)) {
+        SetNodeIsGoal(current);
+    }
+    
+    if (NodeIsGoal(current) && !workspace->memory.exceeded) {
+        path = PathCreateToNode(current);
+    }
+    
+    FinishSearch(workspace, begin);
 
-        source->nodeNeighbors(neighborList, GetNodeKey(current), GetNodeCost(current), GetNodeKey(prev_node), context);
-        
-        // iterate all neighbors
-        for (size_t n=0; n<neighborList->count; n++) {
-            const float cost = GetNodeCost(current) + NeighborListGetEdgeCost(neighborList, n);
-            Node neighbor = GetNode(visitedNodes, NeighborListGetNodeKey(neighborList, n));
-            
-            if (!NodeHasEstimatedCost(neighbor)) {
-                SetNodeEstimatedCost(neighbor, GetPathCostHeuristic(neighbor, goalNode));
-            }
-            
-            if (NodeIsInOpenSet(neighbor) && cost < GetNodeCost(neighbor)) {
-                RemoveNodeFromOpenSet(neighbor);
+    return path;
+}
+
+size_t ASPathCreateMulti(ASSearchWorkspace workspace, const ASPathNodeSource *source, void *context, void *startNodeKey, void *const *goalNodeKeys, size_t goalCount, ASPath *paths, float *costs)
+{
+    if (!workspace || !startNodeKey || !source || !source->nodeNeighbors || source->nodeSize == 0 || (goalCount > 0 && !goalNodeKeys)) {
+        return 0;
+    }
+
+    const double begin = BeginSearch(workspace);
+    VisitedNodes visitedNodes = &workspace->visitedNodes;
+    ASNeighborList neighborList = &workspace->neighborList;
+    VisitedNodesBind(visitedNodes, source, context, &workspace->options);
+    NeighborListBind(neighborList, source->nodeSize);
+    Node current = GetNode(visitedNodes, startNodeKey);
+    Node prev_node = current;
+    size_t goalsLeft = 0;
+    size_t goalsFound = 0;
+
+    if (workspace->goalNodesCapacity < goalCount) {
+        Node *goalNodes = ResizeSearchBuffer(&workspace->memory, workspace->goalNodes, workspace->goalNodesCapacity * sizeof(Node), goalCount * sizeof(Node));
+        if (!goalNodes) {
+            for (size_t i=0; i<goalCount; i++) {
+                if (paths) {
+                    paths[i] = NULL;
+                }
+                if (costs) {
+                    costs[i] = INFINITY;
+                }
             }
-            
-            if (NodeIsInClosedSet(neighbor) && cost < GetNodeCost(neighbor)) {
-                RemoveNodeFromClosedSet(neighbor);
+            FinishSearch(workspace, begin);
+            return 0;
+        }
+        workspace->goalNodes = goalNodes;
+        workspace->goalNodesCapacity = goalCount;
+    }
+
+    // the goals are marked until they are settled, listing a goal twice only counts it once
+    for (size_t i=0; i<goalCount; i++) {
+        workspace->goalNodes[i] = GetNode(visitedNodes, goalNodeKeys[i]);
+        if (!NodeIsNull(workspace->goalNodes[i]) && !NodeIsGoal(workspace->goalNodes[i])) {
+            SetNodeIsGoal(workspace->goalNodes[i]);
+            goalsLeft++;
+        }
+    }
+
+    if (!NodeIsNull(current)) {
+        SetNodeEstimatedCost(current, GetGoalsHeuristic(current, workspace->goalNodes, goalCount));
+        AddNodeToOpenSet(current, 0, NodeNull);
+    }
+
+    // one A* search towards the closest remaining goal, settled goals keep their path in the shared search tree
+    // running out of memory ends it early, the goals settled until then keep their paths
+    while (goalsLeft > 0 && !workspace->memory.exceeded && HasOpenNode(visitedNodes)) {
+        current = GetOpenNode(visitedNodes);
+
+        if (NodeIsGoal(current)) {
+            NodeGetRecord(current)->isGoal = 0;
+            if (--goalsLeft == 0) {
+                break;
             }
-            
-            if (!NodeIsInOpenSet(neighbor) && !NodeIsInClosedSet(neighbor)) {
-                AddNodeToOpenSet(neighbor, cost, current);
+        }
+
+        if (source->earlyExit && source->earlyExit(visitedNodes->nodeRecordsCount, GetNodeKey(current), NULL, context) != 0) {
+            break;
+        }
+
+        ExpandNode(neighborList, current, prev_node, workspace->goalNodes, goalCount);
+        prev_node = current;
+    }
+
+    for (size_t i=0; i<goalCount; i++) {
+        const Node goal = workspace->goalNodes[i];
+        const int found = !NodeIsNull(goal) && !NodeIsGoal(goal);
+
+        if (paths) {
+            paths[i] = found? PathCreateToNode(goal) : NULL;
+        }
+        if (costs) {
+            costs[i] = found? GetNodeCost(goal) : INFINITY;
+        }
+        goalsFound += found;
+    }
+
+    FinishSearch(workspace, begin);
+
+    return goalsFound;
+}
+
+static void DenseSearch(ASSearchWorkspace workspace, const ASPathNodeIDSource *source, const struct __ASGraph *graph, void *context, uint32_t startNode, uint32_t goalNode, DensePathOutput *output)
+{
+    const double begin = BeginSearch(workspace);
+    DenseNodes nodes = &workspace->denseNodes;
+    ASNeighborList neighborList = &workspace->neighborList;
+    uint32_t current = startNode;
+    uint32_t prev_node = startNode;
+    int foundGoal = 0;
+
+    if (!DenseNodesBind(nodes, source, graph, context, &workspace->options)) {
+        FinishDenseSearch(workspace, begin, nodes, NULL);
+        return;
+    }
+    NeighborListBind(neighborList, sizeof(uint32_t));
+
+    // the goal gets its record up front so visitedCount matches ASPathCreate()
+    GetDenseRecord(nodes, startNode);
+    if (goalNode != ASNodeIDNull) {
+        GetDenseRecord(nodes, goalNode);
+        nodes->goals = &goalNode;
+        nodes->goalCount = 1;
+    }
+
+    // set the starting node's estimate cost to the goal and add it to the open set
+    nodes->records[startNode].estimatedCost = GetDenseGoalsHeuristic(nodes, startNode);
+    nodes->records[startNode].flags |= DenseRecordHasEstimatedCost;
+    AddDenseNodeToOpenSet(nodes, startNode, 0, ASNodeIDNull);
+
+    // perform the A* algorithm
+    while (!workspace->memory.exceeded && HasDenseOpenNode(nodes)) {
+        current = GetDenseOpenNode(nodes);
+
+        if (current == goalNode) {
+            foundGoal = 1;
+            break;
+        }
+
+        if (source && source->earlyExit) {
+            const int shouldExit = source->earlyExit(nodes->visitedCount, current, goalNode, context);
+
+            if (shouldExit > 0) {
+                foundGoal = 1;
+                break;
+            } else if (shouldExit < 0) {
+                break;
             }
         }
 
+        ExpandDenseNode(nodes, neighborList, current, prev_node);
         prev_node = current;
     }
-    
-    if (NodeIsNull(goalNode)) {
-        SetNodeIsGoal(current);
+
+    if (goalNode == ASNodeIDNull && !workspace->memory.exceeded) {
+        foundGoal = 1;
     }
-    
-    if (NodeIsGoal(current)) {
-        size_t count = 0;
-        Node n = current;
-        
-        while (!NodeIsNull(n)) {
-            count++;
-            n = GetParentNode(n);
+
+    if (foundGoal) {
+        WritePathToDenseNode(nodes, current, output);
+    }
+
+    FinishDenseSearch(workspace, begin, nodes, NULL);
+    nodes->goals = NULL;
+    nodes->goalCount = 0;
+}
+
+static void DenseSearchBidirectional(ASSearchWorkspace workspace, const ASPathNodeIDSource *source, const struct __ASGraph *graph, void *context, uint32_t startNode, uint32_t goalNode, DensePathOutput *output)
+{
+    const double begin = BeginSearch(workspace);
+    DenseNodes forward = &workspace->denseNodes;
+    DenseNodes backward = &workspace->reverseDenseNodes;
+    ASNeighborList neighborList = &workspace->neighborList;
+    const int forwardPrepared = DenseNodesBind(forward, source, graph, context, &workspace->options);
+    const int backwardPrepared = DenseNodesBind(backward, source, graph, context, &workspace->options);
+    uint32_t prevForward = startNode;
+    uint32_t prevBackward = goalNode;
+    int failed = 0;
+
+    if (!forwardPrepared || !backwardPrepared) {
+        FinishDenseSearch(workspace, begin, forward, backward);
+        return;
+    }
+    NeighborListBind(neighborList, sizeof(uint32_t));
+
+    const float offset = DenseNodesHaveHeuristic(forward)? GetDenseHeuristic(forward, startNode, goalNode) / 2 : 0;
+    DenseNodes halves[2] = {forward, backward};
+    for (int i=0; i<2; i++) {
+        halves[i]->balancedStart = startNode;
+        halves[i]->balancedGoal = goalNode;
+        halves[i]->balancedOffset = offset;
+        halves[i]->opposite = halves[1 - i];
+        halves[i]->meetCost = INFINITY;
+        halves[i]->meetNode = ASNodeIDNull;
+    }
+    backward->reverse = 1;
+
+    GetDenseRecord(forward, startNode);
+    forward->records[startNode].estimatedCost = GetDenseEstimatedCost(forward, startNode);
+    forward->records[startNode].flags |= DenseRecordHasEstimatedCost;
+    AddDenseNodeToOpenSet(forward, startNode, 0, ASNodeIDNull);
+
+    GetDenseRecord(backward, goalNode);
+    backward->records[goalNode].estimatedCost = GetDenseEstimatedCost(backward, goalNode);
+    backward->records[goalNode].flags |= DenseRecordHasEstimatedCost;
+    AddDenseNodeToOpenSet(backward, goalNode, 0, ASNodeIDNull);
+
+    while (!workspace->memory.exceeded && HasDenseOpenNode(forward) && HasDenseOpenNode(backward)) {
+        const uint32_t forwardNode = GetDenseOpenNode(forward);
+        const uint32_t backwardNode = GetDenseOpenNode(backward);
+        const float forwardRank = GetDenseRank(forward, forwardNode);
+        const float backwardRank = GetDenseRank(backward, backwardNode);
+        const float meetCost = fminf(forward->meetCost, backward->meetCost);
+
+        // the ranks are reduced costs, a path through any node still open costs at least their sum plus twice the offset
+        if (forwardRank + backwardRank + 2 * offset >= meetCost) {
+            break;
         }
-        
-        path = malloc(sizeof(struct __ASPath));
-        //path = malloc(sizeof(struct __ASPath) + (count * (sizeof(float)+source->nodeSize)));
-        path->nodeSize = source->nodeSize;
-        path->count = count;
-        path->costs = malloc(count*sizeof(float));
-        path->nodeKeys = malloc(count*path->nodeSize);
-        
-        n = current;
-        for (size_t i=count; i>0; i--) {
-            path->costs[i-1] = GetNodeCost(n);
-            memcpy(path->nodeKeys + ((i - 1) * source->nodeSize), GetNodeKey(n), source->nodeSize);
-            n = GetParentNode(n);
+
+        // grow the half with the lower rank, which keeps both frontiers at about the same radius
+        const int expandForward = (forwardRank <= backwardRank);
+        const uint32_t current = expandForward? forwardNode : backwardNode;
+
+        if (source && source->earlyExit) {
+            const int shouldExit = source->earlyExit(forward->visitedCount + backward->visitedCount, current, goalNode, context);
+
+            if (shouldExit != 0) {
+                failed = (shouldExit < 0);
+                break;
+            }
+        }
+
+        if (expandForward) {
+            ExpandDenseNode(forward, neighborList, current, prevForward);
+            prevForward = current;
+        } else {
+            ExpandDenseNode(backward, neighborList, current, prevBackward);
+            prevBackward = current;
         }
     }
-    
-    NeighborListDestroy(neighborList);
-    VisitedNodesDestroy(visitedNodes);
 
+    const uint32_t meetNode = (forward->meetCost <= backward->meetCost)? forward->meetNode : backward->meetNode;
+    // the best meeting so far is not known to be the cheapest until the search ran its course
+    if (!failed && !workspace->memory.exceeded && meetNode != ASNodeIDNull) {
+        WritePathThroughDenseNode(forward, backward, meetNode, output);
+    }
+
+    FinishDenseSearch(workspace, begin, forward, backward);
+    forward->opposite = NULL;
+    backward->opposite = NULL;
+}
+
+static size_t DenseSearchMulti(ASSearchWorkspace workspace, const ASPathNodeIDSource *source, const struct __ASGraph *graph, void *context, uint32_t startNode, const uint32_t *goalNodes, size_t goalCount, ASPath *paths, float *costs)
+{
+    const double begin = BeginSearch(workspace);
+    DenseNodes nodes = &workspace->denseNodes;
+    ASNeighborList neighborList = &workspace->neighborList;
+    uint32_t current = startNode;
+    uint32_t prev_node = startNode;
+    size_t goalsLeft = 0;
+    size_t goalsFound = 0;
+
+    if (!DenseNodesBind(nodes, source, graph, context, &workspace->options)) {
+        for (size_t i=0; i<goalCount; i++) {
+            if (paths) {
+                paths[i] = NULL;
+            }
+            if (costs) {
+                costs[i] = INFINITY;
+            }
+        }
+        FinishDenseSearch(workspace, begin, nodes, NULL);
+        return 0;
+    }
+    NeighborListBind(neighborList, sizeof(uint32_t));
+
+    // the goals are marked until they are settled, listing a goal twice only counts it once
+    GetDenseRecord(nodes, startNode);
+    for (size_t i=0; i<goalCount; i++) {
+        if (goalNodes[i] < nodes->nodeCount) {
+            DenseRecord *record = GetDenseRecord(nodes, goalNodes[i]);
+            if (!(record->flags & DenseRecordGoal)) {
+                record->flags |= DenseRecordGoal;
+                goalsLeft++;
+            }
+        }
+    }
+    nodes->goals = goalNodes;
+    nodes->goalCount = goalCount;
+
+    nodes->records[startNode].estimatedCost = GetDenseGoalsHeuristic(nodes, startNode);
+    nodes->records[startNode].flags |= DenseRecordHasEstimatedCost;
+    AddDenseNodeToOpenSet(nodes, startNode, 0, ASNodeIDNull);
+
+    // one A* search towards the closest remaining goal, settled goals keep their path in the shared search tree
+    // running out of memory ends it early, the goals settled until then keep their paths
+    while (goalsLeft > 0 && !workspace->memory.exceeded && HasDenseOpenNode(nodes)) {
+        current = GetDenseOpenNode(nodes);
+
+        if (nodes->records[current].flags & DenseRecordGoal) {
+            nodes->records[current].flags &= ~DenseRecordGoal;
+            if (--goalsLeft == 0) {
+                break;
+            }
+        }
+
+        if (source && source->earlyExit && source->earlyExit(nodes->visitedCount, current, ASNodeIDNull, context) != 0) {
+            break;
+        }
+
+        ExpandDenseNode(nodes, neighborList, current, prev_node);
+        prev_node = current;
+    }
+
+    for (size_t i=0; i<goalCount; i++) {
+        const int found = goalNodes[i] < nodes->nodeCount && !(nodes->records[goalNodes[i]].flags & DenseRecordGoal);
+
+        if (paths) {
+            paths[i] = found? PathCreateToDenseNode(nodes, goalNodes[i]) : NULL;
+        }
+        if (costs) {
+            costs[i] = found? nodes->records[goalNodes[i]].cost : INFINITY;
+        }
+        goalsFound += found;
+    }
+
+    FinishDenseSearch(workspace, begin, nodes, NULL);
+    nodes->goals = NULL;
+    nodes->goalCount = 0;
+
+    return goalsFound;
+}
+
+static void DenseSearchPath(ASSearchWorkspace workspace, const ASPathNodeIDSource *source, const struct __ASGraph *graph, void *context, uint32_t startNode, uint32_t goalNode, DensePathOutput *output)
+{
+    if (workspace->options.bidirectional && goalNode != ASNodeIDNull && goalNode != startNode) {
+        DenseSearchBidirectional(workspace, source, graph, context, startNode, goalNode, output);
+    } else {
+        DenseSearch(workspace, source, graph, context, startNode, goalNode, output);
+    }
+}
+
+ASPath ASPathCreateWithNodeIDs(ASSearchWorkspace workspace, const ASPathNodeIDSource *source, void *context, uint32_t startNode, uint32_t goalNode)
+{
+    if (!workspace || !source || !source->nodeNeighbors || startNode >= source->nodeCount || (goalNode != ASNodeIDNull && goalNode >= source->nodeCount)) {
+        return NULL;
+    }
+
+    DensePathOutput output = {NULL};
+    DenseSearchPath(workspace, source, NULL, context, startNode, goalNode, &output);
+    return output.path;
+}
+
+size_t ASPathWriteWithNodeIDs(ASSearchWorkspace workspace, const ASPathNodeIDSource *source, void *context, uint32_t startNode, uint32_t goalNode, uint32_t *nodes, float *costs, size_t capacity)
+{
+    if (!workspace || !source || !source->nodeNeighbors || !nodes || startNode >= source->nodeCount || (goalNode != ASNodeIDNull && goalNode >= source->nodeCount)) {
+        return 0;
+    }
+
+    DensePathOutput output = {nodes, costs, capacity, 0, NULL};
+    DenseSearchPath(workspace, source, NULL, context, startNode, goalNode, &output);
+    return output.count;
+}
+
+size_t ASPathCreateMultiWithNodeIDs(ASSearchWorkspace workspace, const ASPathNodeIDSource *source, void *context, uint32_t startNode, const uint32_t *goalNodes, size_t goalCount, ASPath *paths, float *costs)
+{
+    if (!workspace || !source || !source->nodeNeighbors || startNode >= source->nodeCount || (goalCount > 0 && !goalNodes)) {
+        return 0;
+    }
+
+    return DenseSearchMulti(workspace, source, NULL, context, startNode, goalNodes, goalCount, paths, costs);
+}
+
+ASPath ASPathCreateWithGraph(ASSearchWorkspace workspace, ASGraph graph, uint32_t startNode, uint32_t goalNode)
+{
+    if (!workspace || !graph || startNode >= graph->nodeCount || (goalNode != ASNodeIDNull && goalNode >= graph->nodeCount)) {
+        return NULL;
+    }
+
+    DensePathOutput output = {NULL};
+    DenseSearchPath(workspace, NULL, graph, NULL, startNode, goalNode, &output);
+    return output.path;
+}
+
+size_t ASPathWriteWithGraph(ASSearchWorkspace workspace, ASGraph graph, uint32_t startNode, uint32_t goalNode, uint32_t *nodes, float *costs, size_t capacity)
+{
+    if (!workspace || !graph || !nodes || startNode >= graph->nodeCount || (goalNode != ASNodeIDNull && goalNode >= graph->nodeCount)) {
+        return 0;
+    }
+
+    DensePathOutput output = {nodes, costs, capacity, 0, NULL};
+    DenseSearchPath(workspace, NULL, graph, NULL, startNode, goalNode, &output);
+    return output.count;
+}
+
+size_t ASPathCreateMultiWithGraph(ASSearchWorkspace workspace, ASGraph graph, uint32_t startNode, const uint32_t *goalNodes, size_t goalCount, ASPath *paths, float *costs)
+{
+    if (!workspace || !graph || startNode >= graph->nodeCount || (goalCount > 0 && !goalNodes)) {
+        return 0;
+    }
+
+    return DenseSearchMulti(workspace, NULL, graph, NULL, startNode, goalNodes, goalCount, paths, costs);
+}
+
+void ASGraphComputeDistances(ASSearchWorkspace workspace, ASGraph graph, uint32_t origin, int reverse, float *distances)
+{
+    // a search without goals has no heuristic, so this is Dijkstra over the whole graph
+    DenseNodes nodes = &workspace->denseNodes;
+    ASNeighborList neighborList = &workspace->neighborList;
+    workspace->memory.exceeded = 0;
+
+    if (!DenseNodesBind(nodes, NULL, graph, NULL, &workspace->options)) {
+        for (uint32_t n=0; n<graph->nodeCount; n++) {
+            distances[n] = INFINITY;
+        }
+        return;
+    }
+    NeighborListBind(neighborList, sizeof(uint32_t));
+    nodes->reverse = reverse;
+
+    GetDenseRecord(nodes, origin);
+    nodes->records[origin].estimatedCost = 0;
+    nodes->records[origin].flags |= DenseRecordHasEstimatedCost;
+    AddDenseNodeToOpenSet(nodes, origin, 0, ASNodeIDNull);
+
+    while (!workspace->memory.exceeded && HasDenseOpenNode(nodes)) {
+        const uint32_t current = GetDenseOpenNode(nodes);
+        ExpandDenseNode(nodes, neighborList, current, current);
+    }
+
+    for (uint32_t n=0; n<graph->nodeCount; n++) {
+        const DenseRecord *record = &nodes->records[n];
+        distances[n] = (record->generation == nodes->generation && (record->flags & DenseRecordClosed))? record->cost : INFINITY;
+    }
+
+    nodes->reverse = 0;
+}
+
+ASPath ASPathAlloc(size_t nodeSize, size_t count)
+{
+    // the path header, costs and node keys share one allocation so a path costs a single malloc/free
+    ASPath path = malloc(PathKeysOffset(count) + (count * nodeSize));
+    if (!path) {
+        return NULL;
+    }
+    atomic_init(&path->refCount, 1);
+    path->nodeSize = nodeSize;
+    path->count = count;
+    path->costs = (float *)(path + 1);
+    path->nodeKeys = (int8_t *)path + PathKeysOffset(count);
     return path;
 }
 
+void SearchWorkspaceSetTieBreak(ASSearchWorkspace workspace, int higherCost)
+{
+    workspace->visitedNodes.tieBreakHigherCost = higherCost;
+}
+
+void SearchWorkspaceSetOutOfMemory(ASSearchWorkspace workspace)
+{
+    workspace->memory.exceeded = 1;
+    workspace->status = ASSearchOutOfMemory;
+}
+
 void ASPathDestroy(ASPath path)
 {
-    
-    if (path && path->costs) free(path->costs);
-    if (path && path->nodeKeys) free(path->nodeKeys);
-    free(path);
+    if (path && atomic_fetch_sub_explicit(&path->refCount, 1, memory_order_acq_rel) == 1) {
+        free(path);
+    }
 }
 
 ASPath ASPathCopy(ASPath path)
 {
     if (path) {
-        const size_t size = sizeof(struct __ASPath);
-        ASPath newPath = malloc(size);
-        memcpy(newPath, path, size);
-
-        newPath->costs = malloc(path->count*sizeof(float));
-        newPath->nodeKeys = malloc(path->count*path->nodeSize);
-        memcpy(newPath->costs, path->costs, path->count*sizeof(float));
-        memcpy(newPath->nodeKeys, path->nodeKeys, path->count*path->nodeSize);
-        return newPath;
-    } else {
-        return NULL;
+        atomic_fetch_add_explicit(&path->refCount, 1, memory_order_relaxed);
     }
+    return path;
 }
 
 float ASPathGetCost(ASPath path, size_t index)
@@ -549,3 +1528,8 @@ void *ASPathGetNode(ASPath path, size_t index)
 {
     return (path && index < path->count)? (path->nodeKeys + (index * path->nodeSize)) : NULL;
 }
+
+uint32_t ASPathGetNodeID(ASPath path, size_t index)
+{
+    return (path && index < path->count && path->nodeSize == sizeof(uint32_t))? ((uint32_t *)path->nodeKeys)[index] : ASNodeIDNull;
+}
@@ -31,9 +31,24 @@
 #define AStar_h
 
 #include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef struct __ASNeighborList *ASNeighborList;
 typedef struct __ASPath *ASPath;
+typedef struct __ASSearchWorkspace *ASSearchWorkspace;
+typedef struct __ASSearchPool *ASSearchPool;
+typedef struct __ASGraph *ASGraph;
+typedef struct __ASContractionHierarchy *ASContractionHierarchy;
+typedef struct __ASGrid *ASGrid;
+typedef struct __ASPlanner *ASPlanner;
+typedef struct __ASReservationTable *ASReservationTable;
+typedef struct __ASAnytimeSearch *ASAnytimeSearch;
+typedef struct __ASClusterHierarchy *ASClusterHierarchy;
+typedef struct __ASFirstMoveTable *ASFirstMoveTable;
 
 typedef struct {
     size_t  nodeSize;                                                                               // the size of the structure being used for the nodes - important since nodes are copied into the resulting path
@@ -41,22 +56,428 @@ typedef struct {
     float   (*pathCostHeuristic)(void *fromNode, void *toNode, void *context);                      // estimated cost to transition from the first node to the second node -- optional, uses 0 if not specified
     int     (*earlyExit)(size_t visitedCount, void *visitingNode, void *goalNode, void *context);   // early termination, return 1 for success, -1 for failure, 0 to continue searching -- optional
     int     (*nodeComparator)(void *node1, void *node2, void *context);                             // must return a sort order for the nodes (-1, 0, 1) -- optional, uses memcmp if not specified
+    size_t  (*nodeHash)(void *node, void *context);                                                 // must return the same hash for nodes that compare equal -- optional, enables a hash index for visited nodes instead of the sorted index
+    uint32_t (*nodeID)(void *node, void *context);                                                  // compact id of the node -- optional, paths store these ids instead of copies of the nodes if specified, read them with ASPathGetNodeID()
 } ASPathNodeSource;
 
+// node source for graphs whose nodes are dense ids in [0, nodeCount) -- the search state lives in arrays indexed by id, so nodes are never copied or compared
+typedef struct {
+    uint32_t nodeCount;                                                                                         // the number of nodes, every node id must be less than this
+    void    (*nodeNeighbors)(ASNeighborList neighbors, uint32_t node, float node_cost, uint32_t from_node, void *context);  // add node ids to the neighbor list with ASNeighborListAddID()
+    float   (*pathCostHeuristic)(uint32_t fromNode, uint32_t toNode, void *context);                            // estimated cost to transition from the first node to the second node -- optional, uses 0 if not specified
+    int     (*earlyExit)(size_t visitedCount, uint32_t visitingNode, uint32_t goalNode, void *context);         // early termination, return 1 for success, -1 for failure, 0 to continue searching -- optional
+    void    (*reverseNodeNeighbors)(ASNeighborList neighbors, uint32_t node, float node_cost, uint32_t from_node, void *context);   // add the nodes with an edge to this node and that edge's cost -- optional, bidirectional search uses nodeNeighbors if not specified, which is right for undirected graphs
+} ASPathNodeIDSource;
+
+// priority queues available for the open set
+typedef enum {
+    ASOpenSetBinaryHeap = 0,    // binary heap of nodes that reads the ranks from the node records -- the default
+    ASOpenSet4AryHeap,          // 4-ary heap of inline (rank, node id) pairs, decrease-key leaves the outdated pair behind to be skipped later
+    ASOpenSet8AryHeap,          // same as ASOpenSet4AryHeap with 8 children per heap node
+    ASOpenSetBucketQueue,       // buckets of width costQuantum with O(1) push and pop -- the path cost may exceed the optimum by less than costQuantum
+} ASOpenSet;
+
+// counts of the last search through a workspace, see ASSearchOptions
+typedef struct {
+    size_t expanded;            // nodes taken off the open set and expanded
+    size_t generated;           // edges looked at while expanding, i.e. neighbors reached
+    size_t reopened;            // closed nodes moved back to the open set because a cheaper path to them turned up
+    size_t pushes;              // entries added to the open set
+    size_t pops;                // entries taken off the open set, including the outdated entries the d-ary heaps and the bucket queue skip
+    size_t peakOpenCount;       // most entries in the open set at once (pushes - pops), the sum of both halves' peaks for a bidirectional search
+    size_t peakRecordBytes;     // memory of the node records the search used, for the id searches that is one record per node id (per half when bidirectional)
+    double seconds;             // wall time of the search, path creation included
+} ASSearchStats;
+
+// search options, a zero-initialized struct gives the defaults
+typedef struct {
+    ASOpenSet openSet;          // open set -- ASPathCreateWithWorkspace() and ASPathCreateMulti() use the binary heap in place of the bucket queue
+    float     costQuantum;      // cost resolution of ASOpenSetBucketQueue, which falls back to the binary heap if this is not positive -- keep the highest rank / costQuantum within a few million buckets
+    int       bidirectional;    // ASPathCreateWithNodeIDs() and ASPathCreateWithGraph() search from both ends and stop once no unexplored path can beat the best meeting, see below
+    ASSearchStats *stats;       // filled in by every search through the workspace -- optional, the clock is only read if set, ignored by the batch functions
+    size_t    memoryLimit;      // bytes the scratch buffers of the workspace may hold, 0 for no limit -- see ASSearchWorkspaceGetStatus()
+} ASSearchOptions;
+
+// how the last search through a workspace ended
+typedef enum {
+    ASSearchCompleted = 0,      // the search ran its course, with or without a path
+    ASSearchOutOfMemory,        // a buffer would have outgrown memoryLimit or could not be allocated, so the search stopped early
+} ASSearchStatus;
+
+// a bidirectional search is only optimal if pathCostHeuristic is consistent (never drops by more than the edge cost along an edge)
+// both halves rank nodes by the average of the estimate to the goal and the negated estimate from the start
+// earlyExit is called for the nodes of both halves, returning 1 gives the best path through a node reached by both so far, if any
+// searches without a goal and the multi-goal functions always run forward only
+
+// stands for "no node" wherever a node id is expected
+#define ASNodeIDNull UINT32_MAX
+
 // use in the nodeNeighbors callback to return neighbors
 void ASNeighborListAdd(ASNeighborList neighbors, void *node, float edgeCost);
 
+// use in the ASPathNodeIDSource nodeNeighbors callback to return neighbors
+void ASNeighborListAddID(ASNeighborList neighbors, uint32_t node, float edgeCost);
+
 // if goalNode is NULL, it searches the entire graph and returns the cheapest deepest path
 // context is optional and is simply passed through to the callback functions
 // startNode and nodeSource is required
 // as a path is created, the relevant nodes are copied into the path
 ASPath ASPathCreate(const ASPathNodeSource *nodeSource, void *context, void *startNode, void *goalNode);
 
+// a workspace holds the scratch buffers of a search (visited records, open set, neighbor list) between searches
+// the buffers stay at their high-water size, so once warmed up a search through a workspace does no allocations apart from the resulting path
+// a workspace may be reused with any node source but must only be used by one thread at a time -- use one workspace per thread
+ASSearchWorkspace ASSearchWorkspaceCreate(void);
+
+// clears the search state of the workspace without releasing its buffers -- ASPathCreateWithWorkspace() does this itself before every search
+void ASSearchWorkspaceReset(ASSearchWorkspace workspace);
+
+// sets the options used by the following searches through the workspace, NULL restores the defaults
+void ASSearchWorkspaceSetOptions(ASSearchWorkspace workspace, const ASSearchOptions *options);
+
+// fetches the number of nodes the last search through the workspace reached (both halves of a bidirectional search)
+size_t ASSearchWorkspaceGetVisitedCount(ASSearchWorkspace workspace);
+
+// fetches how the last search through the workspace ended -- a search that ran out of memory returns no path, though the
+// multi-goal searches keep the paths to the goals they settled before that
+// the limit covers the records, the open set, the hash index and the neighbor list, not the resulting paths
+// a dense id search needs a record for every node id before it starts, so its limit must be well above nodeCount * 24 bytes
+// lowering the limit below what the buffers already hold releases them
+ASSearchStatus ASSearchWorkspaceGetStatus(ASSearchWorkspace workspace);
+
+// fetches the bytes the scratch buffers of the workspace hold, kept at their high-water size between searches
+size_t ASSearchWorkspaceGetMemorySize(ASSearchWorkspace workspace);
+
+// releases the workspace and all of its buffers
+void ASSearchWorkspaceDestroy(ASSearchWorkspace workspace);
+
+#ifdef ASTAR_TRACE
+// tracing is compiled in with -DASTAR_TRACE (cmake -DASTAR_TRACE=ON), without it the hooks below do not exist and the searches carry no trace calls
+typedef enum {
+    ASTraceExpand,              // the node was taken off the open set and is being expanded
+    ASTraceOpen,                // the node was added to the open set with the given cost
+    ASTraceReopen,              // the node was closed and is opened again with a lower cost
+} ASTraceEvent;
+
+// node points to the node key, a uint32_t for the id searches -- it is only valid during the call
+typedef void (*ASTraceCallback)(ASTraceEvent event, const void *node, float cost, void *context);
+
+// calls callback for the events of every following search through the workspace, NULL stops tracing
+void ASSearchWorkspaceSetTraceCallback(ASSearchWorkspace workspace, ASTraceCallback callback, void *context);
+#endif
+
+// same as ASPathCreate() but uses the given workspace for all of its scratch memory
+ASPath ASPathCreateWithWorkspace(ASSearchWorkspace workspace, const ASPathNodeSource *nodeSource, void *context, void *startNode, void *goalNode);
+
+// same as ASPathCreateWithWorkspace() but for graphs of dense node ids, pass ASNodeIDNull as goalNode to search the entire graph
+// the resulting path holds node ids, fetch them with ASPathGetNodeID()
+ASPath ASPathCreateWithNodeIDs(ASSearchWorkspace workspace, const ASPathNodeIDSource *nodeSource, void *context, uint32_t startNode, uint32_t goalNode);
+
+// same as ASPathCreateWithNodeIDs() but writes the path into the caller's arrays instead of allocating an ASPath -- costs is optional
+// returns the number of nodes in the path or 0 if there is none, if that is more than capacity nothing is written and the call can be repeated with larger arrays
+size_t ASPathWriteWithNodeIDs(ASSearchWorkspace workspace, const ASPathNodeIDSource *nodeSource, void *context, uint32_t startNode, uint32_t goalNode, uint32_t *nodes, float *costs, size_t capacity);
+
+// searches from startNode towards all goalNodes at once and stops when every goal is settled, so the goals share one search tree
+// paths[i] receives the path to goalNodes[i] or NULL if it was not reached, costs[i] its cost or INFINITY -- both are optional
+// the heuristic is the minimum over all goals, which costs goalCount heuristic calls per visited node -- leave pathCostHeuristic NULL for large goal sets
+// returns the number of goals reached
+size_t ASPathCreateMulti(ASSearchWorkspace workspace, const ASPathNodeSource *nodeSource, void *context, void *startNode, void *const *goalNodes, size_t goalCount, ASPath *paths, float *costs);
+
+// same as ASPathCreateMulti() for graphs of dense node ids
+size_t ASPathCreateMultiWithNodeIDs(ASSearchWorkspace workspace, const ASPathNodeIDSource *nodeSource, void *context, uint32_t startNode, const uint32_t *goalNodes, size_t goalCount, ASPath *paths, float *costs);
+
+// a directed edge of an ASGraph
+typedef struct {
+    uint32_t from;
+    uint32_t to;
+    float    cost;
+} ASGraphEdge;
+
+// heuristics an ASGraph computes from its node positions
+typedef enum {
+    ASGraphHeuristicNone = 0,   // no heuristic, the search degrades to Dijkstra -- the default
+    ASGraphHeuristicEuclidean,  // straight line distance times the scale
+    ASGraphHeuristicManhattan,  // sum of the axis distances times the scale
+} ASGraphHeuristic;
+
+// a compiled graph keeps the edges of every node in compressed sparse rows with their costs precomputed
+// searches walk its arrays directly instead of calling nodeNeighbors, so build one for graphs whose edge costs do not change between searches
+// a graph is never modified by a search and may be shared by any number of threads
+ASGraph ASGraphCreateWithEdges(uint32_t nodeCount, const ASGraphEdge *edges, size_t edgeCount);
+
+// builds a graph by calling nodeNeighbors once for every node, with the node itself as from_node and 0 as node_cost
+// the edge costs must not depend on from_node or node_cost -- pathCostHeuristic and earlyExit are not used
+ASGraph ASGraphCreateWithNodeIDSource(const ASPathNodeIDSource *nodeSource, void *context);
+
+// copies the x, y position of every node (2 * nodeCount floats) and selects the heuristic computed from them
+// the scale converts distance into edge cost, keep the heuristic admissible by using the lowest cost per unit of distance -- NULL positions removes the heuristic
+void ASGraphSetPositions(ASGraph graph, const float *positions, ASGraphHeuristic heuristic, float heuristicScale);
+
+// writes the graph to a file that ASGraphOpenFile() can map, returns 0 on success or -1 if the file could not be written
+// the file holds the nodes, edges, positions and heuristic in the byte order of the writing machine
+int ASGraphWriteFile(ASGraph graph, const char *path);
+
+// maps a file written by ASGraphWriteFile() read-only and searches it in place, so opening takes the same time for any graph size
+// processes that open the same file share its pages -- returns NULL if the file is missing, truncated or of another version or byte order
+// the file is trusted, only its header and section bounds are checked
+ASGraph ASGraphOpenFile(const char *path);
+
+// builds the incoming edges of every node, so bidirectional searches can walk directed graphs backwards -- graphs without them are taken to be undirected
+// they are stored by ASGraphWriteFile()
+void ASGraphBuildReverseEdges(ASGraph graph);
+
+// picks up to landmarkCount landmarks by farthest point selection and stores the exact cost from and to each of them for every node
+// searches on the graph then also bound the remaining cost with the triangle inequality over all landmarks (the ALT heuristic), taking the larger of it and the position heuristic
+// costs 2 * landmarkCount Dijkstra searches over the graph and 2 * landmarkCount floats per node, the tables are stored by ASGraphWriteFile()
+// replaces any previous landmarks -- returns the number of landmarks placed, which is lower if fewer nodes are reachable
+uint32_t ASGraphBuildLandmarks(ASGraph graph, uint32_t landmarkCount);
+
+// fetches the number of landmarks of the graph
+uint32_t ASGraphGetLandmarkCount(ASGraph graph);
+
+// node orders for ASGraphReorder()
+typedef enum {
+    ASGraphOrderHilbert = 0,    // along a Hilbert curve through the positions, so nodes close in space get close ids -- needs positions
+    ASGraphOrderMorton,         // along a Z-order curve through the positions, cheaper to compute but with jumps between quadrants -- needs positions
+    ASGraphOrderBFS,            // breadth-first over the edges from node 0, then from the lowest node not reached yet
+    ASGraphOrderRCM,            // reverse Cuthill-McKee: breadth-first from a node of lowest degree in every component, neighbors by ascending degree, the result reversed
+} ASGraphOrder;
+
+// renumbers the nodes in the given order and rewrites the edges, positions, reverse edges and landmark tables to match
+// searches keep their records in arrays indexed by node id, so nodes that are expanded together then also share cache lines there
+// the graph keeps the id every node had before its first reordering, which ASGraphWriteFile() stores -- translate with the functions below
+// returns 0, or -1 if the order needs positions the graph does not have -- must not run while the graph is searched, and hierarchies
+// and tables built from the graph before keep the old ids, so reorder first
+int ASGraphReorder(ASGraph graph, ASGraphOrder order);
+
+// fetches the id the node had before the graph was first reordered -- node itself if it never was
+uint32_t ASGraphGetOriginalNodeID(ASGraph graph, uint32_t node);
+
+// fetches the current id of the node that had originalNode as its id before the graph was first reordered -- ASNodeIDNull if out of range
+uint32_t ASGraphGetNodeIDFromOriginal(ASGraph graph, uint32_t originalNode);
+
+// returns the built-in heuristic of the graph between two nodes -- also usable as the pathCostHeuristic of a callback source on the same nodes
+// it is a lower bound of the callback's costs if the graph's edge costs are lower bounds of them
+float ASGraphEstimateCost(ASGraph graph, uint32_t fromNode, uint32_t toNode);
+
+// fetches the number of nodes of the graph
+uint32_t ASGraphGetNodeCount(ASGraph graph);
+
+// fetches the number of edges of the graph
+size_t ASGraphGetEdgeCount(ASGraph graph);
+
+// releases the graph, or unmaps it if it was opened from a file
+void ASGraphDestroy(ASGraph graph);
+
+// same as ASPathCreateWithNodeIDs() but expands nodes straight from the compiled graph
+ASPath ASPathCreateWithGraph(ASSearchWorkspace workspace, ASGraph graph, uint32_t startNode, uint32_t goalNode);
+
+// same as ASPathWriteWithNodeIDs() for a compiled graph
+size_t ASPathWriteWithGraph(ASSearchWorkspace workspace, ASGraph graph, uint32_t startNode, uint32_t goalNode, uint32_t *nodes, float *costs, size_t capacity);
+
+// same as ASPathCreateMultiWithNodeIDs() but expands nodes straight from the compiled graph
+size_t ASPathCreateMultiWithGraph(ASSearchWorkspace workspace, ASGraph graph, uint32_t startNode, const uint32_t *goalNodes, size_t goalCount, ASPath *paths, float *costs);
+
+// contracts the nodes of the graph one by one, from least to most important, adding shortcut edges that keep the costs between the remaining nodes
+// the result answers queries with two small Dijkstra searches that only climb towards more important nodes -- preprocessing a 100k node grid takes tens of seconds
+// the hierarchy copies what it needs, so the graph may be destroyed afterwards -- positions, landmarks and edge changes made later are not picked up
+ASContractionHierarchy ASContractionHierarchyCreate(ASGraph graph);
+
+// fetches the number of shortcut edges added by the contraction
+size_t ASContractionHierarchyGetShortcutCount(ASContractionHierarchy hierarchy);
+
+// fetches the number of bytes held by the hierarchy
+size_t ASContractionHierarchyGetMemorySize(ASContractionHierarchy hierarchy);
+
+// releases the hierarchy
+void ASContractionHierarchyDestroy(ASContractionHierarchy hierarchy);
+
+// finds the cheapest path from startNode to goalNode in the hierarchy's graph and unpacks its shortcuts, so the path holds the nodes and costs of the original graph
+// the hierarchy is never modified by a search and may be shared by any number of threads, each with its own workspace
+ASPath ASPathCreateWithContractionHierarchy(ASSearchWorkspace workspace, ASContractionHierarchy hierarchy, uint32_t startNode, uint32_t goalNode);
+
+// a cluster hierarchy (HPA*) splits the nodes into clusters and keeps the cheapest costs between the entrances of every cluster
+// a query searches the graph of entrances first and then the steps between them, each inside one cluster -- far fewer nodes than a
+// search over the whole graph, for paths that may be a few percent longer than the optimum
+// clusters holds the cluster number of every node, numbered from 0 -- nodes close together should share a cluster, a few hundred to a few thousand nodes each
+// nodeNeighbors is called with the node itself as from_node and 0 as node_cost, reverseNodeNeighbors should be set for directed graphs
+// the hierarchy keeps a pointer to nodeSource, reads the edges of every node once and runs a search from every entrance
+ASClusterHierarchy ASClusterHierarchyCreate(const ASPathNodeIDSource *nodeSource, void *context, const uint32_t *clusters);
+
+// updates the costs of a cluster after its edges changed, nodeNeighbors must already return the new edges
+// the entrances stay where they are, so an edge to another cluster that was not there when the hierarchy was created is not used
+// must not run while the hierarchy is searched
+void ASClusterHierarchyUpdateCluster(ASClusterHierarchy hierarchy, uint32_t cluster);
+
+// fetches the number of entrances over all clusters
+uint32_t ASClusterHierarchyGetEntranceCount(ASClusterHierarchy hierarchy);
+
+// fetches the bytes the hierarchy holds
+size_t ASClusterHierarchyGetMemorySize(ASClusterHierarchy hierarchy);
+
+// releases the hierarchy
+void ASClusterHierarchyDestroy(ASClusterHierarchy hierarchy);
+
+// finds a path from startNode to goalNode through the entrances only: startNode, the entrances it passes and goalNode, each with the cost of the full path up to it
+// refine the steps with ASClusterHierarchyRefinePath() as they are needed, or use ASPathCreateWithClusterHierarchy() for all of them at once
+// the hierarchy is never modified by a search and may be shared by any number of threads, each with its own workspace
+ASPath ASClusterHierarchyCreateAbstractPath(ASSearchWorkspace workspace, ASClusterHierarchy hierarchy, uint32_t startNode, uint32_t goalNode);
+
+// finds the nodes between node index and index + 1 of a path from ASClusterHierarchyCreateAbstractPath(), both included, with the costs carried on from the path
+ASPath ASClusterHierarchyRefinePath(ASSearchWorkspace workspace, ASClusterHierarchy hierarchy, ASPath abstractPath, size_t index);
+
+// same as ASClusterHierarchyCreateAbstractPath() with every step refined, so the path holds the nodes of the graph
+ASPath ASPathCreateWithClusterHierarchy(ASSearchWorkspace workspace, ASClusterHierarchy hierarchy, uint32_t startNode, uint32_t goalNode);
+
+// a first-move table (compressed path database) holds, for every node of a compiled graph, the first edge of a cheapest path to every other node
+// the moves of each node are run-length compressed over the target ids, so graphs whose ids follow the map (row by row, say) compress best
+// it is built with one Dijkstra search per node, spread over the pool's workers -- a temporary pool of one thread per core if pool is NULL
+// meant for maps of up to some tens of thousands of nodes that are queried over and over, the build grows with the square of the node count
+// the table keeps a pointer to graph -- returns NULL for graphs of more than 2^24 nodes or with a node of more than 63 edges
+ASFirstMoveTable ASFirstMoveTableCreate(ASGraph graph, ASSearchPool pool);
+
+// fetches the number of runs over all nodes
+size_t ASFirstMoveTableGetRunCount(ASFirstMoveTable table);
+
+// fetches the bytes the table holds, the graph not included
+size_t ASFirstMoveTableGetMemorySize(ASFirstMoveTable table);
+
+// releases the table
+void ASFirstMoveTableDestroy(ASFirstMoveTable table);
+
+// fetches the node after node on a cheapest path to goalNode, goalNode if node is goalNode and ASNodeIDNull if there is no path
+uint32_t ASFirstMoveTableGetNextNode(ASFirstMoveTable table, uint32_t node, uint32_t goalNode);
+
+// follows the first moves from startNode to goalNode, a cheapest path without any search -- needs no workspace and may be called from any number of threads
+ASPath ASPathCreateWithFirstMoveTable(ASFirstMoveTable table, uint32_t startNode, uint32_t goalNode);
+
+// a planner keeps a D* Lite search tree from the goal between calls, so after edge costs change only the nodes whose cost to the goal changed are expanded again
+// nodeNeighbors is called with the node itself as from_node and 0 as node_cost, so the costs must not depend on them -- earlyExit is not used
+// reverseNodeNeighbors should be set for directed graphs, otherwise the edges are taken to be undirected
+// pathCostHeuristic must be consistent, fromNode is always the current start
+// the planner keeps a few floats per node of the source and must only be used by one thread at a time
+ASPlanner ASPlannerCreate(const ASPathNodeIDSource *nodeSource, void *context, uint32_t startNode, uint32_t goalNode);
+
+// moves the start, for example as the robot follows its path -- the tree stays valid because it is rooted at the goal
+void ASPlannerSetStart(ASPlanner planner, uint32_t startNode);
+
+// reports that the edge from fromNode to toNode changed its cost, appeared or disappeared -- nodeNeighbors must already return the new edges
+// call it for every changed edge before the next ASPlannerCreatePath(), a blocked node changes the edges into it and out of it
+void ASPlannerUpdateEdge(ASPlanner planner, uint32_t fromNode, uint32_t toNode);
+
+// repairs the search tree after the changes reported since the last call and returns the cheapest path from the start to the goal, or NULL if there is none
+ASPath ASPlannerCreatePath(ASPlanner planner);
+
+// fetches the number of nodes the last ASPlannerCreatePath() expanded
+size_t ASPlannerGetExpandedCount(ASPlanner planner);
+
+// releases the planner
+void ASPlannerDestroy(ASPlanner planner);
+
+// an anytime search (ARA*) returns a path within a known factor of the optimum early and keeps improving it while time is left
+// it runs weighted A* searches with a falling heuristic weight, each one reusing the costs and open set of the one before
+// pathCostHeuristic should be consistent for the bounds to hold, nodeNeighbors gets the node's parent as from_node -- earlyExit is not used
+// initialWeight is the heuristic weight of the first search, values below 1 run plain A*
+// the search keeps a few words per node of the source and must only be used by one thread at a time
+ASAnytimeSearch ASAnytimeSearchCreate(const ASPathNodeIDSource *nodeSource, void *context, float initialWeight);
+
+// starts a new query, the buffers of the previous one are reused without clearing
+void ASAnytimeSearchStart(ASAnytimeSearch search, uint32_t startNode, uint32_t goalNode);
+
+// searches until the path is proven optimal, seconds have passed or maxExpansions nodes were expanded (0 for no limit), whichever comes first
+// returns the best path found so far or NULL if there is none yet -- call again to keep improving it from where the last call stopped
+// the clock is checked every few expansions, so the call may overrun seconds by the time of those
+ASPath ASAnytimeSearchImprove(ASAnytimeSearch search, double seconds, size_t maxExpansions);
+
+// fetches the factor the best path so far is known to be within of the optimal cost, 1 once it is proven optimal and INFINITY while there is no path
+float ASAnytimeSearchGetBound(ASAnytimeSearch search);
+
+// fetches the number of nodes the current query expanded over all calls
+size_t ASAnytimeSearchGetExpandedCount(ASAnytimeSearch search);
+
+// releases the search
+void ASAnytimeSearchDestroy(ASAnytimeSearch search);
+
+// a reservation table holds the space-time reservations of paths already planned, so robots planned one after another stay out of each other's way (cooperative A*)
+// path costs are taken as travel times from startTime, time is split into buckets of timeStep and a node is held by one robot per bucket
+// searches give up on paths that would take longer than horizon, node ids must be less than nodeCount
+ASReservationTable ASReservationTableCreate(uint32_t nodeCount, float timeStep, float horizon);
+
+// reserves the nodes of a path that starts at startTime, the robot holds each node until it arrives at the next and stays at the last one
+// ASPathCreateCooperative() reserves its own paths, use this for robots that follow a path planned some other way
+void ASReservationTableReservePath(ASReservationTable table, ASPath path, float startTime);
+
+// drops all reservations, for example to plan the next batch of robots
+void ASReservationTableClear(ASReservationTable table);
+
+// fetches the number of (node, bucket) reservations
+size_t ASReservationTableGetCount(ASReservationTable table);
+
+// releases the table
+void ASReservationTableDestroy(ASReservationTable table);
+
+// finds the fastest path from startNode at startTime to goalNode that keeps clear of the reservations, waiting in place where that helps, and reserves it
+// a move is refused if the next node is reserved on arrival, the current node is reserved before the move ends or another robot crosses the same edge the other way
+// the goal is only reached once no other robot passes it later, a wait shows up as the same node twice in the path -- returns NULL if there is no such path within the horizon
+// the path is the fastest when the edge costs are multiples of timeStep, otherwise it may arrive up to one timeStep late, the resolution of the table
+// the table is modified, so robots sharing a table must be planned one after another
+ASPath ASPathCreateCooperative(ASSearchWorkspace workspace, ASReservationTable table, const ASPathNodeIDSource *nodeSource, void *context, uint32_t startNode, uint32_t goalNode, float startTime);
+
+// moves allowed on an ASGrid
+typedef enum {
+    ASGridFourConnected = 4,    // horizontal and vertical steps of cost 1
+    ASGridEightConnected = 8,   // also diagonal steps of cost sqrt(2), which may not cut the corner of a blocked cell
+} ASGridConnectivity;
+
+// a uniform cost occupancy grid searched with Jump Point Search, node ids are y * width + x
+// occupancy holds width * height bytes row by row, nonzero for blocked cells -- the grid keeps its own copy as one bit per cell
+ASGrid ASGridCreate(uint32_t width, uint32_t height, const uint8_t *occupancy, ASGridConnectivity connectivity);
+
+// precomputes the jump distance from every cell in every direction (JPS+), so searches look jumps up instead of scanning for them
+// costs 4 bytes per cell and direction -- returns 0 on success or -1 if the table could not be allocated
+int ASGridBuildJumpTable(ASGrid grid);
+
+// releases the grid
+void ASGridDestroy(ASGrid grid);
+
+// finds the cheapest path from startNode to goalNode with Jump Point Search, only the cells where the path turns go through the open set
+// the path holds every cell along the way, so it matches a plain search over the same grid -- returns NULL if either end is blocked or there is no path
+// the grid is never modified by a search and may be shared by any number of threads, each with its own workspace
+ASPath ASPathCreateWithGrid(ASSearchWorkspace workspace, ASGrid grid, uint32_t startNode, uint32_t goalNode);
+
+// a pool of worker threads, each with its own workspace, that runs batches of searches -- the thread calling the batch function is one of the workers
+// threadCount 0 uses one worker per online core, a pool of 1 runs batches on the calling thread alone
+// returns NULL if out of memory -- if the system can't start every thread, the pool has fewer workers, see ASSearchPoolGetThreadCount()
+ASSearchPool ASSearchPoolCreate(size_t threadCount);
+
+// fetches the number of workers of the pool, including the calling thread
+size_t ASSearchPoolGetThreadCount(ASSearchPool pool);
+
+// stops the threads and releases the pool with all of its workspaces
+void ASSearchPoolDestroy(ASSearchPool pool);
+
+// options for the batch functions -- optional, NULL uses a temporary pool with one worker per core and the default search options
+typedef struct {
+    ASSearchPool pool;                      // pool that runs the batch -- optional, a temporary pool is created for the call if not specified
+    size_t threadCount;                     // worker count of the temporary pool, 0 for one per online core -- ignored when pool is specified
+    const ASSearchOptions *searchOptions;   // applied to every worker's workspace -- optional, uses the defaults if not specified
+} ASBatchOptions;
+
+// runs ASPathCreate(source, context, starts[i], goals[i]) for every i < count and stores the path in results[i]
+// the queries are spread over the workers, which steal work from each other when they run out, so the callbacks must be safe to call from several threads at once
+// goals is optional, a NULL array searches the entire graph from every start
+// batches on the same pool run one after another -- if no pool is given and the temporary one can't be created, every result is NULL
+void ASPathCreateBatch(const ASPathNodeSource *nodeSource, void *context, void *const *starts, void *const *goals, size_t count, ASPath *results, const ASBatchOptions *options);
+
+// same as ASPathCreateBatch() with ASPathCreateWithNodeIDs() as the search
+void ASPathCreateBatchWithNodeIDs(const ASPathNodeIDSource *nodeSource, void *context, const uint32_t *starts, const uint32_t *goals, size_t count, ASPath *results, const ASBatchOptions *options);
+
 // paths created with ASPathCreate() must be destroyed or else it will leak memory
+// releases one reference to the path, the path is freed with the last one
 void ASPathDestroy(ASPath path);
 
-// if you want to make a copy of a path result, this function will do the job
-// you must call ASPathDestroy() with the resulting path to clean it up or it will cause a leak
+// paths never change once created, so a copy is the same path with one more reference and costs no allocation
+// you must call ASPathDestroy() with the resulting path to clean it up or it will cause a leak -- the references may be released from any thread
 ASPath ASPathCopy(ASPath path);
 
 // fetches the total cost of the path
@@ -65,7 +486,14 @@ float ASPathGetCost(ASPath path, size_t index);
 // fetches the number of nodes in the path
 size_t ASPathGetCount(ASPath path);
 
-// returns a pointer to the given node in the path
+// returns a pointer to the given node in the path, or to its id if the node source has nodeID
 void *ASPathGetNode(ASPath path, size_t index);
 
+// returns the given node id of a path created with ASPathCreateWithNodeIDs(), ASPathCreateWithGraph() or a node source with nodeID, or ASNodeIDNull
+uint32_t ASPathGetNodeID(ASPath path, size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -0,0 +1,410 @@
+/*
+ Copyright (c) 2012, Sean Heber. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of Sean Heber nor the names of its contributors may
+ be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL SEAN HEBER BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// header-only C++17 version of the A* search in AStar.c, for node types and callbacks known at compile time
+// the callbacks are members of a traits class, so the compiler can inline them into the search loop -- there is no neighbor list,
+// every neighbor is relaxed as soon as the traits hand it over, and nodes are compared with operator== instead of memcmp
+//
+// the traits class provides:
+//
+//     template <class Add> void neighbors(const Node &node, float nodeCost, const Node &fromNode, Add &&add);  // call add(neighbor, edgeCost) for every neighbor
+//     float heuristic(const Node &fromNode, const Node &toNode);                                              // optional, uses 0 if not provided
+//     int earlyExit(size_t visitedCount, const Node &visitingNode, const Node &goalNode);                      // optional, 1 for success, -1 for failure, 0 to continue
+//     uint32_t nodeCount();                                           // optional, for unsigned integer nodes in [0, nodeCount) -- the records are indexed by node, as in ASPathCreateWithNodeIDs()
+//     using Hash = ...;                                               // optional, hashes nodes for the visited index of the other node types, std::hash<Node> if not provided
+//     static constexpr astar::TieBreak tieBreak = ...;                // optional, see TieBreak
+//
+// fromNode is the node expanded before this one, as in the C API
+// the features are picked with if constexpr, so a search without a heuristic or early exit carries no code for them
+
+#ifndef AStar_hpp
+#define AStar_hpp
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace astar {
+
+// order of open nodes with the same rank
+enum class TieBreak {
+    none,           // whichever the heap has on top, same as the C API
+    higherCost,     // the node furthest from the start, which is the closest to the goal when the heuristic is exact -- fewer expansions on open grids
+};
+
+template <class Node>
+struct Path {
+    std::vector<Node> nodes;
+    std::vector<float> costs;   // cost from the start to each node
+
+    size_t size() const { return nodes.size(); }
+    bool empty() const { return nodes.empty(); }
+    float cost() const { return costs.empty()? INFINITY : costs.back(); }
+    void clear() { nodes.clear(); costs.clear(); }
+};
+
+namespace detail {
+
+template <class Traits, class Node, class = void>
+struct HasHeuristic : std::false_type {};
+template <class Traits, class Node>
+struct HasHeuristic<Traits, Node, std::void_t<decltype(std::declval<Traits &>().heuristic(std::declval<const Node &>(), std::declval<const Node &>()))>> : std::true_type {};
+
+template <class Traits, class Node, class = void>
+struct HasEarlyExit : std::false_type {};
+template <class Traits, class Node>
+struct HasEarlyExit<Traits, Node, std::void_t<decltype(std::declval<Traits &>().earlyExit(size_t(), std::declval<const Node &>(), std::declval<const Node &>()))>> : std::true_type {};
+
+template <class Traits, class = void>
+struct HasNodeCount : std::false_type {};
+template <class Traits>
+struct HasNodeCount<Traits, std::void_t<decltype(std::declval<Traits &>().nodeCount())>> : std::true_type {};
+
+template <class Traits, class Node, class = void>
+struct NodeHash { using type = std::hash<Node>; };
+template <class Traits, class Node>
+struct NodeHash<Traits, Node, std::void_t<typename Traits::Hash>> { using type = typename Traits::Hash; };
+
+template <class Traits, class = void>
+struct NodeTieBreak { static constexpr TieBreak value = TieBreak::none; };
+template <class Traits>
+struct NodeTieBreak<Traits, std::void_t<decltype(Traits::tieBreak)>> { static constexpr TieBreak value = Traits::tieBreak; };
+
+}
+
+template <class Node, class Traits>
+class Search {
+public:
+    static constexpr bool hasHeuristic = detail::HasHeuristic<Traits, Node>::value;
+    static constexpr bool hasEarlyExit = detail::HasEarlyExit<Traits, Node>::value;
+    static constexpr bool denseNodes = detail::HasNodeCount<Traits>::value && std::is_integral<Node>::value && std::is_unsigned<Node>::value;
+    static constexpr TieBreak tieBreak = detail::NodeTieBreak<Traits>::value;
+
+    explicit Search(Traits traits = Traits()) : traits_(std::move(traits)) {}
+
+    Traits &traits() { return traits_; }
+    const Traits &traits() const { return traits_; }
+
+    // the number of nodes the last search reached, same count as ASSearchWorkspaceGetVisitedCount()
+    size_t visitedCount() const { return visitedCount_; }
+
+    // stores the cheapest path from start to goal in path and returns true, or clears path and returns false if there is none
+    // with nodeCount() provided, a start or goal out of [0, nodeCount) has no path and neighbors out of it are skipped
+    // the search state stays allocated between calls like a workspace, so a Search must only be used by one thread at a time
+    bool find(const Node &start, const Node &goal, Path<Node> &path)
+    {
+        path.clear();
+        prepare();
+
+        if constexpr (denseNodes) {
+            if (start >= nodeCount_ || goal >= nodeCount_) {
+                return false;
+            }
+        }
+
+        const uint32_t startRecord = getRecord(start);
+        const uint32_t goalRecord = getRecord(goal);
+        uint32_t current = startRecord;
+        uint32_t prevRecord = startRecord;
+        bool found = false;
+
+        records_[startRecord].estimate = estimate(start, goal);
+        records_[startRecord].flags |= hasEstimateFlag;
+        addToOpenSet(startRecord, 0, noRecord);
+
+        while (!open_.empty()) {
+            current = open_[0];
+
+            if (current == goalRecord) {
+                found = true;
+                break;
+            }
+
+            if constexpr (hasEarlyExit) {
+                const int shouldExit = traits_.earlyExit(visitedCount_, node(current), goal);
+
+                if (shouldExit > 0) {
+                    found = true;
+                    break;
+                } else if (shouldExit < 0) {
+                    break;
+                }
+            }
+
+            expand(current, prevRecord, goal);
+            prevRecord = current;
+        }
+
+        if (found) {
+            size_t count = 0;
+            for (uint32_t r = current; r != noRecord; r = records_[r].parent) {
+                count++;
+            }
+
+            path.nodes.resize(count);
+            path.costs.resize(count);
+            for (uint32_t r = current; r != noRecord; r = records_[r].parent) {
+                count--;
+                path.nodes[count] = node(r);
+                path.costs[count] = records_[r].cost;
+            }
+        }
+
+        return found;
+    }
+
+    Path<Node> find(const Node &start, const Node &goal)
+    {
+        Path<Node> path;
+        find(start, goal, path);
+        return path;
+    }
+
+private:
+    static constexpr uint32_t noRecord = UINT32_MAX;
+
+    enum : uint32_t {
+        openFlag = 1 << 0,
+        closedFlag = 1 << 1,
+        hasEstimateFlag = 1 << 2,
+    };
+
+    struct Record {
+        float estimate;
+        float cost;
+        uint32_t parent;
+        uint32_t openIndex;
+        uint32_t generation;    // dense records only hold search state if this matches the current generation
+        uint32_t flags;
+    };
+
+    using Hash = typename detail::NodeHash<Traits, Node>::type;
+
+    Traits traits_;
+    std::vector<Record> records_;
+    std::vector<Node> nodes_;                           // the node of every record, unused for dense nodes where the record index is the node
+    std::unordered_map<Node, uint32_t, Hash> index_;    // record index of every visited node, unused for dense nodes
+    std::vector<uint32_t> open_;                        // binary heap of record indexes
+    uint32_t generation_ = 0;
+    size_t nodeCount_ = 0;                              // traits_.nodeCount() of the current search, for dense nodes
+    size_t visitedCount_ = 0;
+
+    void prepare()
+    {
+        visitedCount_ = 0;
+        open_.clear();
+
+        if constexpr (denseNodes) {
+            // records are only valid when stamped with the current generation, so a new search never has to clear them
+            nodeCount_ = traits_.nodeCount();
+            if (records_.size() < nodeCount_) {
+                records_.resize(nodeCount_, Record{0, 0, noRecord, 0, 0, 0});
+            }
+            if (++generation_ == 0) {
+                for (Record &record : records_) {
+                    record.generation = 0;
+                }
+                generation_ = 1;
+            }
+        } else {
+            records_.clear();
+            nodes_.clear();
+            index_.clear();
+        }
+    }
+
+    Node node(uint32_t record) const
+    {
+        if constexpr (denseNodes) {
+            return static_cast<Node>(record);
+        } else {
+            return nodes_[record];
+        }
+    }
+
+    uint32_t getRecord(const Node &n)
+    {
+        if constexpr (denseNodes) {
+            Record &record = records_[n];
+            if (record.generation != generation_) {
+                record = Record{0, 0, noRecord, 0, generation_, 0};
+                visitedCount_++;
+            }
+            return static_cast<uint32_t>(n);
+        } else {
+            const auto inserted = index_.try_emplace(n, static_cast<uint32_t>(records_.size()));
+            if (inserted.second) {
+                records_.push_back(Record{0, 0, noRecord, 0, 0, 0});
+                nodes_.push_back(n);
+                visitedCount_++;
+            }
+            return inserted.first->second;
+        }
+    }
+
+    float estimate(const Node &from, const Node &goal)
+    {
+        if constexpr (hasHeuristic) {
+            return traits_.heuristic(from, goal);
+        } else {
+            return 0;
+        }
+    }
+
+    bool ranksBefore(uint32_t a, uint32_t b) const
+    {
+        const Record &recordA = records_[a];
+        const Record &recordB = records_[b];
+        const float rankA = recordA.estimate + recordA.cost;
+        const float rankB = recordB.estimate + recordB.cost;
+
+        if constexpr (tieBreak == TieBreak::higherCost) {
+            return rankA < rankB || (rankA == rankB && recordA.cost > recordB.cost);
+        } else {
+            return rankA < rankB;
+        }
+    }
+
+    void swapOpen(size_t index1, size_t index2)
+    {
+        records_[open_[index1]].openIndex = static_cast<uint32_t>(index2);
+        records_[open_[index2]].openIndex = static_cast<uint32_t>(index1);
+        std::swap(open_[index1], open_[index2]);
+    }
+
+    void siftUp(size_t index)
+    {
+        while (index > 0) {
+            const size_t parentIndex = (index - 1) / 2;
+            if (ranksBefore(open_[parentIndex], open_[index])) {
+                break;
+            }
+            swapOpen(parentIndex, index);
+            index = parentIndex;
+        }
+    }
+
+    void siftDown(size_t index)
+    {
+        for (;;) {
+            const size_t leftIndex = (2 * index) + 1;
+            const size_t rightIndex = leftIndex + 1;
+            size_t smallestIndex = index;
+
+            if (leftIndex < open_.size() && ranksBefore(open_[leftIndex], open_[smallestIndex])) {
+                smallestIndex = leftIndex;
+            }
+            if (rightIndex < open_.size() && ranksBefore(open_[rightIndex], open_[smallestIndex])) {
+                smallestIndex = rightIndex;
+            }
+            if (smallestIndex == index) {
+                break;
+            }
+            swapOpen(smallestIndex, index);
+            index = smallestIndex;
+        }
+    }
+
+    void removeFromOpenSet(uint32_t record)
+    {
+        Record &r = records_[record];
+        if (r.flags & openFlag) {
+            r.flags &= ~openFlag;
+
+            // the node moved into the hole came from the bottom of the heap, so it may have to move either way
+            const size_t index = r.openIndex;
+            swapOpen(index, open_.size() - 1);
+            open_.pop_back();
+            if (index < open_.size()) {
+                siftDown(index);
+                siftUp(index);
+            }
+        }
+    }
+
+    void addToOpenSet(uint32_t record, float cost, uint32_t parent)
+    {
+        Record &r = records_[record];
+        r.parent = parent;
+        r.cost = cost;
+        r.flags |= openFlag;
+        r.openIndex = static_cast<uint32_t>(open_.size());
+        open_.push_back(record);
+        siftUp(open_.size() - 1);
+    }
+
+    void expand(uint32_t current, uint32_t prevRecord, const Node &goal)
+    {
+        removeFromOpenSet(current);
+        records_[current].flags |= closedFlag;
+
+        // copies, the records and nodes may move while the neighbors are added
+        const float currentCost = records_[current].cost;
+        const Node currentNode = node(current);
+        const Node prevNode = node(prevRecord);
+
+        traits_.neighbors(currentNode, currentCost, prevNode, [&](const Node &neighbor, float edgeCost) {
+            if constexpr (denseNodes) {
+                if (neighbor >= nodeCount_) {
+                    return;
+                }
+            }
+
+            const float cost = currentCost + edgeCost;
+            const uint32_t record = getRecord(neighbor);
+            Record &r = records_[record];
+
+            if (!(r.flags & hasEstimateFlag)) {
+                r.estimate = estimate(neighbor, goal);
+                r.flags |= hasEstimateFlag;
+            }
+
+            if ((r.flags & openFlag) && cost < r.cost) {
+                removeFromOpenSet(record);
+            }
+
+            if ((r.flags & closedFlag) && cost < r.cost) {
+                r.flags &= ~closedFlag;
+            }
+
+            if (!(r.flags & (openFlag | closedFlag))) {
+                addToOpenSet(record, cost, current);
+            }
+        });
+    }
+};
+
+}
+
+#endif
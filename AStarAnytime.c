@@ -0,0 +1,429 @@
+/*
+ Copyright (c) 2012, Sean Heber. All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ 1. Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ 
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ 3. Neither the name of Sean Heber nor the names of its contributors may
+ be used to endorse or promote products derived from this software without
+ specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL SEAN HEBER BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "AStarPrivate.h"
+#include <string.h>
+#include <time.h>
+
+// ARA*: a series of weighted A* searches ranked by g + weight * h with a falling weight, where each search picks up the
+// open set and costs of the one before -- a node whose cost drops after it was expanded in the current search goes to the
+// inconsistent list instead of being expanded again, and rejoins the open set when the next search starts with a lower weight
+// a finished search with weight w leaves a path at most w times the optimum, lower bounds from the open set often prove less
+
+#define AnytimeNotQueued        UINT32_MAX
+#define AnytimeClockInterval    32      // expansions between clock reads
+#define AnytimeWeightStop       1.01f   // searches whose weight would fall below this run with weight 1
+
+typedef struct {
+    float cost;                         // cost of the best path found to the node so far
+    float heuristic;                    // estimate to the goal, computed once per query
+    float edgeCost;                     // cost of the edge from parent, so the path costs are exact even after the parent got cheaper
+    uint32_t parent;
+    uint32_t heapIndex;                 // slot in heap, AnytimeNotQueued if not in the open set
+    uint32_t generation;                // the record only holds query state if this matches the current generation
+    uint32_t closedIteration;           // iteration that last expanded the node
+    uint32_t inconsistentIteration;     // iteration that put the node on the inconsistent list
+} AnytimeRecord;
+
+typedef struct {
+    float key;
+    uint32_t node;
+} AnytimeHeapEntry;
+
+struct __ASAnytimeSearch {
+    const ASPathNodeIDSource *source;
+    void *context;
+    float initialWeight;
+    uint32_t start;
+    uint32_t goal;
+    uint32_t generation;
+    uint32_t iteration;                 // counts the weighted searches, stamps the closed and inconsistent nodes of each
+    float weight;                       // weight of the search in progress
+    float bound;                        // suboptimality bound of the best path so far
+    int searchDone;                     // the search with the current weight finished
+    size_t expandedCount;
+    ASPath bestPath;                    // cheapest path found so far, handed out with ASPathCopy()
+    AnytimeRecord *records;
+    size_t heapCount;
+    AnytimeHeapEntry *heap;
+    size_t inconsistentCount;
+    uint32_t *inconsistent;
+    struct __ASNeighborList neighbors;
+    struct __ASNeighborList pathNodes;
+};
+
+/********************************************/
+
+static inline double GetAnytimeClock(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static inline AnytimeRecord *GetAnytimeRecord(ASAnytimeSearch search, uint32_t node)
+{
+    AnytimeRecord *record = &search->records[node];
+
+    if (record->generation != search->generation) {
+        record->generation = search->generation;
+        record->cost = INFINITY;
+        record->heuristic = search->source->pathCostHeuristic? search->source->pathCostHeuristic(node, search->goal, search->context) : 0;
+        record->edgeCost = 0;
+        record->parent = ASNodeIDNull;
+        record->heapIndex = AnytimeNotQueued;
+        record->closedIteration = 0;
+        record->inconsistentIteration = 0;
+    }
+
+    return record;
+}
+
+static inline float GetAnytimeKey(ASAnytimeSearch search, const AnytimeRecord *record)
+{
+    return record->cost + search->weight * record->heuristic;
+}
+
+static inline void AnytimeHeapSet(ASAnytimeSearch search, size_t index, AnytimeHeapEntry entry)
+{
+    search->heap[index] = entry;
+    search->records[entry.node].heapIndex = (uint32_t)index;
+}
+
+static void AnytimeHeapSiftUp(ASAnytimeSearch search, size_t index)
+{
+    const AnytimeHeapEntry entry = search->heap[index];
+
+    while (index > 0) {
+        const size_t parent = (index - 1) / 2;
+        if (!(entry.key < search->heap[parent].key)) {
+            break;
+        }
+        AnytimeHeapSet(search, index, search->heap[parent]);
+        index = parent;
+    }
+    AnytimeHeapSet(search, index, entry);
+}
+
+static void AnytimeHeapSiftDown(ASAnytimeSearch search, size_t index)
+{
+    const AnytimeHeapEntry entry = search->heap[index];
+
+    for (;;) {
+        size_t child = 2 * index + 1;
+        if (child >= search->heapCount) {
+            break;
+        }
+        if (child + 1 < search->heapCount && search->heap[child + 1].key < search->heap[child].key) {
+            child++;
+        }
+        if (!(search->heap[child].key < entry.key)) {
+            break;
+        }
+        AnytimeHeapSet(search, index, search->heap[child]);
+        index = child;
+    }
+    AnytimeHeapSet(search, index, entry);
+}
+
+static void AnytimeHeapPush(ASAnytimeSearch search, uint32_t node, float key)
+{
+    // a node is queued at most once, so the heap never holds more than nodeCount entries
+    AnytimeRecord *record = &search->records[node];
+
+    if (record->heapIndex == AnytimeNotQueued) {
+        AnytimeHeapSet(search, search->heapCount++, (AnytimeHeapEntry){key, node});
+        AnytimeHeapSiftUp(search, search->heapCount - 1);
+    } else {
+        search->heap[record->heapIndex].key = key;
+        AnytimeHeapSiftUp(search, record->heapIndex);
+    }
+}
+
+static uint32_t AnytimeHeapPop(ASAnytimeSearch search)
+{
+    const uint32_t node = search->heap[0].node;
+    search->records[node].heapIndex = AnytimeNotQueued;
+
+    if (--search->heapCount > 0) {
+        AnytimeHeapSet(search, 0, search->heap[search->heapCount]);
+        AnytimeHeapSiftDown(search, 0);
+    }
+
+    return node;
+}
+
+static void StartAnytimeIteration(ASAnytimeSearch search, float weight)
+{
+    // the inconsistent nodes rejoin the open set, every key changes with the weight so the heap is rebuilt in place
+    search->weight = weight;
+    search->iteration++;
+    search->searchDone = 0;
+
+    for (size_t i=0; i<search->inconsistentCount; i++) {
+        const uint32_t node = search->inconsistent[i];
+        if (search->records[node].heapIndex == AnytimeNotQueued) {
+            AnytimeHeapSet(search, search->heapCount++, (AnytimeHeapEntry){0, node});
+        }
+    }
+    search->inconsistentCount = 0;
+
+    for (size_t i=0; i<search->heapCount; i++) {
+        search->heap[i].key = GetAnytimeKey(search, &search->records[search->heap[i].node]);
+    }
+    for (size_t i=search->heapCount / 2; i>0; i--) {
+        AnytimeHeapSiftDown(search, i - 1);
+    }
+}
+
+static void UpdateAnytimeBound(ASAnytimeSearch search, float finishedWeight)
+{
+    // every node left to expand has its cost plus estimate as a lower bound on the optimum, the inconsistent ones included
+    const float pathCost = search->records[search->goal].cost;
+    float lowerBound = INFINITY;
+
+    for (size_t i=0; i<search->heapCount; i++) {
+        const AnytimeRecord *record = &search->records[search->heap[i].node];
+        lowerBound = fminf(lowerBound, record->cost + record->heuristic);
+    }
+    for (size_t i=0; i<search->inconsistentCount; i++) {
+        const AnytimeRecord *record = &search->records[search->inconsistent[i]];
+        lowerBound = fminf(lowerBound, record->cost + record->heuristic);
+    }
+
+    if (pathCost == INFINITY) {
+        return;
+    } else if (lowerBound >= pathCost) {
+        // nothing left can lead to a cheaper path
+        search->bound = 1;
+    } else {
+        search->bound = fminf(fminf(search->bound, finishedWeight), pathCost / lowerBound);
+    }
+}
+
+static int ImproveAnytimePath(ASAnytimeSearch search, double deadline, size_t expansionLimit)
+{
+    // runs the search with the current weight until the goal's cost is below every key, returns 0 if a limit stopped it first
+    const uint32_t nodeCount = search->source->nodeCount;
+    size_t expanded = 0;
+
+    while (search->heapCount > 0 && search->heap[0].key < search->records[search->goal].cost) {
+        if (expanded >= expansionLimit || (expanded % AnytimeClockInterval == 0 && GetAnytimeClock() >= deadline)) {
+            search->expandedCount += expanded;
+            return 0;
+        }
+
+        const uint32_t node = AnytimeHeapPop(search);
+        const float cost = search->records[node].cost;
+        search->records[node].closedIteration = search->iteration;
+        expanded++;
+
+        search->neighbors.count = 0;
+        search->source->nodeNeighbors(&search->neighbors, node, cost, search->records[node].parent, search->context);
+        const uint32_t *neighbors = search->neighbors.nodeKeys;
+
+        for (size_t i=0; i<search->neighbors.count; i++) {
+            if (neighbors[i] >= nodeCount) {
+                continue;
+            }
+
+            AnytimeRecord *record = GetAnytimeRecord(search, neighbors[i]);
+            const float neighborCost = cost + search->neighbors.costs[i];
+
+            if (neighborCost < record->cost) {
+                record->cost = neighborCost;
+                record->edgeCost = search->neighbors.costs[i];
+                record->parent = node;
+
+                if (record->closedIteration != search->iteration) {
+                    AnytimeHeapPush(search, neighbors[i], GetAnytimeKey(search, record));
+                } else if (record->inconsistentIteration != search->iteration) {
+                    record->inconsistentIteration = search->iteration;
+                    search->inconsistent[search->inconsistentCount++] = neighbors[i];
+                }
+            }
+        }
+    }
+
+    search->expandedCount += expanded;
+    search->searchDone = 1;
+    return 1;
+}
+
+static ASPath CreateAnytimePath(ASAnytimeSearch search)
+{
+    // the parents always lead back to the start, costs are summed from the edges since a parent may have got cheaper after it was linked
+    ASNeighborList pathNodes = &search->pathNodes;
+    size_t count = 0;
+    pathNodes->count = 0;
+
+    for (uint32_t node = search->goal; node != ASNodeIDNull; node = search->records[node].parent) {
+        ASNeighborListAddID(pathNodes, node, search->records[node].edgeCost);
+        count++;
+    }
+
+    // the neighbor list drops the nodes it has no memory for
+    ASPath path = (pathNodes->count == count)? ASPathAlloc(sizeof(uint32_t), count) : NULL;
+    if (!path) {
+        return NULL;
+    }
+    const uint32_t *nodes = pathNodes->nodeKeys;
+    uint32_t *pathIDs = path->nodeKeys;
+    float cost = 0;
+
+    for (size_t i=0; i<pathNodes->count; i++) {
+        const size_t from = pathNodes->count - 1 - i;
+        cost += (i > 0)? pathNodes->costs[from] : 0;
+        pathIDs[i] = nodes[from];
+        path->costs[i] = cost;
+    }
+
+    return path;
+}
+
+ASAnytimeSearch ASAnytimeSearchCreate(const ASPathNodeIDSource *source, void *context, float initialWeight)
+{
+    if (!source || !source->nodeNeighbors) {
+        return NULL;
+    }
+
+    ASAnytimeSearch search = calloc(1, sizeof(struct __ASAnytimeSearch));
+    search->source = source;
+    search->context = context;
+    search->initialWeight = (initialWeight > 1)? initialWeight : 1;
+    search->start = ASNodeIDNull;
+    search->goal = ASNodeIDNull;
+    search->records = calloc(source->nodeCount, sizeof(AnytimeRecord));
+    search->heap = malloc(source->nodeCount * sizeof(AnytimeHeapEntry));
+    search->inconsistent = malloc(source->nodeCount * sizeof(uint32_t));
+    NeighborListBind(&search->neighbors, sizeof(uint32_t));
+    NeighborListBind(&search->pathNodes, sizeof(uint32_t));
+    return search;
+}
+
+void ASAnytimeSearchStart(ASAnytimeSearch search, uint32_t startNode, uint32_t goalNode)
+{
+    if (!search || startNode >= search->source->nodeCount || goalNode >= search->source->nodeCount) {
+        return;
+    }
+
+    if (++search->generation == 0) {
+        // the generation wrapped around, so old stamps could look current again
+        for (uint32_t n=0; n<search->source->nodeCount; n++) {
+            search->records[n].generation = 0;
+        }
+        search->generation = 1;
+    }
+
+    search->start = startNode;
+    search->goal = goalNode;
+    search->bound = INFINITY;
+    search->expandedCount = 0;
+    search->heapCount = 0;
+    search->inconsistentCount = 0;
+    ASPathDestroy(search->bestPath);
+    search->bestPath = NULL;
+
+    GetAnytimeRecord(search, goalNode);
+    GetAnytimeRecord(search, startNode)->cost = 0;
+    AnytimeHeapSet(search, search->heapCount++, (AnytimeHeapEntry){0, startNode});
+    StartAnytimeIteration(search, search->initialWeight);
+}
+
+ASPath ASAnytimeSearchImprove(ASAnytimeSearch search, double seconds, size_t maxExpansions)
+{
+    if (!search || search->goal == ASNodeIDNull) {
+        return NULL;
+    }
+
+    const double deadline = GetAnytimeClock() + seconds;
+    const size_t expansionLimit = maxExpansions? maxExpansions : SIZE_MAX;
+    const size_t expandedBefore = search->expandedCount;
+
+    // each finished search lowers the weight to halfway between 1 and the bound it achieved, until the path is proven optimal
+    while (search->bound > 1) {
+        const size_t expandedSoFar = search->expandedCount - expandedBefore;
+
+        if (!search->searchDone) {
+            if (!ImproveAnytimePath(search, deadline, expansionLimit - expandedSoFar)) {
+                UpdateAnytimeBound(search, INFINITY);
+                break;
+            }
+            UpdateAnytimeBound(search, search->weight);
+
+            if (search->records[search->goal].cost == INFINITY) {
+                // the open set ran empty without reaching the goal
+                break;
+            }
+        }
+
+        if (search->bound <= 1 || search->weight <= 1 || GetAnytimeClock() >= deadline || search->expandedCount - expandedBefore >= expansionLimit) {
+            search->bound = (search->weight <= 1 && search->searchDone)? 1 : search->bound;
+            break;
+        }
+
+        const float weight = 1 + (fminf(search->weight, search->bound) - 1) / 2;
+        StartAnytimeIteration(search, (weight < AnytimeWeightStop)? 1 : weight);
+    }
+
+    if (search->records[search->goal].cost < INFINITY) {
+        // a parent that got cheaper may leave its old children on a path that costs more than the one before, so the best is kept
+        ASPath path = CreateAnytimePath(search);
+        if (!search->bestPath || path->costs[path->count - 1] < search->bestPath->costs[search->bestPath->count - 1]) {
+            ASPathDestroy(search->bestPath);
+            search->bestPath = path;
+        } else {
+            ASPathDestroy(path);
+        }
+    }
+
+    return ASPathCopy(search->bestPath);
+}
+
+float ASAnytimeSearchGetBound(ASAnytimeSearch search)
+{
+    return search? search->bound : INFINITY;
+}
+
+size_t ASAnytimeSearchGetExpandedCount(ASAnytimeSearch search)
+{
+    return search? search->expandedCount : 0;
+}
+
+void ASAnytimeSearchDestroy(ASAnytimeSearch search)
+{
+    if (search) {
+        free(search->records);
+        free(search->heap);
+        free(search->inconsistent);
+        ASPathDestroy(search->bestPath);
+        NeighborListFree(&search->neighbors);
+        NeighborListFree(&search->pathNodes);
+        free(search);
+    }
+}
@@ -0,0 +1,358 @@
+/*
+ Copyright (c) 2012, Sean Heber. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of Sean Heber nor the names of its contributors may
+ be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL SEAN HEBER BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "AStarPrivate.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct {
+    const ASPathNodeSource *source;
+    const ASPathNodeIDSource *idSource;
+    void *context;
+    void *const *starts;
+    void *const *goals;
+    const uint32_t *startIDs;
+    const uint32_t *goalIDs;
+    ASPath *results;
+    void (*run)(ASSearchWorkspace workspace, uint32_t index, void *context);  // runs instead of a search if set, see SearchPoolRun()
+} BatchJob;
+
+typedef struct {
+    ASSearchWorkspace workspace;
+    _Atomic uint64_t range;             // queries this worker has left, packed as (begin << 32) | end
+} PoolWorker;
+
+struct __ASSearchPool {
+    size_t threadCount;
+    PoolWorker *workers;                // workers[0] is run by the thread that calls the batch function
+    pthread_t *threads;                 // threads for workers[1..threadCount)
+    pthread_mutex_t batchMutex;         // held for a whole batch, batches on the same pool run one after another
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    size_t batch;                       // incremented for every batch, the threads wait for it to change
+    size_t runningThreads;
+    int shutdown;
+    const BatchJob *job;
+};
+
+typedef struct {
+    ASSearchPool pool;
+    size_t index;
+} WorkerStart;
+
+/********************************************/
+
+static inline uint64_t RangeMake(uint32_t begin, uint32_t end)
+{
+    return ((uint64_t)begin << 32) | end;
+}
+
+static inline uint32_t RangeBegin(uint64_t range)
+{
+    return (uint32_t)(range >> 32);
+}
+
+static inline uint32_t RangeEnd(uint64_t range)
+{
+    return (uint32_t)range;
+}
+
+static inline int TakeQuery(PoolWorker *worker, uint32_t *query)
+{
+    // the owner takes queries from the front of its range
+    uint64_t range = atomic_load(&worker->range);
+
+    while (RangeBegin(range) < RangeEnd(range)) {
+        if (atomic_compare_exchange_weak(&worker->range, &range, RangeMake(RangeBegin(range) + 1, RangeEnd(range)))) {
+            *query = RangeBegin(range);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static inline int StealQueries(ASSearchPool pool, size_t thief)
+{
+    // thieves take the back half of a victim's range, so owner and thief rarely touch the same queries
+    for (size_t i=1; i<pool->threadCount; i++) {
+        PoolWorker *victim = &pool->workers[(thief + i) % pool->threadCount];
+        uint64_t range = atomic_load(&victim->range);
+
+        while (RangeBegin(range) < RangeEnd(range)) {
+            const uint32_t begin = RangeBegin(range);
+            const uint32_t end = RangeEnd(range);
+            const uint32_t middle = begin + (end - begin) / 2;
+
+            if (atomic_compare_exchange_weak(&victim->range, &range, RangeMake(begin, middle))) {
+                atomic_store(&pool->workers[thief].range, RangeMake(middle, end));
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static inline void RunQuery(const BatchJob *job, ASSearchWorkspace workspace, uint32_t query)
+{
+    if (job->run) {
+        job->run(workspace, query, job->context);
+    } else if (job->idSource) {
+        job->results[query] = ASPathCreateWithNodeIDs(workspace, job->idSource, job->context, job->startIDs[query], job->goalIDs? job->goalIDs[query] : ASNodeIDNull);
+    } else {
+        job->results[query] = ASPathCreateWithWorkspace(workspace, job->source, job->context, job->starts[query], job->goals? job->goals[query] : NULL);
+    }
+}
+
+static void RunWorker(ASSearchPool pool, size_t index)
+{
+    PoolWorker *worker = &pool->workers[index];
+    uint32_t query;
+
+    do {
+        while (TakeQuery(worker, &query)) {
+            RunQuery(pool->job, worker->workspace, query);
+        }
+    } while (StealQueries(pool, index));
+}
+
+static void *WorkerThread(void *arg)
+{
+    WorkerStart *start = arg;
+    ASSearchPool pool = start->pool;
+    const size_t index = start->index;
+    size_t seenBatch = 0;
+    free(start);
+
+    for (;;) {
+        pthread_mutex_lock(&pool->mutex);
+        while (!pool->shutdown && pool->batch == seenBatch) {
+            pthread_cond_wait(&pool->wake, &pool->mutex);
+        }
+        if (pool->shutdown) {
+            pthread_mutex_unlock(&pool->mutex);
+            return NULL;
+        }
+        seenBatch = pool->batch;
+        pthread_mutex_unlock(&pool->mutex);
+
+        RunWorker(pool, index);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->runningThreads == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+static void RunBatch(ASSearchPool pool, const BatchJob *job, size_t count, const ASBatchOptions *options)
+{
+    pthread_mutex_lock(&pool->batchMutex);
+
+    // the workers would all write to the same stats, so batches run without them
+    ASSearchOptions searchOptions = {0};
+    if (options && options->searchOptions) {
+        searchOptions = *options->searchOptions;
+        searchOptions.stats = NULL;
+    }
+
+    for (size_t i=0; i<pool->threadCount; i++) {
+        // every worker starts with an even share of the queries
+        const uint32_t begin = (uint32_t)((count * i) / pool->threadCount);
+        const uint32_t end = (uint32_t)((count * (i + 1)) / pool->threadCount);
+        atomic_store(&pool->workers[i].range, RangeMake(begin, end));
+        ASSearchWorkspaceSetOptions(pool->workers[i].workspace, &searchOptions);
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->job = job;
+    pool->runningThreads = pool->threadCount - 1;
+    pool->batch++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mutex);
+
+    RunWorker(pool, 0);
+
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->runningThreads > 0) {
+        pthread_cond_wait(&pool->done, &pool->mutex);
+    }
+    pool->job = NULL;
+    pthread_mutex_unlock(&pool->mutex);
+
+    pthread_mutex_unlock(&pool->batchMutex);
+}
+
+static int RunBatchOnPool(const BatchJob *job, size_t count, const ASBatchOptions *options)
+{
+    if (options && options->pool) {
+        RunBatch(options->pool, job, count, options);
+        return 1;
+    }
+
+    ASSearchPool pool = ASSearchPoolCreate(options? options->threadCount : 0);
+    if (!pool) {
+        // no pool, no searches: the results read as no path
+        if (job->results) {
+            memset(job->results, 0, count * sizeof(ASPath));
+        }
+        return 0;
+    }
+
+    RunBatch(pool, job, count, options);
+    ASSearchPoolDestroy(pool);
+    return 1;
+}
+
+/********************************************/
+
+ASSearchPool ASSearchPoolCreate(size_t threadCount)
+{
+    if (threadCount == 0) {
+        const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = (cores > 0)? (size_t)cores : 1;
+    }
+
+    ASSearchPool pool = calloc(1, sizeof(struct __ASSearchPool));
+    if (!pool) {
+        return NULL;
+    }
+
+    pool->workers = calloc(threadCount, sizeof(PoolWorker));
+    pool->threads = calloc(threadCount, sizeof(pthread_t));
+    pthread_mutex_init(&pool->batchMutex, NULL);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    if (!pool->workers || !pool->threads) {
+        ASSearchPoolDestroy(pool);
+        return NULL;
+    }
+
+    for (size_t i=0; i<threadCount; i++) {
+        pool->workers[i].workspace = ASSearchWorkspaceCreate();
+        if (!pool->workers[i].workspace) {
+            for (size_t j=0; j<i; j++) {
+                ASSearchWorkspaceDestroy(pool->workers[j].workspace);
+            }
+            ASSearchPoolDestroy(pool);
+            return NULL;
+        }
+    }
+
+    // threadCount only counts the threads that started, so batches never wait on a thread that isn't there
+    pool->threadCount = 1;
+    for (size_t i=1; i<threadCount; i++) {
+        WorkerStart *start = malloc(sizeof(WorkerStart));
+        if (!start) {
+            break;
+        }
+        start->pool = pool;
+        start->index = i;
+        if (pthread_create(&pool->threads[i], NULL, &WorkerThread, start) != 0) {
+            free(start);
+            break;
+        }
+        pool->threadCount++;
+    }
+
+    for (size_t i=pool->threadCount; i<threadCount; i++) {
+        ASSearchWorkspaceDestroy(pool->workers[i].workspace);
+    }
+
+    return pool;
+}
+
+size_t ASSearchPoolGetThreadCount(ASSearchPool pool)
+{
+    return pool? pool->threadCount : 0;
+}
+
+void ASSearchPoolDestroy(ASSearchPool pool)
+{
+    if (pool) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->shutdown = 1;
+        pthread_cond_broadcast(&pool->wake);
+        pthread_mutex_unlock(&pool->mutex);
+
+        for (size_t i=1; i<pool->threadCount; i++) {
+            pthread_join(pool->threads[i], NULL);
+        }
+
+        for (size_t i=0; i<pool->threadCount; i++) {
+            ASSearchWorkspaceDestroy(pool->workers[i].workspace);
+        }
+
+        pthread_cond_destroy(&pool->done);
+        pthread_cond_destroy(&pool->wake);
+        pthread_mutex_destroy(&pool->mutex);
+        pthread_mutex_destroy(&pool->batchMutex);
+        free(pool->threads);
+        free(pool->workers);
+        free(pool);
+    }
+}
+
+void ASPathCreateBatch(const ASPathNodeSource *source, void *context, void *const *starts, void *const *goals, size_t count, ASPath *results, const ASBatchOptions *options)
+{
+    if (!source || !starts || !results || count == 0 || count > UINT32_MAX) {
+        return;
+    }
+
+    const BatchJob job = {source, NULL, context, starts, goals, NULL, NULL, results};
+    RunBatchOnPool(&job, count, options);
+}
+
+void ASPathCreateBatchWithNodeIDs(const ASPathNodeIDSource *source, void *context, const uint32_t *starts, const uint32_t *goals, size_t count, ASPath *results, const ASBatchOptions *options)
+{
+    if (!source || !starts || !results || count == 0 || count > UINT32_MAX) {
+        return;
+    }
+
+    const BatchJob job = {NULL, source, context, NULL, NULL, starts, goals, results};
+    RunBatchOnPool(&job, count, options);
+}
+
+int SearchPoolRun(ASSearchPool pool, size_t count, void (*run)(ASSearchWorkspace workspace, uint32_t index, void *context), void *context)
+{
+    if (!run || count == 0 || count > UINT32_MAX) {
+        return 0;
+    }
+
+    const BatchJob job = {NULL, NULL, context, NULL, NULL, NULL, NULL, NULL, run};
+    const ASBatchOptions options = {pool, 0, NULL};
+    return RunBatchOnPool(&job, count, &options);
+}
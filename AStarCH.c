@@ -0,0 +1,703 @@
+/*
+ Copyright (c) 2012, Sean Heber. All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ 1. Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ 
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ 3. Neither the name of Sean Heber nor the names of its contributors may
+ be used to endorse or promote products derived from this software without
+ specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL SEAN HEBER BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "AStarPrivate.h"
+#include <string.h>
+
+#define HierarchySimulationLimit    64      // nodes a witness search may settle while a node's priority is estimated
+#define HierarchyContractionLimit   512     // nodes a witness search may settle while a node is contracted, the shortcut is kept if no witness turns up within them
+#define HierarchyWitnessSlack       1.00001f    // a witness this close counts as equal, sums of the same edges in another order round differently
+
+typedef struct {
+    uint32_t node;
+    uint32_t middle;
+    float cost;
+} HierarchyArc;
+
+typedef struct {
+    uint32_t count;
+    uint32_t capacity;
+    HierarchyArc *arcs;
+} HierarchyArcs;
+
+typedef struct {
+    float key;
+    uint32_t node;
+} HierarchyHeapEntry;
+
+typedef struct {
+    size_t count;
+    size_t capacity;
+    HierarchyHeapEntry *entries;        // binary min-heap on key
+} HierarchyHeap;
+
+typedef struct {
+    uint32_t from;
+    uint32_t to;
+    uint32_t middle;
+    float cost;
+} HierarchyEdge;
+
+typedef struct {
+    size_t count;
+    size_t capacity;
+    HierarchyEdge *edges;
+} HierarchyEdges;
+
+typedef struct {
+    uint32_t nodeCount;
+    HierarchyArcs *outArcs;             // arcs of the remaining graph, arcs to contracted nodes are skipped rather than removed
+    HierarchyArcs *inArcs;
+    uint8_t *contracted;
+    uint32_t *levels;                   // one more than the highest level of a contracted neighbor
+    uint32_t witnessGeneration;
+    uint32_t *witnessGenerations;       // witnessCosts[n] is only set if this matches witnessGeneration
+    float *witnessCosts;
+    HierarchyHeap witnessHeap;
+} HierarchyBuilder;
+
+/********************************************/
+
+static inline void HierarchyHeapPush(HierarchyHeap *heap, float key, uint32_t node)
+{
+    if (heap->count == heap->capacity) {
+        heap->capacity = 1 + (heap->capacity * 2);
+        heap->entries = realloc(heap->entries, heap->capacity * sizeof(HierarchyHeapEntry));
+    }
+
+    size_t index = heap->count++;
+    while (index > 0 && heap->entries[(index - 1) / 2].key > key) {
+        heap->entries[index] = heap->entries[(index - 1) / 2];
+        index = (index - 1) / 2;
+    }
+    heap->entries[index] = (HierarchyHeapEntry){key, node};
+}
+
+static inline HierarchyHeapEntry HierarchyHeapPop(HierarchyHeap *heap)
+{
+    const HierarchyHeapEntry top = heap->entries[0];
+    const HierarchyHeapEntry last = heap->entries[--heap->count];
+    size_t index = 0;
+
+    for (;;) {
+        size_t child = 2 * index + 1;
+        if (child >= heap->count) {
+            break;
+        }
+        if (child + 1 < heap->count && heap->entries[child + 1].key < heap->entries[child].key) {
+            child++;
+        }
+        if (heap->entries[child].key >= last.key) {
+            break;
+        }
+        heap->entries[index] = heap->entries[child];
+        index = child;
+    }
+
+    if (heap->count > 0) {
+        heap->entries[index] = last;
+    }
+
+    return top;
+}
+
+static inline void HierarchyArcsAdd(HierarchyArcs *arcs, uint32_t node, uint32_t middle, float cost)
+{
+    if (arcs->count == arcs->capacity) {
+        arcs->capacity = 2 + (arcs->capacity * 2);
+        arcs->arcs = realloc(arcs->arcs, arcs->capacity * sizeof(HierarchyArc));
+    }
+    arcs->arcs[arcs->count++] = (HierarchyArc){node, middle, cost};
+}
+
+static inline void HierarchyArcsRemove(HierarchyArcs *arcs, uint32_t node)
+{
+    for (uint32_t i=0; i<arcs->count; i++) {
+        if (arcs->arcs[i].node == node) {
+            arcs->arcs[i] = arcs->arcs[--arcs->count];
+            return;
+        }
+    }
+}
+
+static inline void HierarchyEdgesAdd(HierarchyEdges *edges, uint32_t from, uint32_t to, uint32_t middle, float cost)
+{
+    if (edges->count == edges->capacity) {
+        edges->capacity = 1 + (edges->capacity * 2);
+        edges->edges = realloc(edges->edges, edges->capacity * sizeof(HierarchyEdge));
+    }
+    edges->edges[edges->count++] = (HierarchyEdge){from, to, middle, cost};
+}
+
+static void AddHierarchyArc(HierarchyBuilder *builder, uint32_t from, uint32_t to, uint32_t middle, float cost)
+{
+    // parallel arcs are merged, keeping the cheapest, so every pair of nodes has at most one arc each way
+    HierarchyArcs *outArcs = &builder->outArcs[from];
+
+    for (uint32_t i=0; i<outArcs->count; i++) {
+        if (outArcs->arcs[i].node == to) {
+            if (cost < outArcs->arcs[i].cost) {
+                outArcs->arcs[i].cost = cost;
+                outArcs->arcs[i].middle = middle;
+
+                HierarchyArcs *inArcs = &builder->inArcs[to];
+                for (uint32_t j=0; j<inArcs->count; j++) {
+                    if (inArcs->arcs[j].node == from) {
+                        inArcs->arcs[j].cost = cost;
+                        inArcs->arcs[j].middle = middle;
+                        break;
+                    }
+                }
+            }
+            return;
+        }
+    }
+
+    HierarchyArcsAdd(outArcs, to, middle, cost);
+    HierarchyArcsAdd(&builder->inArcs[to], from, middle, cost);
+}
+
+static void RunWitnessSearch(HierarchyBuilder *builder, uint32_t source, uint32_t excluded, float maxCost, size_t settleLimit)
+{
+    // Dijkstra over the remaining graph without the node being contracted, bounded by cost and by the number of settled nodes
+    HierarchyHeap *heap = &builder->witnessHeap;
+    size_t settled = 0;
+
+    if (++builder->witnessGeneration == 0) {
+        memset(builder->witnessGenerations, 0, builder->nodeCount * sizeof(uint32_t));
+        builder->witnessGeneration = 1;
+    }
+
+    heap->count = 0;
+    builder->witnessGenerations[source] = builder->witnessGeneration;
+    builder->witnessCosts[source] = 0;
+    HierarchyHeapPush(heap, 0, source);
+
+    while (heap->count > 0) {
+        const HierarchyHeapEntry entry = HierarchyHeapPop(heap);
+
+        if (entry.key > builder->witnessCosts[entry.node]) {
+            continue;
+        }
+        if (entry.key > maxCost || ++settled > settleLimit) {
+            break;
+        }
+
+        const HierarchyArcs *arcs = &builder->outArcs[entry.node];
+        for (uint32_t i=0; i<arcs->count; i++) {
+            const uint32_t node = arcs->arcs[i].node;
+            const float cost = entry.key + arcs->arcs[i].cost;
+
+            if (node != excluded && !builder->contracted[node] && (builder->witnessGenerations[node] != builder->witnessGeneration || cost < builder->witnessCosts[node])) {
+                builder->witnessGenerations[node] = builder->witnessGeneration;
+                builder->witnessCosts[node] = cost;
+                HierarchyHeapPush(heap, cost, node);
+            }
+        }
+    }
+}
+
+static size_t ContractHierarchyNode(HierarchyBuilder *builder, uint32_t node, int simulate)
+{
+    // every path in -> node -> out that has no witness path of at most the same cost around node needs a shortcut
+    const HierarchyArcs *inArcs = &builder->inArcs[node];
+    const HierarchyArcs *outArcs = &builder->outArcs[node];
+    size_t shortcutCount = 0;
+    float maxOutCost = 0;
+
+    for (uint32_t j=0; j<outArcs->count; j++) {
+        if (!builder->contracted[outArcs->arcs[j].node] && outArcs->arcs[j].cost > maxOutCost) {
+            maxOutCost = outArcs->arcs[j].cost;
+        }
+    }
+
+    for (uint32_t i=0; i<inArcs->count; i++) {
+        const HierarchyArc in = inArcs->arcs[i];
+
+        if (builder->contracted[in.node]) {
+            continue;
+        }
+
+        RunWitnessSearch(builder, in.node, node, in.cost + maxOutCost, simulate? HierarchySimulationLimit : HierarchyContractionLimit);
+
+        for (uint32_t j=0; j<outArcs->count; j++) {
+            const HierarchyArc out = outArcs->arcs[j];
+            const float cost = in.cost + out.cost;
+
+            if (out.node == in.node || builder->contracted[out.node]) {
+                continue;
+            }
+
+            if (builder->witnessGenerations[out.node] == builder->witnessGeneration && builder->witnessCosts[out.node] <= cost * HierarchyWitnessSlack) {
+                continue;
+            }
+
+            shortcutCount++;
+            if (!simulate) {
+                AddHierarchyArc(builder, in.node, out.node, node, cost);
+            }
+        }
+    }
+
+    return shortcutCount;
+}
+
+static inline void HierarchyRaiseLevel(HierarchyBuilder *builder, uint32_t neighbor, uint32_t node)
+{
+    if (builder->levels[neighbor] < builder->levels[node] + 1) {
+        builder->levels[neighbor] = builder->levels[node] + 1;
+    }
+}
+
+static float HierarchyNodePriority(HierarchyBuilder *builder, uint32_t node)
+{
+    // shortcuts added per arc removed, plus the level of the node in the hierarchy, which spreads the contraction
+    // evenly over the graph and keeps the up and down searches shallow
+    size_t arcCount = 0;
+
+    for (uint32_t i=0; i<builder->inArcs[node].count; i++) {
+        arcCount += !builder->contracted[builder->inArcs[node].arcs[i].node];
+    }
+    for (uint32_t i=0; i<builder->outArcs[node].count; i++) {
+        arcCount += !builder->contracted[builder->outArcs[node].arcs[i].node];
+    }
+
+    return (float)ContractHierarchyNode(builder, node, 1) / (float)(arcCount? arcCount : 1) * 4 + (float)builder->levels[node];
+}
+
+static int CompareHierarchyEdges(const void *a, const void *b)
+{
+    const HierarchyEdge *edgeA = a;
+    const HierarchyEdge *edgeB = b;
+
+    if (edgeA->from != edgeB->from) {
+        return (edgeA->from < edgeB->from)? -1 : 1;
+    }
+    return (edgeA->to < edgeB->to)? -1 : (edgeA->to > edgeB->to);
+}
+
+static void BuildHierarchyGraph(struct __ASGraph *graph, uint32_t **middles, uint32_t nodeCount, const HierarchyEdges *edges, const uint32_t *ranks)
+{
+    for (size_t i=0; i<edges->count; i++) {
+        HierarchyEdge *edge = &edges->edges[i];
+        edge->from = ranks[edge->from];
+        edge->to = ranks[edge->to];
+        if (edge->middle != ASNodeIDNull) {
+            edge->middle = ranks[edge->middle];
+        }
+    }
+
+    // same layout as ASGraphCreateWithEdges(), but every row is sorted by target so path unpacking can binary search it
+    if (edges->count > 0) {
+        qsort(edges->edges, edges->count, sizeof(HierarchyEdge), CompareHierarchyEdges);
+    }
+
+    graph->nodeCount = nodeCount;
+    graph->edgeCount = (uint32_t)edges->count;
+    graph->edgeOffsets = calloc((size_t)nodeCount + 1, sizeof(uint32_t));
+    graph->edgeTargets = malloc((edges->count + 1) * sizeof(uint32_t));
+    graph->edgeCosts = malloc((edges->count + 1) * sizeof(float));
+    graph->heuristicScale = 1;
+    *middles = malloc((edges->count + 1) * sizeof(uint32_t));
+
+    for (size_t i=0; i<edges->count; i++) {
+        graph->edgeOffsets[edges->edges[i].from + 1]++;
+    }
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+        graph->edgeOffsets[n + 1] += graph->edgeOffsets[n];
+    }
+
+    uint32_t *next = malloc((size_t)nodeCount * sizeof(uint32_t));
+    memcpy(next, graph->edgeOffsets, (size_t)nodeCount * sizeof(uint32_t));
+
+    for (size_t i=0; i<edges->count; i++) {
+        const uint32_t edge = next[edges->edges[i].from]++;
+        graph->edgeTargets[edge] = edges->edges[i].to;
+        graph->edgeCosts[edge] = edges->edges[i].cost;
+        (*middles)[edge] = edges->edges[i].middle;
+    }
+
+    free(next);
+}
+
+static inline float GetHierarchyEdge(ASContractionHierarchy hierarchy, uint32_t fromNode, uint32_t toNode, uint32_t *middle)
+{
+    // nodes are numbered by rank, an edge is kept at its lower ranked end, forward in up or reversed in down,
+    // and the rows are sorted by target
+    const int upward = fromNode < toNode;
+    const struct __ASGraph *graph = upward? &hierarchy->up : &hierarchy->down;
+    const uint32_t node = upward? fromNode : toNode;
+    const uint32_t other = upward? toNode : fromNode;
+    uint32_t low = graph->edgeOffsets[node];
+    uint32_t high = graph->edgeOffsets[node + 1];
+
+    while (low < high) {
+        const uint32_t edge = low + (high - low) / 2;
+        if (graph->edgeTargets[edge] < other) {
+            low = edge + 1;
+        } else {
+            high = edge;
+        }
+    }
+
+    if (low < graph->edgeOffsets[node + 1] && graph->edgeTargets[low] == other) {
+        *middle = (upward? hierarchy->upMiddles : hierarchy->downMiddles)[low];
+        return graph->edgeCosts[low];
+    }
+
+    *middle = ASNodeIDNull;
+    return 0;
+}
+
+static inline int DenseNodeIsStalled(DenseNodes nodes, uint32_t node, const struct __ASGraph *downward)
+{
+    // stall-on-demand: a node that can be reached more cheaply through a higher ranked node the search has already seen
+    // is not on a shortest path of the climbing search, so its edges need not be relaxed
+    const float cost = nodes->records[node].cost;
+
+    for (uint32_t edge=downward->edgeOffsets[node]; edge<downward->edgeOffsets[node + 1]; edge++) {
+        const DenseRecord *record = &nodes->records[downward->edgeTargets[edge]];
+        if (record->generation == nodes->generation && (record->flags & (DenseRecordOpen | DenseRecordClosed)) && record->cost + downward->edgeCosts[edge] < cost) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void UnpackHierarchyPath(ASContractionHierarchy hierarchy, const uint32_t *hierarchyNodes, size_t hierarchyCount, ASNeighborList list)
+{
+    // every shortcut is replaced by the two edges it bypasses until only edges of the original graph are left
+    // the path node ids and their costs from the start are collected in list
+    // the stack of edges left to unpack counts against the workspace's memory while it exists, running out stops the search as out of memory
+    SearchMemory unlimited = {0};
+    SearchMemory *memory = list->memory? list->memory : &unlimited;
+    const size_t entrySize = 2 * sizeof(uint32_t);
+    size_t stackCapacity = 0;
+    size_t stackCount = 0;
+    uint32_t *stack = GrowSearchBuffer(memory, NULL, &stackCapacity, entrySize);
+    float cost = 0;
+
+    NeighborListBind(list, sizeof(uint32_t));
+    ASNeighborListAddID(list, hierarchy->nodes[hierarchyNodes[0]], 0);
+
+    for (size_t i=1; stack && i<hierarchyCount && !memory->exceeded; i++) {
+        stack[0] = hierarchyNodes[i - 1];
+        stack[1] = hierarchyNodes[i];
+        stackCount = 1;
+
+        while (stackCount > 0 && !memory->exceeded) {
+            stackCount--;
+            const uint32_t fromNode = stack[2 * stackCount];
+            const uint32_t toNode = stack[2 * stackCount + 1];
+            uint32_t middle;
+            const float edgeCost = GetHierarchyEdge(hierarchy, fromNode, toNode, &middle);
+
+            if (middle == ASNodeIDNull) {
+                cost += edgeCost;
+                ASNeighborListAddID(list, hierarchy->nodes[toNode], cost);
+                continue;
+            }
+
+            while (stackCount + 2 > stackCapacity && !memory->exceeded) {
+                uint32_t *grown = GrowSearchBuffer(memory, stack, &stackCapacity, entrySize);
+                stack = grown? grown : stack;
+            }
+            if (memory->exceeded) {
+                break;
+            }
+
+            // the first half goes on top so the nodes come out in path order
+            stack[2 * stackCount] = middle;
+            stack[2 * stackCount + 1] = toNode;
+            stack[2 * stackCount + 2] = fromNode;
+            stack[2 * stackCount + 3] = middle;
+            stackCount += 2;
+        }
+    }
+
+    free(stack);
+    memory->used -= stackCapacity * entrySize;
+}
+
+/********************************************/
+
+ASContractionHierarchy ASContractionHierarchyCreate(ASGraph graph)
+{
+    if (!graph) {
+        return NULL;
+    }
+
+    const uint32_t nodeCount = graph->nodeCount;
+    HierarchyBuilder builder = {0};
+    builder.nodeCount = nodeCount;
+    builder.outArcs = calloc(nodeCount, sizeof(HierarchyArcs));
+    builder.inArcs = calloc(nodeCount, sizeof(HierarchyArcs));
+    builder.contracted = calloc(nodeCount, sizeof(uint8_t));
+    builder.levels = calloc(nodeCount, sizeof(uint32_t));
+    builder.witnessGenerations = calloc(nodeCount, sizeof(uint32_t));
+    builder.witnessCosts = malloc(nodeCount * sizeof(float));
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+        for (uint32_t edge=graph->edgeOffsets[n]; edge<graph->edgeOffsets[n + 1]; edge++) {
+            if (graph->edgeTargets[edge] != n) {
+                AddHierarchyArc(&builder, n, graph->edgeTargets[edge], ASNodeIDNull, graph->edgeCosts[edge]);
+            }
+        }
+    }
+
+    ASContractionHierarchy hierarchy = calloc(1, sizeof(struct __ASContractionHierarchy));
+    hierarchy->nodeCount = nodeCount;
+    // ranks are filled in as the nodes are contracted, zeroed so no entry is ever read uninitialized
+    hierarchy->ranks = calloc(nodeCount, sizeof(uint32_t));
+    hierarchy->nodes = malloc(nodeCount * sizeof(uint32_t));
+
+    HierarchyEdges upEdges = {0};
+    HierarchyEdges downEdges = {0};
+    HierarchyHeap order = {0};
+    uint32_t rank = 0;
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+        HierarchyHeapPush(&order, HierarchyNodePriority(&builder, n), n);
+    }
+
+    // lazy updates: a node's priority is recomputed when it surfaces and it goes back in if it is no longer the lowest
+    while (order.count > 0) {
+        const HierarchyHeapEntry entry = HierarchyHeapPop(&order);
+        const uint32_t node = entry.node;
+        const float priority = HierarchyNodePriority(&builder, node);
+
+        if (order.count > 0 && priority > order.entries[0].key) {
+            HierarchyHeapPush(&order, priority, node);
+            continue;
+        }
+
+        // the arcs that are left all lead to nodes contracted later, so they are final
+        const HierarchyArcs *outArcs = &builder.outArcs[node];
+        const HierarchyArcs *inArcs = &builder.inArcs[node];
+
+        for (uint32_t i=0; i<outArcs->count; i++) {
+            if (!builder.contracted[outArcs->arcs[i].node]) {
+                HierarchyEdgesAdd(&upEdges, node, outArcs->arcs[i].node, outArcs->arcs[i].middle, outArcs->arcs[i].cost);
+                HierarchyRaiseLevel(&builder, outArcs->arcs[i].node, node);
+            }
+        }
+        for (uint32_t i=0; i<inArcs->count; i++) {
+            if (!builder.contracted[inArcs->arcs[i].node]) {
+                HierarchyEdgesAdd(&downEdges, node, inArcs->arcs[i].node, inArcs->arcs[i].middle, inArcs->arcs[i].cost);
+                HierarchyRaiseLevel(&builder, inArcs->arcs[i].node, node);
+            }
+        }
+
+        hierarchy->shortcutCount += ContractHierarchyNode(&builder, node, 0);
+        builder.contracted[node] = 1;
+        hierarchy->ranks[node] = rank++;
+
+        // the node leaves the remaining graph, so later witness searches and priorities do not walk its arcs again
+        for (uint32_t i=0; i<outArcs->count; i++) {
+            HierarchyArcsRemove(&builder.inArcs[outArcs->arcs[i].node], node);
+        }
+        for (uint32_t i=0; i<inArcs->count; i++) {
+            HierarchyArcsRemove(&builder.outArcs[inArcs->arcs[i].node], node);
+        }
+    }
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+        hierarchy->nodes[hierarchy->ranks[n]] = n;
+    }
+
+    BuildHierarchyGraph(&hierarchy->up, &hierarchy->upMiddles, nodeCount, &upEdges, hierarchy->ranks);
+    BuildHierarchyGraph(&hierarchy->down, &hierarchy->downMiddles, nodeCount, &downEdges, hierarchy->ranks);
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+        free(builder.outArcs[n].arcs);
+        free(builder.inArcs[n].arcs);
+    }
+    free(builder.outArcs);
+    free(builder.inArcs);
+    free(builder.contracted);
+    free(builder.levels);
+    free(builder.witnessGenerations);
+    free(builder.witnessCosts);
+    free(builder.witnessHeap.entries);
+    free(order.entries);
+    free(upEdges.edges);
+    free(downEdges.edges);
+
+    return hierarchy;
+}
+
+size_t ASContractionHierarchyGetShortcutCount(ASContractionHierarchy hierarchy)
+{
+    return hierarchy? hierarchy->shortcutCount : 0;
+}
+
+size_t ASContractionHierarchyGetMemorySize(ASContractionHierarchy hierarchy)
+{
+    if (!hierarchy) {
+        return 0;
+    }
+
+    const size_t edgeCount = (size_t)hierarchy->up.edgeCount + hierarchy->down.edgeCount;
+    return sizeof(struct __ASContractionHierarchy) + hierarchy->nodeCount * sizeof(uint32_t) * 4 + edgeCount * (2 * sizeof(uint32_t) + sizeof(float));
+}
+
+void ASContractionHierarchyDestroy(ASContractionHierarchy hierarchy)
+{
+    if (hierarchy) {
+        free(hierarchy->ranks);
+        free(hierarchy->nodes);
+        free(hierarchy->up.edgeOffsets);
+        free(hierarchy->up.edgeTargets);
+        free(hierarchy->up.edgeCosts);
+        free(hierarchy->upMiddles);
+        free(hierarchy->down.edgeOffsets);
+        free(hierarchy->down.edgeTargets);
+        free(hierarchy->down.edgeCosts);
+        free(hierarchy->downMiddles);
+        free(hierarchy);
+    }
+}
+
+ASPath ASPathCreateWithContractionHierarchy(ASSearchWorkspace workspace, ASContractionHierarchy hierarchy, uint32_t startNode, uint32_t goalNode)
+{
+    if (!workspace || !hierarchy || startNode >= hierarchy->nodeCount || goalNode >= hierarchy->nodeCount) {
+        return NULL;
+    }
+
+    const double begin = BeginSearch(workspace);
+    DenseNodes forward = &workspace->denseNodes;
+    DenseNodes backward = &workspace->reverseDenseNodes;
+    ASNeighborList neighborList = &workspace->neighborList;
+    const int forwardPrepared = DenseNodesBind(forward, NULL, &hierarchy->up, NULL, &workspace->options);
+    const int backwardPrepared = DenseNodesBind(backward, NULL, &hierarchy->down, NULL, &workspace->options);
+
+    if (!forwardPrepared || !backwardPrepared) {
+        FinishDenseSearch(workspace, begin, forward, backward);
+        return NULL;
+    }
+
+    // the search runs on ranks, UnpackHierarchyPath() turns them back into node ids
+    const uint32_t start = hierarchy->ranks[startNode];
+    const uint32_t goal = hierarchy->ranks[goalNode];
+    forward->opposite = backward;
+    backward->opposite = forward;
+    forward->meetCost = backward->meetCost = (start == goal)? 0 : INFINITY;
+    forward->meetNode = backward->meetNode = (start == goal)? start : ASNodeIDNull;
+
+    GetDenseRecord(forward, start);
+    forward->records[start].estimatedCost = 0;
+    forward->records[start].flags |= DenseRecordHasEstimatedCost;
+    AddDenseNodeToOpenSet(forward, start, 0, ASNodeIDNull);
+
+    GetDenseRecord(backward, goal);
+    backward->records[goal].estimatedCost = 0;
+    backward->records[goal].flags |= DenseRecordHasEstimatedCost;
+    AddDenseNodeToOpenSet(backward, goal, 0, ASNodeIDNull);
+
+    // both halves only climb, so they may meet at a node that neither settles first -- each half runs until its lowest cost reaches the best meeting
+    for (;;) {
+        const float meetCost = fminf(forward->meetCost, backward->meetCost);
+        const int forwardOpen = HasDenseOpenNode(forward) && GetDenseRank(forward, GetDenseOpenNode(forward)) < meetCost;
+        const int backwardOpen = HasDenseOpenNode(backward) && GetDenseRank(backward, GetDenseOpenNode(backward)) < meetCost;
+
+        if (workspace->memory.exceeded || (!forwardOpen && !backwardOpen)) {
+            break;
+        }
+
+        const int expandForward = forwardOpen && (!backwardOpen || GetDenseRank(forward, GetDenseOpenNode(forward)) <= GetDenseRank(backward, GetDenseOpenNode(backward)));
+        const DenseNodes nodes = expandForward? forward : backward;
+        const uint32_t current = GetDenseOpenNode(nodes);
+
+        // the edges into a node from above are the other half's edges, reversed
+        if (DenseNodeIsStalled(nodes, current, expandForward? &hierarchy->down : &hierarchy->up)) {
+            RemoveDenseNodeFromOpenSet(nodes, current);
+            nodes->records[current].flags |= DenseRecordClosed;
+        } else {
+            ExpandDenseNode(nodes, neighborList, current, current);
+        }
+    }
+
+    const uint32_t meetNode = (forward->meetCost <= backward->meetCost)? forward->meetNode : backward->meetNode;
+    ASPath path = NULL;
+
+    if (meetNode != ASNodeIDNull && !workspace->memory.exceeded) {
+        // the path in the hierarchy runs up from the start to meetNode and down again to the goal
+        size_t forwardCount = 0;
+        size_t hierarchyCount = 0;
+        for (uint32_t n = meetNode; n != ASNodeIDNull; n = forward->records[n].parent) {
+            forwardCount++;
+        }
+        hierarchyCount = forwardCount;
+        for (uint32_t n = backward->records[meetNode].parent; n != ASNodeIDNull; n = backward->records[n].parent) {
+            hierarchyCount++;
+        }
+
+        // the path is counted against the memory limit like the unpack stack, while it exists
+        const size_t hierarchyBytes = hierarchyCount * sizeof(uint32_t);
+        uint32_t *hierarchyNodes = TakeSearchMemory(&workspace->memory, hierarchyBytes)? malloc(hierarchyBytes) : NULL;
+        if (hierarchyNodes) {
+            size_t i = forwardCount;
+            for (uint32_t n = meetNode; n != ASNodeIDNull; n = forward->records[n].parent) {
+                hierarchyNodes[--i] = n;
+            }
+            i = forwardCount;
+            for (uint32_t n = backward->records[meetNode].parent; n != ASNodeIDNull; n = backward->records[n].parent) {
+                hierarchyNodes[i++] = n;
+            }
+
+            UnpackHierarchyPath(hierarchy, hierarchyNodes, hierarchyCount, neighborList);
+            free(hierarchyNodes);
+            workspace->memory.used -= hierarchyBytes;
+        } else if (!workspace->memory.exceeded) {
+            // malloc failed without the limit being hit
+            workspace->memory.used -= hierarchyBytes;
+            workspace->memory.exceeded = 1;
+        }
+
+        // the neighbor list holds the unpacked path, which is incomplete if it ran out of memory
+        if (!workspace->memory.exceeded) {
+            path = ASPathAlloc(sizeof(uint32_t), neighborList->count);
+            if (path) {
+                memcpy(path->costs, neighborList->costs, neighborList->count * sizeof(float));
+                memcpy(path->nodeKeys, neighborList->nodeKeys, neighborList->count * sizeof(uint32_t));
+            } else {
+                workspace->memory.exceeded = 1;
+            }
+        }
+    }
+
+    FinishDenseSearch(workspace, begin, forward, backward);
+    forward->opposite = NULL;
+    backward->opposite = NULL;
+
+    return path;
+}
@@ -0,0 +1,300 @@
+/*
+ Copyright (c) 2012, Sean Heber. All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ 1. Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ 
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ 3. Neither the name of Sean Heber nor the names of its contributors may
+ be used to endorse or promote products derived from this software without
+ specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL SEAN HEBER BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "AStarPrivate.h"
+#include <string.h>
+
+// a compressed path database: for every source node, the index of the first edge of a cheapest path to every target, in
+// runs of targets with the same first move -- nearby targets are mostly reached through the same edge, so a row of nodeCount
+// moves shrinks to a few runs and a query is a binary search per step along the path, without any search state
+// where several first moves are equally cheap, a run is extended for as long as one move suits all of its targets, and targets
+// that nothing can reach except themselves (no incoming edges, e.g. blocked cells) fit any run -- queries to them fail up front
+// runs are stored as (first target << 8) | move, so a row is searched with plain integer compares
+
+#define FirstMoveNone       0xFF        // no path to the target
+#define FirstMoveMaxNodes   (1u << 24)
+#define FirstMoveMaxEdges   63          // out-edges a node may have, each row keeps the cheapest moves to a target as bits of a word
+#define FirstMoveNoneBit    (1ull << FirstMoveMaxEdges)
+#define FirstMoveAny        UINT64_MAX
+
+struct __ASFirstMoveTable {
+    ASGraph graph;
+    uint32_t nodeCount;
+    size_t *runOffsets;                 // nodeCount + 1 entries, the runs of source n are runOffsets[n] up to runOffsets[n + 1]
+    uint32_t *runs;
+    uint8_t *reachable;                 // bit n is set if node n has an incoming edge
+};
+
+typedef struct {
+    ASGraph graph;
+    const uint8_t *reachable;
+    uint32_t **rows;                    // runs of every source, joined into one array once all are built
+    uint32_t *rowCounts;
+} FirstMoveBuild;
+
+/********************************************/
+
+static inline int FirstMoveReachable(const uint8_t *reachable, uint32_t node)
+{
+    return (reachable[node >> 3] >> (node & 7)) & 1;
+}
+
+static inline uint8_t FirstMoveOf(uint64_t moves)
+{
+    // a run that allows no path only holds unreachable targets or ones that fit any run
+    return (moves & FirstMoveNoneBit)? FirstMoveNone : (uint8_t)__builtin_ctzll(moves);
+}
+
+static void BuildFirstMoveRow(ASSearchWorkspace workspace, uint32_t source, void *context)
+{
+    const FirstMoveBuild *build = context;
+    const struct __ASGraph *graph = build->graph;
+    const uint32_t nodeCount = graph->nodeCount;
+    float *distances = malloc(nodeCount * sizeof(float));
+    uint32_t *hops = malloc(nodeCount * sizeof(uint32_t));
+    uint32_t *queue = malloc(nodeCount * sizeof(uint32_t));
+    uint64_t *moves = malloc(nodeCount * sizeof(uint64_t));
+    uint32_t *row = malloc(((size_t)nodeCount + 1) * sizeof(uint32_t));
+    uint32_t rowCount = 0;
+
+    ASGraphComputeDistances(workspace, build->graph, source, 0, distances);
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+        moves[n] = FirstMoveReachable(build->reachable, n)? FirstMoveNoneBit : FirstMoveAny;
+        hops[n] = UINT32_MAX;
+    }
+
+    // cheapest paths that tie in cost are told apart by their number of edges, from a breadth first search over the edges of
+    // cheapest paths -- so every step of a walk gets one edge closer to its goal, zero cost edges included, and cannot loop
+    // the distances are the sums the search itself computed, so the edges of its search tree compare exactly equal
+    size_t queueCount = 1;
+    queue[0] = source;
+    hops[source] = 0;
+    for (size_t i=0; i<queueCount; i++) {
+        const uint32_t node = queue[i];
+
+        for (uint32_t edge=graph->edgeOffsets[node]; edge<graph->edgeOffsets[node + 1]; edge++) {
+            const uint32_t target = graph->edgeTargets[edge];
+            if (hops[target] == UINT32_MAX && distances[node] + graph->edgeCosts[edge] == distances[target]) {
+                hops[target] = hops[node] + 1;
+                moves[target] = 0;
+                queue[queueCount++] = target;
+            }
+        }
+    }
+
+    // in that order, every node hands its cheapest first moves on to the nodes one edge further along cheapest paths
+    moves[source] = FirstMoveAny;
+    for (size_t i=0; i<queueCount; i++) {
+        const uint32_t node = queue[i];
+
+        for (uint32_t edge=graph->edgeOffsets[node]; edge<graph->edgeOffsets[node + 1]; edge++) {
+            const uint32_t target = graph->edgeTargets[edge];
+            if (hops[target] == hops[node] + 1 && distances[node] + graph->edgeCosts[edge] == distances[target]) {
+                moves[target] |= (node == source)? 1ull << (edge - graph->edgeOffsets[source]) : moves[node];
+            }
+        }
+    }
+
+    // greedy runs: a run goes on while some move is among the cheapest for all of its targets
+    uint64_t runMoves = FirstMoveAny;
+    uint32_t runStart = 0;
+    for (uint32_t target=0; target<nodeCount; target++) {
+        if ((runMoves & moves[target]) == 0) {
+            row[rowCount++] = (runStart << 8) | FirstMoveOf(runMoves);
+            runStart = target;
+            runMoves = moves[target];
+        } else {
+            runMoves &= moves[target];
+        }
+    }
+    row[rowCount++] = (runStart << 8) | FirstMoveOf(runMoves);
+
+    build->rows[source] = realloc(row, rowCount * sizeof(uint32_t));
+    build->rowCounts[source] = rowCount;
+
+    free(moves);
+    free(queue);
+    free(hops);
+    free(distances);
+}
+
+static inline uint8_t GetFirstMove(ASFirstMoveTable table, uint32_t node, uint32_t goalNode)
+{
+    // the last run that starts at or before the goal
+    const uint32_t *runs = table->runs + table->runOffsets[node];
+    const uint32_t key = (goalNode << 8) | 0xFF;
+    size_t low = 0;
+    size_t high = table->runOffsets[node + 1] - table->runOffsets[node];
+
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+        if (runs[middle] <= key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low? (uint8_t)runs[low - 1] : FirstMoveNone;
+}
+
+/********************************************/
+
+ASFirstMoveTable ASFirstMoveTableCreate(ASGraph graph, ASSearchPool pool)
+{
+    if (!graph || graph->nodeCount > FirstMoveMaxNodes) {
+        return NULL;
+    }
+
+    const uint32_t nodeCount = graph->nodeCount;
+    for (uint32_t n=0; n<nodeCount; n++) {
+        if (graph->edgeOffsets[n + 1] - graph->edgeOffsets[n] > FirstMoveMaxEdges) {
+            return NULL;
+        }
+    }
+
+    uint8_t *reachable = calloc(((size_t)nodeCount + 7) / 8, sizeof(uint8_t));
+    for (uint32_t edge=0; edge<graph->edgeOffsets[nodeCount]; edge++) {
+        reachable[graph->edgeTargets[edge] >> 3] |= 1 << (graph->edgeTargets[edge] & 7);
+    }
+
+    FirstMoveBuild build = {graph, reachable, calloc(nodeCount, sizeof(uint32_t *)), calloc(nodeCount, sizeof(uint32_t))};
+    if (!SearchPoolRun(pool, nodeCount, &BuildFirstMoveRow, &build)) {
+        free(build.rows);
+        free(build.rowCounts);
+        free(reachable);
+        return NULL;
+    }
+
+    ASFirstMoveTable table = calloc(1, sizeof(struct __ASFirstMoveTable));
+    table->graph = graph;
+    table->nodeCount = nodeCount;
+    table->reachable = reachable;
+    table->runOffsets = malloc(((size_t)nodeCount + 1) * sizeof(size_t));
+    table->runOffsets[0] = 0;
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+        table->runOffsets[n + 1] = table->runOffsets[n] + build.rowCounts[n];
+    }
+
+    table->runs = malloc((table->runOffsets[nodeCount] + 1) * sizeof(uint32_t));
+    for (uint32_t n=0; n<nodeCount; n++) {
+        memcpy(table->runs + table->runOffsets[n], build.rows[n], build.rowCounts[n] * sizeof(uint32_t));
+        free(build.rows[n]);
+    }
+
+    free(build.rows);
+    free(build.rowCounts);
+
+    return table;
+}
+
+size_t ASFirstMoveTableGetRunCount(ASFirstMoveTable table)
+{
+    return table? table->runOffsets[table->nodeCount] : 0;
+}
+
+size_t ASFirstMoveTableGetMemorySize(ASFirstMoveTable table)
+{
+    if (!table) {
+        return 0;
+    }
+
+    return sizeof(struct __ASFirstMoveTable) + ((size_t)table->nodeCount + 1) * sizeof(size_t) + table->runOffsets[table->nodeCount] * sizeof(uint32_t) + ((size_t)table->nodeCount + 7) / 8;
+}
+
+void ASFirstMoveTableDestroy(ASFirstMoveTable table)
+{
+    if (table) {
+        free(table->runOffsets);
+        free(table->runs);
+        free(table->reachable);
+        free(table);
+    }
+}
+
+uint32_t ASFirstMoveTableGetNextNode(ASFirstMoveTable table, uint32_t node, uint32_t goalNode)
+{
+    if (!table || node >= table->nodeCount || goalNode >= table->nodeCount) {
+        return ASNodeIDNull;
+    }
+    if (node == goalNode) {
+        return goalNode;
+    }
+
+    const uint8_t move = FirstMoveReachable(table->reachable, goalNode)? GetFirstMove(table, node, goalNode) : FirstMoveNone;
+    return (move == FirstMoveNone)? ASNodeIDNull : table->graph->edgeTargets[table->graph->edgeOffsets[node] + move];
+}
+
+ASPath ASPathCreateWithFirstMoveTable(ASFirstMoveTable table, uint32_t startNode, uint32_t goalNode)
+{
+    if (!table || startNode >= table->nodeCount || goalNode >= table->nodeCount) {
+        return NULL;
+    }
+
+    if (startNode != goalNode && !FirstMoveReachable(table->reachable, goalNode)) {
+        return NULL;
+    }
+
+    const struct __ASGraph *graph = table->graph;
+    uint32_t node = startNode;
+    size_t count = 1;
+
+    // the first walk counts the steps, the second one fills in the path -- a walk longer than the graph would be a loop, which
+    // rounding of long sums of tiny costs could make possible
+    while (node != goalNode) {
+        const uint8_t move = GetFirstMove(table, node, goalNode);
+        if (move == FirstMoveNone || count > table->nodeCount) {
+            return NULL;
+        }
+        node = graph->edgeTargets[graph->edgeOffsets[node] + move];
+        count++;
+    }
+
+    ASPath path = ASPathAlloc(sizeof(uint32_t), count);
+    if (!path) {
+        return NULL;
+    }
+    uint32_t *nodes = path->nodeKeys;
+    float cost = 0;
+    node = startNode;
+    nodes[0] = startNode;
+    path->costs[0] = 0;
+
+    for (size_t i=1; i<count; i++) {
+        const uint32_t edge = graph->edgeOffsets[node] + GetFirstMove(table, node, goalNode);
+        cost += graph->edgeCosts[edge];
+        node = graph->edgeTargets[edge];
+        nodes[i] = node;
+        path->costs[i] = cost;
+    }
+
+    return path;
+}
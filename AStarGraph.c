@@ -0,0 +1,900 @@
+/*
+ Copyright (c) 2012, Sean Heber. All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ 1. Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ 
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ 3. Neither the name of Sean Heber nor the names of its contributors may
+ be used to endorse or promote products derived from this software without
+ specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL SEAN HEBER BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "AStarPrivate.h"
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// graph files start with a header and a table of sections, each section is one array of the graph
+// offsets are from the start of the file, so the file can be mapped at any address
+#define GraphFileVersion    1
+#define GraphFileByteOrder  0x01020304
+#define GraphFileAlignment  64
+
+static const char GraphFileMagic[8] = "ASGRAPH";
+
+typedef enum {
+    GraphSectionEdgeOffsets = 1,
+    GraphSectionEdgeTargets,
+    GraphSectionEdgeCosts,
+    GraphSectionPositions,
+    GraphSectionReverseEdgeOffsets,
+    GraphSectionReverseEdgeTargets,
+    GraphSectionReverseEdgeCosts,
+    GraphSectionLandmarks,
+    GraphSectionLandmarkFrom,
+    GraphSectionLandmarkTo,
+    GraphSectionOriginalIDs,
+    GraphSectionReorderedIDs,
+} GraphSectionKind;
+
+#define GraphSectionKindCount 12
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;                 // GraphFileByteOrder as stored by the writer
+    uint32_t nodeCount;
+    uint32_t edgeCount;
+    uint32_t heuristic;
+    float heuristicScale;
+    uint32_t sectionCount;
+    uint32_t reserved;
+} GraphFileHeader;
+
+typedef struct {
+    uint32_t kind;                      // readers skip kinds they do not know
+    uint32_t reserved;
+    uint64_t offset;                    // a multiple of GraphFileAlignment
+    uint64_t size;
+} GraphFileSection;
+
+static ASGraph GraphAlloc(uint32_t nodeCount, size_t edgeCount)
+{
+    ASGraph graph = calloc(1, sizeof(struct __ASGraph));
+    graph->nodeCount = nodeCount;
+    graph->edgeCount = (uint32_t)edgeCount;
+    graph->edgeOffsets = calloc((size_t)nodeCount + 1, sizeof(uint32_t));
+    graph->edgeTargets = malloc(edgeCount * sizeof(uint32_t));
+    graph->edgeCosts = malloc(edgeCount * sizeof(float));
+    graph->heuristicScale = 1;
+    return graph;
+}
+
+static inline int GraphOwnsArray(ASGraph graph, const void *array)
+{
+    const char *mapping = graph->mapping;
+    return !mapping || (const char *)array < mapping || (const char *)array >= mapping + graph->mappingSize;
+}
+
+static inline void GraphFreeArray(ASGraph graph, void *array)
+{
+    if (GraphOwnsArray(graph, array)) {
+        free(array);
+    }
+}
+
+static inline uint64_t GraphFileAlign(uint64_t offset)
+{
+    return (offset + GraphFileAlignment - 1) & ~(uint64_t)(GraphFileAlignment - 1);
+}
+
+static inline int WriteGraphFileBytes(FILE *file, const void *bytes, size_t size, uint64_t *written)
+{
+    *written += size;
+    return size == 0 || fwrite(bytes, 1, size, file) == size;
+}
+
+static inline int WriteGraphFilePadding(FILE *file, uint64_t *written)
+{
+    static const char padding[GraphFileAlignment] = {0};
+    return WriteGraphFileBytes(file, padding, GraphFileAlign(*written) - *written, written);
+}
+
+static void *MapGraphFileSection(void *mapping, size_t mappingSize, const GraphFileSection *section, uint64_t expectedSize)
+{
+    if (section->size != expectedSize || section->offset % GraphFileAlignment || section->offset > mappingSize || section->size > mappingSize - section->offset) {
+        return NULL;
+    }
+    return (char *)mapping + section->offset;
+}
+
+/********************************************/
+
+ASGraph ASGraphCreateWithEdges(uint32_t nodeCount, const ASGraphEdge *edges, size_t edgeCount)
+{
+    if (nodeCount == 0 || nodeCount == ASNodeIDNull || edgeCount > UINT32_MAX || (edgeCount > 0 && !edges)) {
+        return NULL;
+    }
+
+    for (size_t i=0; i<edgeCount; i++) {
+        if (edges[i].from >= nodeCount || edges[i].to >= nodeCount) {
+            return NULL;
+        }
+    }
+
+    ASGraph graph = GraphAlloc(nodeCount, edgeCount);
+
+    // counting sort by source node, edges of the same node keep their order
+    for (size_t i=0; i<edgeCount; i++) {
+        graph->edgeOffsets[edges[i].from + 1]++;
+    }
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+        graph->edgeOffsets[n + 1] += graph->edgeOffsets[n];
+    }
+
+    uint32_t *next = malloc(nodeCount * sizeof(uint32_t));
+    memcpy(next, graph->edgeOffsets, nodeCount * sizeof(uint32_t));
+
+    for (size_t i=0; i<edgeCount; i++) {
+        const uint32_t edge = next[edges[i].from]++;
+        graph->edgeTargets[edge] = edges[i].to;
+        graph->edgeCosts[edge] = edges[i].cost;
+    }
+
+    free(next);
+
+    return graph;
+}
+
+ASGraph ASGraphCreateWithNodeIDSource(const ASPathNodeIDSource *source, void *context)
+{
+    if (!source || !source->nodeNeighbors || source->nodeCount == 0 || source->nodeCount == ASNodeIDNull) {
+        return NULL;
+    }
+
+    const uint32_t nodeCount = source->nodeCount;
+    struct __ASNeighborList neighborList = {0};
+    size_t edgesCapacity = 0;
+    size_t edgeCount = 0;
+    uint32_t *edgeTargets = NULL;
+    float *edgeCosts = NULL;
+    uint32_t *edgeOffsets = calloc((size_t)nodeCount + 1, sizeof(uint32_t));
+
+    NeighborListBind(&neighborList, sizeof(uint32_t));
+
+    // the nodes are visited in id order, so the edges come out already grouped by source node
+    for (uint32_t n=0; n<nodeCount; n++) {
+        neighborList.count = 0;
+        source->nodeNeighbors(&neighborList, n, 0, n, context);
+
+        const uint32_t *neighborIDs = neighborList.nodeKeys;
+
+        for (size_t i=0; i<neighborList.count; i++) {
+            if (neighborIDs[i] >= nodeCount) {
+                continue;
+            }
+
+            if (edgeCount == edgesCapacity) {
+                edgesCapacity = 1 + (edgesCapacity * 2);
+                edgeTargets = realloc(edgeTargets, edgesCapacity * sizeof(uint32_t));
+                edgeCosts = realloc(edgeCosts, edgesCapacity * sizeof(float));
+            }
+
+            edgeTargets[edgeCount] = neighborIDs[i];
+            edgeCosts[edgeCount] = neighborList.costs[i];
+            edgeCount++;
+        }
+
+        edgeOffsets[n + 1] = (uint32_t)edgeCount;
+    }
+
+    NeighborListFree(&neighborList);
+
+    if (edgeCount > UINT32_MAX) {
+        free(edgeOffsets);
+        free(edgeTargets);
+        free(edgeCosts);
+        return NULL;
+    }
+
+    ASGraph graph = calloc(1, sizeof(struct __ASGraph));
+    graph->nodeCount = nodeCount;
+    graph->edgeCount = (uint32_t)edgeCount;
+    graph->edgeOffsets = edgeOffsets;
+    graph->edgeTargets = realloc(edgeTargets, (edgeCount? edgeCount : 1) * sizeof(uint32_t));
+    graph->edgeCosts = realloc(edgeCosts, (edgeCount? edgeCount : 1) * sizeof(float));
+    graph->heuristicScale = 1;
+    return graph;
+}
+
+void ASGraphSetPositions(ASGraph graph, const float *positions, ASGraphHeuristic heuristic, float heuristicScale)
+{
+    if (!graph) {
+        return;
+    }
+
+    if (positions) {
+        if (!GraphOwnsArray(graph, graph->positions)) {
+            graph->positions = NULL;
+        }
+        graph->positions = realloc(graph->positions, (size_t)graph->nodeCount * 2 * sizeof(float));
+        memcpy(graph->positions, positions, (size_t)graph->nodeCount * 2 * sizeof(float));
+        graph->heuristic = heuristic;
+        graph->heuristicScale = heuristicScale;
+    } else {
+        GraphFreeArray(graph, graph->positions);
+        graph->positions = NULL;
+        graph->heuristic = ASGraphHeuristicNone;
+        graph->heuristicScale = 1;
+    }
+}
+
+int ASGraphWriteFile(ASGraph graph, const char *path)
+{
+    if (!graph || !path) {
+        return -1;
+    }
+
+    // indexed by section kind - 1, optional arrays that are NULL are left out
+    const void *arrays[GraphSectionKindCount] = {graph->edgeOffsets, graph->edgeTargets, graph->edgeCosts, graph->positions, graph->reverseEdgeOffsets, graph->reverseEdgeTargets, graph->reverseEdgeCosts, graph->landmarks, graph->landmarkFrom, graph->landmarkTo, graph->originalIDs, graph->reorderedIDs};
+    const uint64_t sizes[GraphSectionKindCount] = {
+        ((uint64_t)graph->nodeCount + 1) * sizeof(uint32_t),
+        (uint64_t)graph->edgeCount * sizeof(uint32_t),
+        (uint64_t)graph->edgeCount * sizeof(float),
+        (uint64_t)graph->nodeCount * 2 * sizeof(float),
+        ((uint64_t)graph->nodeCount + 1) * sizeof(uint32_t),
+        (uint64_t)graph->edgeCount * sizeof(uint32_t),
+        (uint64_t)graph->edgeCount * sizeof(float),
+        (uint64_t)graph->landmarkCount * sizeof(uint32_t),
+        (uint64_t)graph->nodeCount * graph->landmarkStride * sizeof(float),
+        (uint64_t)graph->nodeCount * graph->landmarkStride * sizeof(float),
+        (uint64_t)graph->nodeCount * sizeof(uint32_t),
+        (uint64_t)graph->nodeCount * sizeof(uint32_t),
+    };
+    const int hasReverseEdges = (graph->reverseEdgeOffsets != NULL);
+    const int hasLandmarks = (graph->landmarkCount > 0);
+    const int isReordered = (graph->originalIDs != NULL);
+    const int present[GraphSectionKindCount] = {1, 1, 1, graph->positions != NULL, hasReverseEdges, hasReverseEdges, hasReverseEdges, hasLandmarks, hasLandmarks, hasLandmarks, isReordered, isReordered};
+
+    uint32_t sectionCount = 0;
+    for (uint32_t kind=0; kind<GraphSectionKindCount; kind++) {
+        sectionCount += present[kind];
+    }
+
+    GraphFileHeader header = {{0}, GraphFileVersion, GraphFileByteOrder, graph->nodeCount, graph->edgeCount, graph->heuristic, graph->heuristicScale, sectionCount, 0};
+    memcpy(header.magic, GraphFileMagic, sizeof(header.magic));
+
+    GraphFileSection sections[GraphSectionKindCount];
+    const void *sectionArrays[GraphSectionKindCount];
+    uint64_t offset = sizeof(GraphFileHeader) + sectionCount * sizeof(GraphFileSection);
+    for (uint32_t kind=0, i=0; kind<GraphSectionKindCount; kind++) {
+        if (present[kind]) {
+            offset = GraphFileAlign(offset);
+            sections[i] = (GraphFileSection){GraphSectionEdgeOffsets + kind, 0, offset, sizes[kind]};
+            sectionArrays[i++] = arrays[kind];
+            offset += sizes[kind];
+        }
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return -1;
+    }
+
+    uint64_t written = 0;
+    int ok = WriteGraphFileBytes(file, &header, sizeof(header), &written) && WriteGraphFileBytes(file, sections, sectionCount * sizeof(GraphFileSection), &written);
+    for (uint32_t i=0; ok && i<sectionCount; i++) {
+        ok = WriteGraphFilePadding(file, &written) && WriteGraphFileBytes(file, sectionArrays[i], sections[i].size, &written);
+    }
+
+    if (fclose(file) != 0 || !ok) {
+        remove(path);
+        return -1;
+    }
+
+    return 0;
+}
+
+ASGraph ASGraphOpenFile(const char *path)
+{
+    if (!path) {
+        return NULL;
+    }
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat info;
+    void *mapping = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && (uint64_t)info.st_size >= sizeof(GraphFileHeader)) {
+        mapping = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
+
+    const size_t mappingSize = info.st_size;
+    const GraphFileHeader *header = mapping;
+    const GraphFileSection *sections = (const GraphFileSection *)(header + 1);
+
+    if (memcmp(header->magic, GraphFileMagic, sizeof(header->magic)) != 0 || header->version != GraphFileVersion || header->byteOrder != GraphFileByteOrder ||
+        header->nodeCount == 0 || header->nodeCount == ASNodeIDNull || header->sectionCount > (mappingSize - sizeof(GraphFileHeader)) / sizeof(GraphFileSection)) {
+        munmap(mapping, mappingSize);
+        return NULL;
+    }
+
+    ASGraph graph = calloc(1, sizeof(struct __ASGraph));
+    graph->nodeCount = header->nodeCount;
+    graph->edgeCount = header->edgeCount;
+    graph->heuristicScale = header->heuristicScale;
+    graph->mapping = mapping;
+    graph->mappingSize = mappingSize;
+
+    int valid = 1;
+
+    // the landmark tables are sized by the landmark count, which comes from the size of the landmark list
+    for (uint32_t i=0; i<header->sectionCount; i++) {
+        if (sections[i].kind == GraphSectionLandmarks && sections[i].size / sizeof(uint32_t) < ASNodeIDNull) {
+            graph->landmarkCount = (uint32_t)(sections[i].size / sizeof(uint32_t));
+            graph->landmarkStride = (graph->landmarkCount + 3) & ~3u;
+        }
+    }
+
+    for (uint32_t i=0; valid && i<header->sectionCount; i++) {
+        const GraphFileSection *section = &sections[i];
+
+        switch (section->kind) {
+            case GraphSectionEdgeOffsets:
+                graph->edgeOffsets = MapGraphFileSection(mapping, mappingSize, section, ((uint64_t)graph->nodeCount + 1) * sizeof(uint32_t));
+                break;
+            case GraphSectionEdgeTargets:
+                graph->edgeTargets = MapGraphFileSection(mapping, mappingSize, section, (uint64_t)graph->edgeCount * sizeof(uint32_t));
+                break;
+            case GraphSectionEdgeCosts:
+                graph->edgeCosts = MapGraphFileSection(mapping, mappingSize, section, (uint64_t)graph->edgeCount * sizeof(float));
+                break;
+            case GraphSectionPositions:
+                graph->positions = MapGraphFileSection(mapping, mappingSize, section, (uint64_t)graph->nodeCount * 2 * sizeof(float));
+                valid = (graph->positions != NULL);
+                break;
+            case GraphSectionReverseEdgeOffsets:
+                graph->reverseEdgeOffsets = MapGraphFileSection(mapping, mappingSize, section, ((uint64_t)graph->nodeCount + 1) * sizeof(uint32_t));
+                break;
+            case GraphSectionReverseEdgeTargets:
+                graph->reverseEdgeTargets = MapGraphFileSection(mapping, mappingSize, section, (uint64_t)graph->edgeCount * sizeof(uint32_t));
+                break;
+            case GraphSectionReverseEdgeCosts:
+                graph->reverseEdgeCosts = MapGraphFileSection(mapping, mappingSize, section, (uint64_t)graph->edgeCount * sizeof(float));
+                break;
+            case GraphSectionLandmarks:
+                graph->landmarks = MapGraphFileSection(mapping, mappingSize, section, (uint64_t)graph->landmarkCount * sizeof(uint32_t));
+                break;
+            case GraphSectionLandmarkFrom:
+                graph->landmarkFrom = MapGraphFileSection(mapping, mappingSize, section, (uint64_t)graph->nodeCount * graph->landmarkStride * sizeof(float));
+                break;
+            case GraphSectionLandmarkTo:
+                graph->landmarkTo = MapGraphFileSection(mapping, mappingSize, section, (uint64_t)graph->nodeCount * graph->landmarkStride * sizeof(float));
+                break;
+            case GraphSectionOriginalIDs:
+                graph->originalIDs = MapGraphFileSection(mapping, mappingSize, section, (uint64_t)graph->nodeCount * sizeof(uint32_t));
+                break;
+            case GraphSectionReorderedIDs:
+                graph->reorderedIDs = MapGraphFileSection(mapping, mappingSize, section, (uint64_t)graph->nodeCount * sizeof(uint32_t));
+                break;
+        }
+    }
+
+    // the heuristic reads all three landmark arrays, a graph with only some of them gets none
+    if (graph->landmarkCount > 0 && (!graph->landmarks || !graph->landmarkFrom || !graph->landmarkTo)) {
+        valid = 0;
+    }
+
+    // the reverse edges come as a set of three, or not at all
+    const int reverseCount = (graph->reverseEdgeOffsets != NULL) + (graph->reverseEdgeTargets != NULL) + (graph->reverseEdgeCosts != NULL);
+    if (reverseCount == 3) {
+        valid = valid && graph->reverseEdgeOffsets[0] == 0 && graph->reverseEdgeOffsets[graph->nodeCount] == graph->edgeCount;
+    } else {
+        valid = valid && reverseCount == 0;
+    }
+
+    // so do the two directions of the id mapping
+    valid = valid && (graph->originalIDs != NULL) == (graph->reorderedIDs != NULL);
+
+    if (!valid || !graph->edgeOffsets || !graph->edgeTargets || !graph->edgeCosts || graph->edgeOffsets[0] != 0 || graph->edgeOffsets[graph->nodeCount] != graph->edgeCount) {
+        ASGraphDestroy(graph);
+        return NULL;
+    }
+
+    if (graph->positions && header->heuristic <= ASGraphHeuristicManhattan) {
+        graph->heuristic = header->heuristic;
+    }
+
+    return graph;
+}
+
+void ASGraphBuildReverseEdges(ASGraph graph)
+{
+    if (!graph || graph->reverseEdgeOffsets) {
+        return;
+    }
+
+    graph->reverseEdgeOffsets = calloc((size_t)graph->nodeCount + 1, sizeof(uint32_t));
+    graph->reverseEdgeTargets = malloc(((size_t)graph->edgeCount + 1) * sizeof(uint32_t));
+    graph->reverseEdgeCosts = malloc(((size_t)graph->edgeCount + 1) * sizeof(float));
+
+    // same counting sort as ASGraphCreateWithEdges(), keyed by the edge target
+    for (uint32_t edge=0; edge<graph->edgeCount; edge++) {
+        graph->reverseEdgeOffsets[graph->edgeTargets[edge] + 1]++;
+    }
+
+    for (uint32_t n=0; n<graph->nodeCount; n++) {
+        graph->reverseEdgeOffsets[n + 1] += graph->reverseEdgeOffsets[n];
+    }
+
+    uint32_t *next = malloc((size_t)graph->nodeCount * sizeof(uint32_t));
+    memcpy(next, graph->reverseEdgeOffsets, (size_t)graph->nodeCount * sizeof(uint32_t));
+
+    for (uint32_t n=0; n<graph->nodeCount; n++) {
+        for (uint32_t edge=graph->edgeOffsets[n]; edge<graph->edgeOffsets[n + 1]; edge++) {
+            const uint32_t reverseEdge = next[graph->edgeTargets[edge]]++;
+            graph->reverseEdgeTargets[reverseEdge] = n;
+            graph->reverseEdgeCosts[reverseEdge] = graph->edgeCosts[edge];
+        }
+    }
+
+    free(next);
+}
+
+uint32_t ASGraphBuildLandmarks(ASGraph graph, uint32_t landmarkCount)
+{
+    if (!graph || landmarkCount == 0) {
+        return 0;
+    }
+
+    if (landmarkCount > graph->nodeCount) {
+        landmarkCount = graph->nodeCount;
+    }
+
+    // the tables are replaced, so the old landmarks must not steer the distance searches
+    GraphFreeArray(graph, graph->landmarks);
+    GraphFreeArray(graph, graph->landmarkFrom);
+    GraphFreeArray(graph, graph->landmarkTo);
+    graph->landmarks = NULL;
+    graph->landmarkFrom = NULL;
+    graph->landmarkTo = NULL;
+    graph->landmarkCount = 0;
+
+    // the backward distances need the incoming edges, they are dropped again afterwards unless the graph already had them
+    const int hadReverseEdges = (graph->reverseEdgeOffsets != NULL);
+    ASGraphBuildReverseEdges(graph);
+
+    const size_t nodeCount = graph->nodeCount;
+    const uint32_t stride = (landmarkCount + 3) & ~3u;
+    uint32_t *landmarks = malloc(landmarkCount * sizeof(uint32_t));
+    float *landmarkFrom = calloc(nodeCount * stride, sizeof(float));
+    float *landmarkTo = calloc(nodeCount * stride, sizeof(float));
+    float *distances = malloc(nodeCount * sizeof(float));
+    float *nearest = malloc(nodeCount * sizeof(float));
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    uint32_t count = 0;
+
+    // farthest point selection: the first landmark is the node farthest from node 0, every next one the node farthest from its nearest landmark
+    // a node is as near as the shorter of the two directions, otherwise one-way edges make the nodes right behind a landmark look far away
+    ASGraphComputeDistances(workspace, graph, 0, 0, distances);
+    for (size_t n=0; n<nodeCount; n++) {
+        nearest[n] = distances[n];
+    }
+    ASGraphComputeDistances(workspace, graph, 0, 1, distances);
+    for (size_t n=0; n<nodeCount; n++) {
+        nearest[n] = fminf(nearest[n], distances[n]);
+    }
+
+    while (count < landmarkCount) {
+        uint32_t landmark = ASNodeIDNull;
+        float farthest = 0;
+
+        for (uint32_t n=0; n<nodeCount; n++) {
+            if (nearest[n] < INFINITY && nearest[n] > farthest) {
+                farthest = nearest[n];
+                landmark = n;
+            }
+        }
+
+        for (uint32_t n=0; landmark == ASNodeIDNull && n<nodeCount; n++) {
+            // the nodes reached so far are all landmarks, continue in a part of the graph no landmark reaches
+            if (nearest[n] == INFINITY) {
+                landmark = n;
+            }
+        }
+
+        if (landmark == ASNodeIDNull) {
+            break;
+        }
+
+        landmarks[count] = landmark;
+
+        ASGraphComputeDistances(workspace, graph, landmark, 0, distances);
+        for (size_t n=0; n<nodeCount; n++) {
+            landmarkFrom[n * stride + count] = distances[n];
+            if (distances[n] < nearest[n]) {
+                nearest[n] = distances[n];
+            }
+        }
+
+        ASGraphComputeDistances(workspace, graph, landmark, 1, distances);
+        for (size_t n=0; n<nodeCount; n++) {
+            landmarkTo[n * stride + count] = distances[n];
+            if (distances[n] < nearest[n]) {
+                nearest[n] = distances[n];
+            }
+        }
+
+        count++;
+    }
+
+    ASSearchWorkspaceDestroy(workspace);
+    free(distances);
+    free(nearest);
+
+    if (!hadReverseEdges) {
+        free(graph->reverseEdgeOffsets);
+        free(graph->reverseEdgeTargets);
+        free(graph->reverseEdgeCosts);
+        graph->reverseEdgeOffsets = NULL;
+        graph->reverseEdgeTargets = NULL;
+        graph->reverseEdgeCosts = NULL;
+    }
+
+    if (count == 0) {
+        free(landmarks);
+        free(landmarkFrom);
+        free(landmarkTo);
+        return 0;
+    }
+
+    graph->landmarkCount = count;
+    graph->landmarkStride = stride;
+    graph->landmarks = landmarks;
+    graph->landmarkFrom = landmarkFrom;
+    graph->landmarkTo = landmarkTo;
+    return count;
+}
+
+// rewrites one set of CSR arrays so that node oldIDs[n] becomes n, every node keeps its edges in their order
+static void GraphPermuteEdges(ASGraph graph, uint32_t **offsets, uint32_t **targets, float **costs, const uint32_t *oldIDs, const uint32_t *newIDs)
+{
+    const size_t edgeCount = graph->edgeCount;
+    uint32_t *newOffsets = malloc(((size_t)graph->nodeCount + 1) * sizeof(uint32_t));
+    uint32_t *newTargets = malloc((edgeCount? edgeCount : 1) * sizeof(uint32_t));
+    float *newCosts = malloc((edgeCount? edgeCount : 1) * sizeof(float));
+    uint32_t next = 0;
+
+    for (uint32_t n=0; n<graph->nodeCount; n++) {
+        const uint32_t old = oldIDs[n];
+        newOffsets[n] = next;
+        for (uint32_t edge=(*offsets)[old]; edge<(*offsets)[old + 1]; edge++) {
+            newTargets[next] = newIDs[(*targets)[edge]];
+            newCosts[next++] = (*costs)[edge];
+        }
+    }
+    newOffsets[graph->nodeCount] = next;
+
+    GraphFreeArray(graph, *offsets);
+    GraphFreeArray(graph, *targets);
+    GraphFreeArray(graph, *costs);
+    *offsets = newOffsets;
+    *targets = newTargets;
+    *costs = newCosts;
+}
+
+static uint32_t *GraphPermuteRows(ASGraph graph, uint32_t *rows, size_t rowSize, const uint32_t *oldIDs)
+{
+    // rows of rowSize 4 byte values per node, floats or ids alike
+    uint32_t *newRows = malloc((size_t)graph->nodeCount * rowSize * sizeof(uint32_t));
+
+    for (uint32_t n=0; n<graph->nodeCount; n++) {
+        memcpy(newRows + (size_t)n * rowSize, rows + (size_t)oldIDs[n] * rowSize, rowSize * sizeof(uint32_t));
+    }
+
+    GraphFreeArray(graph, rows);
+    return newRows;
+}
+
+static uint32_t HilbertIndex(uint32_t x, uint32_t y)
+{
+    // position of x, y along the Hilbert curve through a 65536 x 65536 square
+    uint32_t index = 0;
+
+    for (uint32_t s=1u << 15; s>0; s>>=1) {
+        const uint32_t rx = (x & s) > 0;
+        const uint32_t ry = (y & s) > 0;
+        index += s * s * ((3 * rx) ^ ry);
+
+        // rotate the quadrant so the curve inside it starts where the last one ended
+        if (ry == 0) {
+            if (rx == 1) {
+                x = 0xffff - x;
+                y = 0xffff - y;
+            }
+            const uint32_t t = x;
+            x = y;
+            y = t;
+        }
+    }
+
+    return index;
+}
+
+static inline uint32_t MortonSpread(uint32_t v)
+{
+    // moves bit i of a 16 bit value to bit 2i
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+static int CompareKeys(const void *a, const void *b)
+{
+    const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void GraphCurveOrder(ASGraph graph, ASGraphOrder order, uint32_t *oldIDs)
+{
+    // positions are scaled onto a 16 bit grid over their bounding box, ties keep the id order
+    const uint32_t nodeCount = graph->nodeCount;
+    const float *positions = graph->positions;
+    float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+        minX = fminf(minX, positions[2 * n]);
+        maxX = fmaxf(maxX, positions[2 * n]);
+        minY = fminf(minY, positions[2 * n + 1]);
+        maxY = fmaxf(maxY, positions[2 * n + 1]);
+    }
+
+    // the same scale on both axes keeps the curve's squares square
+    const float extent = fmaxf(maxX - minX, maxY - minY);
+    const float scale = (extent > 0)? 65535.f / extent : 0;
+    uint64_t *keys = malloc((size_t)nodeCount * sizeof(uint64_t));
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+        const uint32_t x = (uint32_t)fminf((positions[2 * n] - minX) * scale, 65535.f);
+        const uint32_t y = (uint32_t)fminf((positions[2 * n + 1] - minY) * scale, 65535.f);
+        const uint32_t key = (order == ASGraphOrderHilbert)? HilbertIndex(x, y) : MortonSpread(x) | (MortonSpread(y) << 1);
+        keys[n] = ((uint64_t)key << 32) | n;
+    }
+
+    qsort(keys, nodeCount, sizeof(uint64_t), CompareKeys);
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+        oldIDs[n] = (uint32_t)keys[n];
+    }
+
+    free(keys);
+}
+
+static void GraphBreadthFirstOrder(ASGraph graph, ASGraphOrder order, uint32_t *oldIDs)
+{
+    // oldIDs doubles as the queue, nodes are numbered in the order they are queued
+    const uint32_t nodeCount = graph->nodeCount;
+    const uint32_t *offsets = graph->edgeOffsets;
+    uint8_t *queued = calloc(nodeCount, 1);
+    uint32_t *roots = malloc((size_t)nodeCount * sizeof(uint32_t));
+    uint32_t count = 0;
+
+    if (order == ASGraphOrderRCM) {
+        // every component starts from its node of lowest degree, found by going through the nodes by ascending degree (counting sort)
+        uint32_t maxDegree = 0;
+        for (uint32_t n=0; n<nodeCount; n++) {
+            const uint32_t degree = offsets[n + 1] - offsets[n];
+            maxDegree = degree > maxDegree? degree : maxDegree;
+        }
+
+        uint32_t *degreeOffsets = calloc((size_t)maxDegree + 2, sizeof(uint32_t));
+        for (uint32_t n=0; n<nodeCount; n++) {
+            degreeOffsets[offsets[n + 1] - offsets[n] + 1]++;
+        }
+        for (uint32_t d=0; d<=maxDegree; d++) {
+            degreeOffsets[d + 1] += degreeOffsets[d];
+        }
+        for (uint32_t n=0; n<nodeCount; n++) {
+            roots[degreeOffsets[offsets[n + 1] - offsets[n]]++] = n;
+        }
+        free(degreeOffsets);
+    } else {
+        for (uint32_t n=0; n<nodeCount; n++) {
+            roots[n] = n;
+        }
+    }
+
+    for (uint32_t r=0; r<nodeCount; r++) {
+        if (queued[roots[r]]) {
+            continue;
+        }
+
+        queued[roots[r]] = 1;
+        oldIDs[count++] = roots[r];
+
+        for (uint32_t head=count-1; head<count; head++) {
+            const uint32_t node = oldIDs[head];
+            const uint32_t first = count;
+
+            for (uint32_t edge=offsets[node]; edge<offsets[node + 1]; edge++) {
+                const uint32_t target = graph->edgeTargets[edge];
+                if (!queued[target]) {
+                    queued[target] = 1;
+                    oldIDs[count++] = target;
+                }
+            }
+
+            if (order == ASGraphOrderRCM) {
+                // Cuthill-McKee queues the neighbors by ascending degree, an insertion sort as there are only a few
+                for (uint32_t i=first+1; i<count; i++) {
+                    const uint32_t target = oldIDs[i];
+                    const uint32_t degree = offsets[target + 1] - offsets[target];
+                    uint32_t j = i;
+                    while (j > first && offsets[oldIDs[j - 1] + 1] - offsets[oldIDs[j - 1]] > degree) {
+                        oldIDs[j] = oldIDs[j - 1];
+                        j--;
+                    }
+                    oldIDs[j] = target;
+                }
+            }
+        }
+    }
+
+    if (order == ASGraphOrderRCM) {
+        for (uint32_t i=0, j=nodeCount-1; i<j; i++, j--) {
+            const uint32_t t = oldIDs[i];
+            oldIDs[i] = oldIDs[j];
+            oldIDs[j] = t;
+        }
+    }
+
+    free(roots);
+    free(queued);
+}
+
+int ASGraphReorder(ASGraph graph, ASGraphOrder order)
+{
+    if (!graph || order > ASGraphOrderRCM || ((order == ASGraphOrderHilbert || order == ASGraphOrderMorton) && !graph->positions)) {
+        return -1;
+    }
+
+    const uint32_t nodeCount = graph->nodeCount;
+    uint32_t *oldIDs = malloc((size_t)nodeCount * sizeof(uint32_t));        // old id of every new id
+    uint32_t *newIDs = malloc((size_t)nodeCount * sizeof(uint32_t));        // new id of every old id
+
+    if (order == ASGraphOrderHilbert || order == ASGraphOrderMorton) {
+        GraphCurveOrder(graph, order, oldIDs);
+    } else {
+        GraphBreadthFirstOrder(graph, order, oldIDs);
+    }
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+        newIDs[oldIDs[n]] = n;
+    }
+
+    GraphPermuteEdges(graph, &graph->edgeOffsets, &graph->edgeTargets, &graph->edgeCosts, oldIDs, newIDs);
+    if (graph->reverseEdgeOffsets) {
+        GraphPermuteEdges(graph, &graph->reverseEdgeOffsets, &graph->reverseEdgeTargets, &graph->reverseEdgeCosts, oldIDs, newIDs);
+    }
+    if (graph->positions) {
+        graph->positions = (float *)GraphPermuteRows(graph, (uint32_t *)graph->positions, 2, oldIDs);
+    }
+
+    if (graph->landmarkCount > 0) {
+        uint32_t *landmarks = malloc((size_t)graph->landmarkCount * sizeof(uint32_t));
+        for (uint32_t i=0; i<graph->landmarkCount; i++) {
+            landmarks[i] = newIDs[graph->landmarks[i]];
+        }
+        GraphFreeArray(graph, graph->landmarks);
+        graph->landmarks = landmarks;
+        graph->landmarkFrom = (float *)GraphPermuteRows(graph, (uint32_t *)graph->landmarkFrom, graph->landmarkStride, oldIDs);
+        graph->landmarkTo = (float *)GraphPermuteRows(graph, (uint32_t *)graph->landmarkTo, graph->landmarkStride, oldIDs);
+    }
+
+    // the mapping always leads back to the ids before the first reordering, however often the graph is reordered
+    if (graph->originalIDs) {
+        graph->originalIDs = GraphPermuteRows(graph, graph->originalIDs, 1, oldIDs);
+    } else {
+        graph->originalIDs = oldIDs;
+        oldIDs = NULL;
+    }
+    GraphFreeArray(graph, graph->reorderedIDs);
+    graph->reorderedIDs = newIDs;
+    for (uint32_t n=0; n<nodeCount; n++) {
+        graph->reorderedIDs[graph->originalIDs[n]] = n;
+    }
+
+    free(oldIDs);
+    return 0;
+}
+
+uint32_t ASGraphGetOriginalNodeID(ASGraph graph, uint32_t node)
+{
+    return (graph && graph->originalIDs && node < graph->nodeCount)? graph->originalIDs[node] : node;
+}
+
+uint32_t ASGraphGetNodeIDFromOriginal(ASGraph graph, uint32_t originalNode)
+{
+    if (!graph || originalNode >= graph->nodeCount) {
+        return ASNodeIDNull;
+    }
+    return graph->reorderedIDs? graph->reorderedIDs[originalNode] : originalNode;
+}
+
+uint32_t ASGraphGetLandmarkCount(ASGraph graph)
+{
+    return graph? graph->landmarkCount : 0;
+}
+
+float ASGraphEstimateCost(ASGraph graph, uint32_t fromNode, uint32_t toNode)
+{
+    if (!graph || fromNode >= graph->nodeCount || toNode >= graph->nodeCount) {
+        return 0;
+    }
+    return GraphHeuristic(graph, fromNode, toNode);
+}
+
+uint32_t ASGraphGetNodeCount(ASGraph graph)
+{
+    return graph? graph->nodeCount : 0;
+}
+
+size_t ASGraphGetEdgeCount(ASGraph graph)
+{
+    return graph? graph->edgeCount : 0;
+}
+
+void ASGraphDestroy(ASGraph graph)
+{
+    if (graph) {
+        GraphFreeArray(graph, graph->edgeOffsets);
+        GraphFreeArray(graph, graph->edgeTargets);
+        GraphFreeArray(graph, graph->edgeCosts);
+        GraphFreeArray(graph, graph->positions);
+        GraphFreeArray(graph, graph->reverseEdgeOffsets);
+        GraphFreeArray(graph, graph->reverseEdgeTargets);
+        GraphFreeArray(graph, graph->reverseEdgeCosts);
+        GraphFreeArray(graph, graph->landmarks);
+        GraphFreeArray(graph, graph->landmarkFrom);
+        GraphFreeArray(graph, graph->landmarkTo);
+        GraphFreeArray(graph, graph->originalIDs);
+        GraphFreeArray(graph, graph->reorderedIDs);
+        if (graph->mapping) {
+            munmap(graph->mapping, graph->mappingSize);
+        }
+        free(graph);
+    }
+}
@@ -0,0 +1,462 @@
+/*
+ Copyright (c) 2012, Sean Heber. All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ 1. Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ 
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ 3. Neither the name of Sean Heber nor the names of its contributors may
+ be used to endorse or promote products derived from this software without
+ specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL SEAN HEBER BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "AStarPrivate.h"
+#include <string.h>
+
+// Jump Point Search skips the cells a straight or diagonal run passes through as long as no path through them can beat
+// the run itself, which holds until a wall ends beside the run (a forced neighbor) -- only those cells go through the open set
+// the pruning rules follow the variant without corner cutting, where diagonal runs have no forced neighbors of their own
+
+static inline int GridDirection(int dx, int dy)
+{
+    // index into the jump table: the four straight directions, then the four diagonals
+    if (dy == 0) {
+        return (dx > 0)? 0 : 1;
+    } else if (dx == 0) {
+        return (dy > 0)? 2 : 3;
+    }
+    return 4 + (dx < 0) + 2 * (dy < 0);
+}
+
+static int32_t ScanLine(const uint64_t *lines, uint32_t words, uint32_t lineCount, uint32_t line, uint32_t position, int direction)
+{
+    // straight jump along one row (or column), 64 cells at a time: the run stops at the first blocked cell or at the first
+    // cell where an adjacent line opens up again after being blocked beside the previous cell
+    const uint64_t *current = lines + (size_t)line * words;
+    const uint64_t *before = (line > 0)? current - words : NULL;
+    const uint64_t *after = (line + 1 < lineCount)? current + words : NULL;
+
+    if (direction > 0) {
+        for (uint32_t w=(position + 1) >> 6; w<words; w++) {
+            uint64_t stop = ~current[w];
+            if (before) {
+                stop |= before[w] & ~((before[w] << 1) | (w? before[w - 1] >> 63 : 0));
+            }
+            if (after) {
+                stop |= after[w] & ~((after[w] << 1) | (w? after[w - 1] >> 63 : 0));
+            }
+            if (w == (position + 1) >> 6) {
+                stop &= ~(uint64_t)0 << ((position + 1) & 63);
+            }
+
+            if (stop) {
+                const uint32_t cell = (w << 6) + (uint32_t)__builtin_ctzll(stop);
+                return ((current[w] >> (cell & 63)) & 1)? (int32_t)(cell - position) : -(int32_t)(cell - 1 - position);
+            }
+        }
+        return -(int32_t)((words << 6) - 1 - position);
+    }
+
+    if (position == 0) {
+        return 0;
+    }
+
+    for (int64_t w=(position - 1) >> 6; w>=0; w--) {
+        uint64_t stop = ~current[w];
+        if (before) {
+            stop |= before[w] & ~((before[w] >> 1) | ((uint32_t)w + 1 < words? before[w + 1] << 63 : 0));
+        }
+        if (after) {
+            stop |= after[w] & ~((after[w] >> 1) | ((uint32_t)w + 1 < words? after[w + 1] << 63 : 0));
+        }
+        if (w == (position - 1) >> 6 && ((position - 1) & 63) != 63) {
+            stop &= ((uint64_t)1 << (((position - 1) & 63) + 1)) - 1;
+        }
+
+        if (stop) {
+            const uint32_t cell = ((uint32_t)w << 6) + 63 - (uint32_t)__builtin_clzll(stop);
+            return ((current[w] >> (cell & 63)) & 1)? (int32_t)(position - cell) : -(int32_t)(position - cell - 1);
+        }
+    }
+    return -(int32_t)position;
+}
+
+static inline int32_t ScanRow(ASGrid grid, uint32_t x, uint32_t y, int dx)
+{
+    return ScanLine(grid->rows, grid->rowWords, grid->height, y, x, dx);
+}
+
+static inline int32_t ScanColumn(ASGrid grid, uint32_t x, uint32_t y, int dy)
+{
+    return ScanLine(grid->columns, grid->columnWords, grid->width, x, y, dy);
+}
+
+static inline int GridVerticalIsForced(ASGrid grid, int64_t x, int64_t y, int dy)
+{
+    // a vertical run of a four connected grid stops where a wall beside it ends
+    return (GridCellIsOpen(grid, x - 1, y) && !GridCellIsOpen(grid, x - 1, y - dy)) || (GridCellIsOpen(grid, x + 1, y) && !GridCellIsOpen(grid, x + 1, y - dy));
+}
+
+static inline int GridDiagonalStepIsOpen(ASGrid grid, int64_t x, int64_t y, int dx, int dy)
+{
+    return GridCellIsOpen(grid, x + dx, y + dy) && GridCellIsOpen(grid, x + dx, y) && GridCellIsOpen(grid, x, y + dy);
+}
+
+static int32_t GridJump(ASGrid grid, uint32_t x, uint32_t y, int dx, int dy)
+{
+    // steps from x, y in direction dx, dy to the next jump point, or minus the steps to the last cell that can be reached if there is none
+    // goals are not considered, the search adds the cells that line up with its goal itself
+    if (grid->jumps) {
+        return grid->jumps[((size_t)y * grid->width + x) * grid->connectivity + GridDirection(dx, dy)];
+    }
+
+    if (dy == 0) {
+        return ScanRow(grid, x, y, dx);
+    }
+
+    if (dx == 0 && grid->connectivity == ASGridEightConnected) {
+        return ScanColumn(grid, x, y, dy);
+    }
+
+    // without diagonal steps a vertical run also stops where a horizontal run from it finds a jump point,
+    // just like a diagonal run stops where one of its straight runs does
+    for (int32_t k=1; ; k++) {
+        const int64_t cellX = (int64_t)x + (int64_t)k * dx;
+        const int64_t cellY = (int64_t)y + (int64_t)k * dy;
+
+        if (dx == 0) {
+            if (!GridCellIsOpen(grid, cellX, cellY)) {
+                return -(k - 1);
+            }
+            if (GridVerticalIsForced(grid, cellX, cellY, dy) || ScanRow(grid, (uint32_t)cellX, (uint32_t)cellY, 1) > 0 || ScanRow(grid, (uint32_t)cellX, (uint32_t)cellY, -1) > 0) {
+                return k;
+            }
+        } else {
+            if (!GridDiagonalStepIsOpen(grid, cellX - dx, cellY - dy, dx, dy)) {
+                return -(k - 1);
+            }
+            if (ScanRow(grid, (uint32_t)cellX, (uint32_t)cellY, dx) > 0 || ScanColumn(grid, (uint32_t)cellX, (uint32_t)cellY, dy) > 0) {
+                return k;
+            }
+        }
+    }
+}
+
+static inline float GridHeuristic(ASGrid grid, uint32_t fromNode, uint32_t toNode)
+{
+    // octile distance with diagonal steps, Manhattan distance without
+    const uint32_t fromX = fromNode % grid->width, fromY = fromNode / grid->width;
+    const uint32_t toX = toNode % grid->width, toY = toNode / grid->width;
+    const float deltaX = (fromX > toX)? (float)(fromX - toX) : (float)(toX - fromX);
+    const float deltaY = (fromY > toY)? (float)(fromY - toY) : (float)(toY - fromY);
+
+    if (grid->connectivity == ASGridFourConnected) {
+        return deltaX + deltaY;
+    }
+    return fmaxf(deltaX, deltaY) + ((float)M_SQRT2 - 1) * fminf(deltaX, deltaY);
+}
+
+static inline void RelaxGridJump(DenseNodes nodes, ASGrid grid, uint32_t current, int dx, int dy, int32_t steps, uint32_t goalNode)
+{
+    const uint32_t x = current % grid->width + steps * dx;
+    const uint32_t y = current / grid->width + steps * dy;
+    const uint32_t neighbor = y * grid->width + x;
+    DenseRecord *record = GetDenseRecord(nodes, neighbor);
+
+    if (!(record->flags & DenseRecordHasEstimatedCost)) {
+        record->estimatedCost = GridHeuristic(grid, neighbor, goalNode);
+        record->flags |= DenseRecordHasEstimatedCost;
+    }
+
+    RelaxDenseNeighbor(nodes, current, neighbor, nodes->records[current].cost + steps * ((dx && dy)? (float)M_SQRT2 : 1.f));
+}
+
+static inline void ExpandGridDirection(DenseNodes nodes, ASGrid grid, uint32_t current, int dx, int dy, uint32_t goalNode)
+{
+    const int64_t x = current % grid->width, y = current / grid->width;
+    const int64_t goalX = goalNode % grid->width, goalY = goalNode / grid->width;
+    const int32_t jump = GridJump(grid, (uint32_t)x, (uint32_t)y, dx, dy);
+    const int32_t reach = (jump > 0)? jump : -jump;
+    int32_t targets[2];
+    int targetCount = 0;
+
+    // jumps do not know the goal, so the cells of the run that line up with it are added as well -- a run that passes
+    // the goal's row or column stops there if its straight runs find the goal, the extra cells cost a few open set entries otherwise
+    if (dx && dy) {
+        if ((goalX - x) * dx > 0 && (goalY - y) * dy > 0) {
+            targets[targetCount++] = (int32_t)llabs(goalX - x);
+            targets[targetCount++] = (int32_t)llabs(goalY - y);
+        }
+    } else if (dy == 0) {
+        if (goalY == y && (goalX - x) * dx > 0) {
+            targets[targetCount++] = (int32_t)llabs(goalX - x);
+        }
+    } else if (grid->connectivity == ASGridEightConnected) {
+        if (goalX == x && (goalY - y) * dy > 0) {
+            targets[targetCount++] = (int32_t)llabs(goalY - y);
+        }
+    } else if ((goalY - y) * dy > 0) {
+        // vertical runs without diagonal steps scan each row they pass sideways
+        targets[targetCount++] = (int32_t)llabs(goalY - y);
+    }
+
+    for (int i=0; i<targetCount; i++) {
+        if (targets[i] <= reach && targets[i] != jump && (i == 0 || targets[i] != targets[0])) {
+            RelaxGridJump(nodes, grid, current, dx, dy, targets[i], goalNode);
+        }
+    }
+
+    if (jump > 0) {
+        RelaxGridJump(nodes, grid, current, dx, dy, jump, goalNode);
+    }
+}
+
+static inline uint32_t GetGridRunLength(ASGrid grid, uint32_t fromNode, uint32_t toNode)
+{
+    const uint32_t fromX = fromNode % grid->width, fromY = fromNode / grid->width;
+    const uint32_t toX = toNode % grid->width, toY = toNode / grid->width;
+    const uint32_t deltaX = (fromX > toX)? fromX - toX : toX - fromX;
+    const uint32_t deltaY = (fromY > toY)? fromY - toY : toY - fromY;
+    return (deltaX > deltaY)? deltaX : deltaY;
+}
+
+static ASPath PathCreateThroughGridJumps(DenseNodes nodes, ASGrid grid, uint32_t goalNode)
+{
+    // consecutive jump points lie on one straight or diagonal run, so the cells between them are filled in
+    size_t count = 1;
+
+    for (uint32_t n=goalNode; nodes->records[n].parent != ASNodeIDNull; n=nodes->records[n].parent) {
+        count += GetGridRunLength(grid, nodes->records[n].parent, n);
+    }
+
+    ASPath path = ASPathAlloc(sizeof(uint32_t), count);
+    if (!path) {
+        nodes->memory->exceeded = 1;
+        return NULL;
+    }
+    uint32_t *pathNodes = path->nodeKeys;
+    size_t index = count - 1;
+    pathNodes[index] = goalNode;
+    path->costs[index] = nodes->records[goalNode].cost;
+
+    for (uint32_t n=goalNode; nodes->records[n].parent != ASNodeIDNull; n=nodes->records[n].parent) {
+        const uint32_t parent = nodes->records[n].parent;
+        const uint32_t length = GetGridRunLength(grid, parent, n);
+        const int64_t step = ((int64_t)n - (int64_t)parent) / length;
+        const float stepCost = (n % grid->width != parent % grid->width && n / grid->width != parent / grid->width)? (float)M_SQRT2 : 1.f;
+
+        for (uint32_t i=length; i>0; i--) {
+            index--;
+            pathNodes[index] = (uint32_t)((int64_t)parent + (i - 1) * step);
+            path->costs[index] = nodes->records[parent].cost + (i - 1) * stepCost;
+        }
+    }
+
+    return path;
+}
+
+/********************************************/
+
+ASGrid ASGridCreate(uint32_t width, uint32_t height, const uint8_t *occupancy, ASGridConnectivity connectivity)
+{
+    if (!occupancy || width == 0 || height == 0 || (uint64_t)width * height >= ASNodeIDNull || (connectivity != ASGridFourConnected && connectivity != ASGridEightConnected)) {
+        return NULL;
+    }
+
+    ASGrid grid = calloc(1, sizeof(struct __ASGrid));
+    grid->width = width;
+    grid->height = height;
+    grid->connectivity = connectivity;
+    grid->rowWords = (width + 63) >> 6;
+    grid->columnWords = (height + 63) >> 6;
+    grid->rows = calloc((size_t)grid->rowWords * height, sizeof(uint64_t));
+    grid->columns = calloc((size_t)grid->columnWords * width, sizeof(uint64_t));
+
+    for (uint32_t y=0; y<height; y++) {
+        for (uint32_t x=0; x<width; x++) {
+            if (!occupancy[(size_t)y * width + x]) {
+                grid->rows[(size_t)y * grid->rowWords + (x >> 6)] |= (uint64_t)1 << (x & 63);
+                grid->columns[(size_t)x * grid->columnWords + (y >> 6)] |= (uint64_t)1 << (y & 63);
+            }
+        }
+    }
+
+    return grid;
+}
+
+int ASGridBuildJumpTable(ASGrid grid)
+{
+    if (!grid) {
+        return -1;
+    }
+
+    const uint32_t width = grid->width;
+    const uint32_t height = grid->height;
+    const size_t stride = grid->connectivity;
+    int32_t *jumps = malloc((size_t)width * height * stride * sizeof(int32_t));
+    if (!jumps) {
+        return -1;
+    }
+
+    // every direction is swept against itself, so the next cell of a run is done before the cell stepping into it
+    // the straight directions go first because vertical runs of four connected grids and diagonal runs stop on their results
+    static const int directions[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {-1, 1}, {1, -1}, {-1, -1}};
+
+    for (size_t d=0; d<stride; d++) {
+        const int dx = directions[d][0];
+        const int dy = directions[d][1];
+
+        for (uint32_t i=0; i<height; i++) {
+            const int64_t y = (dy > 0)? height - 1 - i : i;
+
+            for (uint32_t j=0; j<width; j++) {
+                const int64_t x = (dx > 0)? width - 1 - j : j;
+                const int64_t nextX = x + dx;
+                const int64_t nextY = y + dy;
+                int32_t *jump = &jumps[((size_t)y * width + (size_t)x) * stride + d];
+                int isJumpPoint;
+
+                if (dx && dy) {
+                    if (!GridDiagonalStepIsOpen(grid, x, y, dx, dy)) {
+                        *jump = 0;
+                        continue;
+                    }
+                    const size_t next = ((size_t)nextY * width + (size_t)nextX) * stride;
+                    isJumpPoint = jumps[next + GridDirection(dx, 0)] > 0 || jumps[next + GridDirection(0, dy)] > 0;
+                } else if (!GridCellIsOpen(grid, nextX, nextY)) {
+                    *jump = 0;
+                    continue;
+                } else if (dy == 0) {
+                    isJumpPoint = (GridCellIsOpen(grid, nextX, nextY - 1) && !GridCellIsOpen(grid, x, nextY - 1)) || (GridCellIsOpen(grid, nextX, nextY + 1) && !GridCellIsOpen(grid, x, nextY + 1));
+                } else if (grid->connectivity == ASGridEightConnected) {
+                    isJumpPoint = (GridCellIsOpen(grid, nextX - 1, nextY) && !GridCellIsOpen(grid, nextX - 1, y)) || (GridCellIsOpen(grid, nextX + 1, nextY) && !GridCellIsOpen(grid, nextX + 1, y));
+                } else {
+                    const size_t next = ((size_t)nextY * width + (size_t)nextX) * stride;
+                    isJumpPoint = GridVerticalIsForced(grid, nextX, nextY, dy) || jumps[next + 0] > 0 || jumps[next + 1] > 0;
+                }
+
+                if (isJumpPoint) {
+                    *jump = 1;
+                } else {
+                    const int32_t nextJump = jumps[((size_t)nextY * width + (size_t)nextX) * stride + d];
+                    *jump = (nextJump > 0)? nextJump + 1 : nextJump - 1;
+                }
+            }
+        }
+    }
+
+    free(grid->jumps);
+    grid->jumps = jumps;
+    return 0;
+}
+
+void ASGridDestroy(ASGrid grid)
+{
+    if (grid) {
+        free(grid->rows);
+        free(grid->columns);
+        free(grid->jumps);
+        free(grid);
+    }
+}
+
+ASPath ASPathCreateWithGrid(ASSearchWorkspace workspace, ASGrid grid, uint32_t startNode, uint32_t goalNode)
+{
+    const uint32_t cellCount = grid? grid->width * grid->height : 0;
+    if (!workspace || !grid || startNode >= cellCount || goalNode >= cellCount) {
+        return NULL;
+    }
+    if (!GridCellIsOpen(grid, startNode % grid->width, startNode / grid->width) || !GridCellIsOpen(grid, goalNode % grid->width, goalNode / grid->width)) {
+        return NULL;
+    }
+
+    const double begin = BeginSearch(workspace);
+    DenseNodes nodes = &workspace->denseNodes;
+    uint32_t current = startNode;
+    int foundGoal = 0;
+
+    if (!DenseNodesPrepare(nodes, cellCount, &workspace->options)) {
+        FinishDenseSearch(workspace, begin, nodes, NULL);
+        return NULL;
+    }
+
+    GetDenseRecord(nodes, startNode);
+    nodes->records[startNode].estimatedCost = GridHeuristic(grid, startNode, goalNode);
+    nodes->records[startNode].flags |= DenseRecordHasEstimatedCost;
+    AddDenseNodeToOpenSet(nodes, startNode, 0, ASNodeIDNull);
+
+    while (!workspace->memory.exceeded && HasDenseOpenNode(nodes)) {
+        current = GetDenseOpenNode(nodes);
+
+        if (current == goalNode) {
+            foundGoal = 1;
+            break;
+        }
+
+        RemoveDenseNodeFromOpenSet(nodes, current);
+        nodes->records[current].flags |= DenseRecordClosed;
+        nodes->stats.expanded++;
+        TraceSearchEvent(nodes, ASTraceExpand, &current, nodes->records[current].cost);
+
+        const uint32_t parent = nodes->records[current].parent;
+        if (parent == ASNodeIDNull) {
+            // the start has no direction, so every direction is searched
+            for (int dy=-1; dy<=1; dy++) {
+                for (int dx=-1; dx<=1; dx++) {
+                    if ((dx || dy) && (grid->connectivity == ASGridEightConnected || !(dx && dy))) {
+                        ExpandGridDirection(nodes, grid, current, dx, dy, goalNode);
+                    }
+                }
+            }
+            continue;
+        }
+
+        // the natural neighbors of the direction the node was entered from, the others have a path at least as cheap that avoids this node
+        const int dx = (current % grid->width > parent % grid->width) - (current % grid->width < parent % grid->width);
+        const int dy = (current / grid->width > parent / grid->width) - (current / grid->width < parent / grid->width);
+
+        if (dx && dy) {
+            ExpandGridDirection(nodes, grid, current, dx, 0, goalNode);
+            ExpandGridDirection(nodes, grid, current, 0, dy, goalNode);
+            ExpandGridDirection(nodes, grid, current, dx, dy, goalNode);
+        } else if (dy == 0) {
+            ExpandGridDirection(nodes, grid, current, dx, 0, goalNode);
+            ExpandGridDirection(nodes, grid, current, 0, 1, goalNode);
+            ExpandGridDirection(nodes, grid, current, 0, -1, goalNode);
+            if (grid->connectivity == ASGridEightConnected) {
+                ExpandGridDirection(nodes, grid, current, dx, 1, goalNode);
+                ExpandGridDirection(nodes, grid, current, dx, -1, goalNode);
+            }
+        } else {
+            ExpandGridDirection(nodes, grid, current, 0, dy, goalNode);
+            ExpandGridDirection(nodes, grid, current, 1, 0, goalNode);
+            ExpandGridDirection(nodes, grid, current, -1, 0, goalNode);
+            if (grid->connectivity == ASGridEightConnected) {
+                ExpandGridDirection(nodes, grid, current, 1, dy, goalNode);
+                ExpandGridDirection(nodes, grid, current, -1, dy, goalNode);
+            }
+        }
+    }
+
+    ASPath path = foundGoal? PathCreateThroughGridJumps(nodes, grid, goalNode) : NULL;
+    FinishDenseSearch(workspace, begin, nodes, NULL);
+
+    return path;
+}
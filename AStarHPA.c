@@ -0,0 +1,781 @@
+/*
+ Copyright (c) 2012, Sean Heber. All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ 1. Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ 
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ 3. Neither the name of Sean Heber nor the names of its contributors may
+ be used to endorse or promote products derived from this software without
+ specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL SEAN HEBER BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "AStarPrivate.h"
+#include <string.h>
+
+// HPA*: the nodes are split into clusters, the nodes on either end of a few edges between neighboring clusters become entrances
+// and the cheapest costs between the entrances of each cluster are kept -- a query first searches this small graph of entrances,
+// then fills in the steps between entrances with searches that never leave one cluster
+// edges between two clusters that run side by side (both ends of one touch both ends of the other) form one transition, which
+// gets an entrance in the middle, or one at each end if it is wide -- a route through any of them can move along to the chosen
+// one, so no connection is lost, though paths can come out a little longer than the optimum
+
+#define ClusterNotEntrance  UINT32_MAX
+#define ClusterWideTransition   6       // transitions of more edges than this get an entrance at both ends instead of one in the middle
+
+enum {
+    ClusterTransitionOpen = 0,
+    ClusterTransitionChosen,            // has entrances of its own
+    ClusterTransitionCovered,           // uses the reverse of another transition's edge
+};
+
+typedef struct {
+    uint32_t from;
+    uint32_t to;
+    float cost;
+} ClusterCrossing;
+
+// context of the searches confined to one cluster
+typedef struct {
+    ASClusterHierarchy hierarchy;
+    uint32_t cluster;
+} ClusterSearch;
+
+// context of the search over the entrances, the start and goal take the two ids after the entrances
+typedef struct {
+    ASClusterHierarchy hierarchy;
+    uint32_t start;
+    uint32_t goal;
+    uint32_t startCluster;
+    uint32_t goalCluster;
+    const float *startCosts;            // cost from the start to every entrance of its cluster
+    const float *goalCosts;             // cost from every entrance of the goal's cluster to the goal
+    float directCost;                   // cost from the start to the goal without leaving their cluster, INFINITY if they are in different ones
+} ClusterQuery;
+
+struct __ASClusterHierarchy {
+    const ASPathNodeIDSource *source;
+    void *context;
+    uint32_t nodeCount;
+    uint32_t clusterCount;
+    uint32_t entranceCount;
+    uint32_t *clusters;                 // cluster of every node
+    uint32_t *clusterEntrances;         // clusterCount + 1 entries, the entrances of cluster c are clusterEntrances[c] up to clusterEntrances[c + 1]
+    uint32_t *entranceNodes;            // node id of every entrance
+    size_t *costOffsets;                // clusterCount entries, where the entrance costs of each cluster start in costs
+    size_t costCount;
+    float *costs;                       // k * k cheapest costs between the k entrances of each cluster without leaving it, one row per entrance the path starts at
+    uint32_t *crossingOffsets;          // entranceCount + 1 entries, the edges to other clusters leaving entrance e are crossingOffsets[e] up to crossingOffsets[e + 1]
+    uint32_t *crossingSources;          // entrance each edge leaves
+    uint32_t *crossingTargets;          // entrance each edge leads to
+    float *crossingCosts;
+    uint32_t *reverseCrossingOffsets;   // same for the edges arriving at every entrance
+    uint32_t *reverseCrossings;         // index of each arriving edge in the arrays above
+    ASPathNodeIDSource clusterSource;   // edges inside one cluster, without a heuristic for the searches towards all entrances of a cluster
+    ASPathNodeIDSource reverseClusterSource;
+    ASPathNodeIDSource refineSource;    // edges inside one cluster and the source's heuristic, for the steps between two nodes
+    ASPathNodeIDSource abstractSource;  // the graph of entrances
+    ASSearchWorkspace workspace;        // for building and updating clusters
+    struct __ASNeighborList neighbors;
+};
+
+/********************************************/
+
+static inline void KeepClusterNeighbors(ASNeighborList neighbors, size_t first, const ClusterSearch *search)
+{
+    const ASClusterHierarchy hierarchy = search->hierarchy;
+    uint32_t *nodes = neighbors->nodeKeys;
+    size_t kept = first;
+
+    for (size_t i=first; i<neighbors->count; i++) {
+        if (nodes[i] < hierarchy->nodeCount && hierarchy->clusters[nodes[i]] == search->cluster) {
+            nodes[kept] = nodes[i];
+            neighbors->costs[kept] = neighbors->costs[i];
+            kept++;
+        }
+    }
+
+    neighbors->count = kept;
+}
+
+static void ClusterNeighbors(ASNeighborList neighbors, uint32_t node, float node_cost, uint32_t from_node, void *context)
+{
+    const ClusterSearch *search = context;
+    const size_t first = neighbors->count;
+    search->hierarchy->source->nodeNeighbors(neighbors, node, node_cost, from_node, search->hierarchy->context);
+    KeepClusterNeighbors(neighbors, first, search);
+}
+
+static void ReverseClusterNeighbors(ASNeighborList neighbors, uint32_t node, float node_cost, uint32_t from_node, void *context)
+{
+    // sources without reverseNodeNeighbors are taken to be undirected
+    const ClusterSearch *search = context;
+    const ASPathNodeIDSource *source = search->hierarchy->source;
+    const size_t first = neighbors->count;
+
+    if (source->reverseNodeNeighbors) {
+        source->reverseNodeNeighbors(neighbors, node, node_cost, from_node, search->hierarchy->context);
+    } else {
+        source->nodeNeighbors(neighbors, node, node_cost, from_node, search->hierarchy->context);
+    }
+    KeepClusterNeighbors(neighbors, first, search);
+}
+
+static float ClusterHeuristic(uint32_t fromNode, uint32_t toNode, void *context)
+{
+    const ClusterSearch *search = context;
+    return search->hierarchy->source->pathCostHeuristic(fromNode, toNode, search->hierarchy->context);
+}
+
+static inline uint32_t ClusterQueryNode(const ClusterQuery *query, uint32_t slot)
+{
+    const ASClusterHierarchy hierarchy = query->hierarchy;
+    return (slot < hierarchy->entranceCount)? hierarchy->entranceNodes[slot] : (slot == hierarchy->entranceCount)? query->start : query->goal;
+}
+
+static void AbstractNeighbors(ASNeighborList neighbors, uint32_t node, float node_cost, uint32_t from_node, void *context)
+{
+    const ClusterQuery *query = context;
+    const ASClusterHierarchy hierarchy = query->hierarchy;
+    const uint32_t startSlot = hierarchy->entranceCount;
+    const uint32_t goalSlot = startSlot + 1;
+
+    if (node == startSlot) {
+        const uint32_t first = hierarchy->clusterEntrances[query->startCluster];
+        for (uint32_t i=first; i<hierarchy->clusterEntrances[query->startCluster + 1]; i++) {
+            if (query->startCosts[i - first] < INFINITY) {
+                ASNeighborListAddID(neighbors, i, query->startCosts[i - first]);
+            }
+        }
+        if (query->directCost < INFINITY) {
+            ASNeighborListAddID(neighbors, goalSlot, query->directCost);
+        }
+    } else if (node < startSlot) {
+        const uint32_t cluster = hierarchy->clusters[hierarchy->entranceNodes[node]];
+        const uint32_t first = hierarchy->clusterEntrances[cluster];
+        const uint32_t count = hierarchy->clusterEntrances[cluster + 1] - first;
+        const float *row = hierarchy->costs + hierarchy->costOffsets[cluster] + (size_t)(node - first) * count;
+
+        for (uint32_t i=0; i<count; i++) {
+            if (first + i != node && row[i] < INFINITY) {
+                ASNeighborListAddID(neighbors, first + i, row[i]);
+            }
+        }
+        for (uint32_t edge=hierarchy->crossingOffsets[node]; edge<hierarchy->crossingOffsets[node + 1]; edge++) {
+            if (hierarchy->crossingCosts[edge] < INFINITY) {
+                ASNeighborListAddID(neighbors, hierarchy->crossingTargets[edge], hierarchy->crossingCosts[edge]);
+            }
+        }
+        if (cluster == query->goalCluster && query->goalCosts[node - first] < INFINITY) {
+            ASNeighborListAddID(neighbors, goalSlot, query->goalCosts[node - first]);
+        }
+    }
+}
+
+static void ReverseAbstractNeighbors(ASNeighborList neighbors, uint32_t node, float node_cost, uint32_t from_node, void *context)
+{
+    const ClusterQuery *query = context;
+    const ASClusterHierarchy hierarchy = query->hierarchy;
+    const uint32_t startSlot = hierarchy->entranceCount;
+    const uint32_t goalSlot = startSlot + 1;
+
+    if (node == goalSlot) {
+        const uint32_t first = hierarchy->clusterEntrances[query->goalCluster];
+        for (uint32_t i=first; i<hierarchy->clusterEntrances[query->goalCluster + 1]; i++) {
+            if (query->goalCosts[i - first] < INFINITY) {
+                ASNeighborListAddID(neighbors, i, query->goalCosts[i - first]);
+            }
+        }
+        if (query->directCost < INFINITY) {
+            ASNeighborListAddID(neighbors, startSlot, query->directCost);
+        }
+    } else if (node < startSlot) {
+        const uint32_t cluster = hierarchy->clusters[hierarchy->entranceNodes[node]];
+        const uint32_t first = hierarchy->clusterEntrances[cluster];
+        const uint32_t count = hierarchy->clusterEntrances[cluster + 1] - first;
+        const float *column = hierarchy->costs + hierarchy->costOffsets[cluster] + (node - first);
+
+        for (uint32_t i=0; i<count; i++) {
+            if (first + i != node && column[(size_t)i * count] < INFINITY) {
+                ASNeighborListAddID(neighbors, first + i, column[(size_t)i * count]);
+            }
+        }
+        for (uint32_t i=hierarchy->reverseCrossingOffsets[node]; i<hierarchy->reverseCrossingOffsets[node + 1]; i++) {
+            const uint32_t edge = hierarchy->reverseCrossings[i];
+            if (hierarchy->crossingCosts[edge] < INFINITY) {
+                ASNeighborListAddID(neighbors, hierarchy->crossingSources[edge], hierarchy->crossingCosts[edge]);
+            }
+        }
+        if (cluster == query->startCluster && query->startCosts[node - first] < INFINITY) {
+            ASNeighborListAddID(neighbors, startSlot, query->startCosts[node - first]);
+        }
+    }
+}
+
+static float AbstractHeuristic(uint32_t fromNode, uint32_t toNode, void *context)
+{
+    const ClusterQuery *query = context;
+    const ASClusterHierarchy hierarchy = query->hierarchy;
+    return hierarchy->source->pathCostHeuristic(ClusterQueryNode(query, fromNode), ClusterQueryNode(query, toNode), hierarchy->context);
+}
+
+/********************************************/
+
+static inline void ReadClusterEdges(ASClusterHierarchy hierarchy, uint32_t node)
+{
+    // from_node is the node itself, the costs must not depend on the way a node was reached
+    hierarchy->neighbors.count = 0;
+    hierarchy->source->nodeNeighbors(&hierarchy->neighbors, node, 0, node, hierarchy->context);
+}
+
+static int ClusterNodesTouch(const uint32_t *edgeOffsets, const uint32_t *edgeTargets, uint32_t a, uint32_t b)
+{
+    // an edge both ways, so a route through either node can move over to the other
+    int forward = (a == b);
+    int backward = (a == b);
+
+    for (uint32_t edge=edgeOffsets[a]; edge<edgeOffsets[a + 1] && !forward; edge++) {
+        forward = (edgeTargets[edge] == b);
+    }
+    for (uint32_t edge=edgeOffsets[b]; edge<edgeOffsets[b + 1] && !backward; edge++) {
+        backward = (edgeTargets[edge] == a);
+    }
+
+    return forward && backward;
+}
+
+static uint32_t FindClusterTransition(uint32_t *transitions, uint32_t crossing)
+{
+    while (transitions[crossing] != crossing) {
+        transitions[crossing] = transitions[transitions[crossing]];
+        crossing = transitions[crossing];
+    }
+    return crossing;
+}
+
+static void BuildClusterEntrances(ASClusterHierarchy hierarchy)
+{
+    const uint32_t nodeCount = hierarchy->nodeCount;
+    const uint32_t *clusters = hierarchy->clusters;
+    size_t crossingCount = 0;
+    size_t crossingCapacity = 0;
+    ClusterCrossing *crossings = NULL;
+    uint32_t *crossingFirst = malloc(((size_t)nodeCount + 1) * sizeof(uint32_t));
+    uint8_t *border = calloc(nodeCount, sizeof(uint8_t));
+
+    // every edge between two clusters, ordered by the node it leaves -- parallel edges are merged into one crossing of the cheapest cost,
+    // so the transitions are sized and picked from by node pairs rather than by how many edges a pair happens to have
+    for (uint32_t n=0; n<nodeCount; n++) {
+        crossingFirst[n] = (uint32_t)crossingCount;
+        ReadClusterEdges(hierarchy, n);
+        const uint32_t *targets = hierarchy->neighbors.nodeKeys;
+
+        for (size_t i=0; i<hierarchy->neighbors.count; i++) {
+            if (targets[i] < nodeCount && clusters[targets[i]] != clusters[n]) {
+                size_t parallel = crossingFirst[n];
+                while (parallel < crossingCount && crossings[parallel].to != targets[i]) {
+                    parallel++;
+                }
+                if (parallel < crossingCount) {
+                    crossings[parallel].cost = fminf(crossings[parallel].cost, hierarchy->neighbors.costs[i]);
+                    continue;
+                }
+
+                if (crossingCount == crossingCapacity) {
+                    crossingCapacity = 1 + (crossingCapacity * 2);
+                    crossings = realloc(crossings, crossingCapacity * sizeof(ClusterCrossing));
+                }
+                crossings[crossingCount++] = (ClusterCrossing){n, targets[i], hierarchy->neighbors.costs[i]};
+                border[n] = 1;
+                border[targets[i]] = 1;
+            }
+        }
+    }
+    crossingFirst[nodeCount] = (uint32_t)crossingCount;
+
+    // the edges between border nodes tell which crossings run side by side
+    size_t borderCount = 0;
+    size_t borderCapacity = 0;
+    uint32_t *borderTargets = NULL;
+    uint32_t *borderFirst = malloc(((size_t)nodeCount + 1) * sizeof(uint32_t));
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+        borderFirst[n] = (uint32_t)borderCount;
+        if (border[n]) {
+            ReadClusterEdges(hierarchy, n);
+            const uint32_t *targets = hierarchy->neighbors.nodeKeys;
+
+            for (size_t i=0; i<hierarchy->neighbors.count; i++) {
+                if (targets[i] < nodeCount && targets[i] != n && border[targets[i]]) {
+                    if (borderCount == borderCapacity) {
+                        borderCapacity = 1 + (borderCapacity * 2);
+                        borderTargets = realloc(borderTargets, borderCapacity * sizeof(uint32_t));
+                    }
+                    borderTargets[borderCount++] = targets[i];
+                }
+            }
+        }
+    }
+    borderFirst[nodeCount] = (uint32_t)borderCount;
+
+    // union-find over the crossings, two of them join a transition if both their ends touch
+    uint32_t *transitions = malloc((crossingCount + 1) * sizeof(uint32_t));
+    for (size_t c=0; c<crossingCount; c++) {
+        transitions[c] = (uint32_t)c;
+    }
+
+    for (size_t c=0; c<crossingCount; c++) {
+        const ClusterCrossing crossing = crossings[c];
+
+        for (uint32_t edge=borderFirst[crossing.from]; edge<=borderFirst[crossing.from + 1]; edge++) {
+            // the last round looks at the crossings of the node itself
+            const uint32_t from = (edge < borderFirst[crossing.from + 1])? borderTargets[edge] : crossing.from;
+            if (clusters[from] != clusters[crossing.from] || !ClusterNodesTouch(borderFirst, borderTargets, crossing.from, from)) {
+                continue;
+            }
+
+            for (uint32_t other=crossingFirst[from]; other<crossingFirst[from + 1]; other++) {
+                const uint32_t to = crossings[other].to;
+                if (other != c && clusters[to] == clusters[crossing.to] && ClusterNodesTouch(borderFirst, borderTargets, crossing.to, to)) {
+                    transitions[FindClusterTransition(transitions, (uint32_t)c)] = FindClusterTransition(transitions, other);
+                }
+            }
+        }
+    }
+
+    // pick the crossings in the middle or at both ends of every transition, their ends become entrances
+    // where the edge back exists it is taken as well and stands for the transition the other way, which saves that one its own entrances
+    uint32_t *transitionSizes = calloc(crossingCount + 1, sizeof(uint32_t));
+    uint32_t *transitionSeen = calloc(crossingCount + 1, sizeof(uint32_t));
+    uint8_t *transitionStates = calloc(crossingCount + 1, sizeof(uint8_t));
+    uint8_t *chosen = calloc(crossingCount + 1, sizeof(uint8_t));
+    uint32_t *entranceIndexes = malloc((size_t)nodeCount * sizeof(uint32_t));
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+        entranceIndexes[n] = ClusterNotEntrance;
+    }
+    for (size_t c=0; c<crossingCount; c++) {
+        transitionSizes[FindClusterTransition(transitions, (uint32_t)c)]++;
+    }
+    for (size_t c=0; c<crossingCount; c++) {
+        const uint32_t transition = FindClusterTransition(transitions, (uint32_t)c);
+        const uint32_t size = transitionSizes[transition];
+        const uint32_t position = transitionSeen[transition]++;
+
+        if (transitionStates[transition] == ClusterTransitionCovered || !((size <= ClusterWideTransition)? position == size / 2 : (position == 0 || position == size - 1))) {
+            continue;
+        }
+
+        transitionStates[transition] = ClusterTransitionChosen;
+        chosen[c] = 1;
+        entranceIndexes[crossings[c].from] = 0;
+        entranceIndexes[crossings[c].to] = 0;
+
+        for (uint32_t other=crossingFirst[crossings[c].to]; other<crossingFirst[crossings[c].to + 1]; other++) {
+            if (crossings[other].to == crossings[c].from) {
+                const uint32_t reverse = FindClusterTransition(transitions, other);
+                chosen[other] = 1;
+                if (transitionStates[reverse] == ClusterTransitionOpen) {
+                    transitionStates[reverse] = ClusterTransitionCovered;
+                }
+                break;
+            }
+        }
+    }
+
+    // entrances are numbered cluster by cluster, so those of one cluster are contiguous
+    hierarchy->clusterEntrances = calloc((size_t)hierarchy->clusterCount + 1, sizeof(uint32_t));
+    for (uint32_t n=0; n<nodeCount; n++) {
+        if (entranceIndexes[n] != ClusterNotEntrance) {
+            hierarchy->clusterEntrances[clusters[n] + 1]++;
+        }
+    }
+    for (uint32_t c=0; c<hierarchy->clusterCount; c++) {
+        hierarchy->clusterEntrances[c + 1] += hierarchy->clusterEntrances[c];
+    }
+    hierarchy->entranceCount = hierarchy->clusterEntrances[hierarchy->clusterCount];
+    hierarchy->entranceNodes = malloc(((size_t)hierarchy->entranceCount + 1) * sizeof(uint32_t));
+
+    uint32_t *nextEntrances = malloc(((size_t)hierarchy->clusterCount + 1) * sizeof(uint32_t));
+    memcpy(nextEntrances, hierarchy->clusterEntrances, ((size_t)hierarchy->clusterCount + 1) * sizeof(uint32_t));
+    for (uint32_t n=0; n<nodeCount; n++) {
+        if (entranceIndexes[n] != ClusterNotEntrance) {
+            entranceIndexes[n] = nextEntrances[clusters[n]]++;
+            hierarchy->entranceNodes[entranceIndexes[n]] = n;
+        }
+    }
+
+    // the chosen crossings by the entrance they leave and by the one they arrive at
+    const uint32_t entranceCount = hierarchy->entranceCount;
+    size_t chosenCount = 0;
+    hierarchy->crossingOffsets = calloc((size_t)entranceCount + 1, sizeof(uint32_t));
+    hierarchy->reverseCrossingOffsets = calloc((size_t)entranceCount + 1, sizeof(uint32_t));
+
+    for (size_t c=0; c<crossingCount; c++) {
+        if (chosen[c]) {
+            hierarchy->crossingOffsets[entranceIndexes[crossings[c].from] + 1]++;
+            hierarchy->reverseCrossingOffsets[entranceIndexes[crossings[c].to] + 1]++;
+            chosenCount++;
+        }
+    }
+    for (uint32_t e=0; e<entranceCount; e++) {
+        hierarchy->crossingOffsets[e + 1] += hierarchy->crossingOffsets[e];
+        hierarchy->reverseCrossingOffsets[e + 1] += hierarchy->reverseCrossingOffsets[e];
+    }
+
+    hierarchy->crossingSources = malloc((chosenCount + 1) * sizeof(uint32_t));
+    hierarchy->crossingTargets = malloc((chosenCount + 1) * sizeof(uint32_t));
+    hierarchy->crossingCosts = malloc((chosenCount + 1) * sizeof(float));
+    hierarchy->reverseCrossings = malloc((chosenCount + 1) * sizeof(uint32_t));
+    uint32_t *next = malloc(((size_t)entranceCount + 1) * 2 * sizeof(uint32_t));
+    uint32_t *reverseNext = next + entranceCount + 1;
+    memcpy(next, hierarchy->crossingOffsets, ((size_t)entranceCount + 1) * sizeof(uint32_t));
+    memcpy(reverseNext, hierarchy->reverseCrossingOffsets, ((size_t)entranceCount + 1) * sizeof(uint32_t));
+
+    for (size_t c=0; c<crossingCount; c++) {
+        if (chosen[c]) {
+            const uint32_t source = entranceIndexes[crossings[c].from];
+            const uint32_t target = entranceIndexes[crossings[c].to];
+            const uint32_t edge = next[source]++;
+            hierarchy->crossingSources[edge] = source;
+            hierarchy->crossingTargets[edge] = target;
+            hierarchy->crossingCosts[edge] = crossings[c].cost;
+            hierarchy->reverseCrossings[reverseNext[target]++] = edge;
+        }
+    }
+
+    free(next);
+    free(nextEntrances);
+    free(entranceIndexes);
+    free(chosen);
+    free(transitionStates);
+    free(transitionSeen);
+    free(transitionSizes);
+    free(transitions);
+    free(borderFirst);
+    free(borderTargets);
+    free(border);
+    free(crossingFirst);
+    free(crossings);
+}
+
+static void UpdateCrossingCost(ASClusterHierarchy hierarchy, uint32_t edge)
+{
+    // the edge may have become more expensive, cheaper or gone
+    const uint32_t to = hierarchy->entranceNodes[hierarchy->crossingTargets[edge]];
+    float cost = INFINITY;
+
+    ReadClusterEdges(hierarchy, hierarchy->entranceNodes[hierarchy->crossingSources[edge]]);
+    const uint32_t *targets = hierarchy->neighbors.nodeKeys;
+
+    for (size_t i=0; i<hierarchy->neighbors.count; i++) {
+        if (targets[i] == to && hierarchy->neighbors.costs[i] < cost) {
+            cost = hierarchy->neighbors.costs[i];
+        }
+    }
+
+    hierarchy->crossingCosts[edge] = cost;
+}
+
+static void UpdateClusterCosts(ASClusterHierarchy hierarchy, uint32_t cluster)
+{
+    // one search from every entrance towards all the others
+    const uint32_t first = hierarchy->clusterEntrances[cluster];
+    const uint32_t count = hierarchy->clusterEntrances[cluster + 1] - first;
+    float *costs = hierarchy->costs + hierarchy->costOffsets[cluster];
+    ClusterSearch search = {hierarchy, cluster};
+
+    for (uint32_t i=0; i<count; i++) {
+        ASPathCreateMultiWithNodeIDs(hierarchy->workspace, &hierarchy->clusterSource, &search, hierarchy->entranceNodes[first + i], hierarchy->entranceNodes + first, count, NULL, costs + (size_t)i * count);
+    }
+}
+
+/********************************************/
+
+ASClusterHierarchy ASClusterHierarchyCreate(const ASPathNodeIDSource *source, void *context, const uint32_t *clusters)
+{
+    if (!source || !source->nodeNeighbors || !clusters) {
+        return NULL;
+    }
+
+    const uint32_t nodeCount = source->nodeCount;
+    ASClusterHierarchy hierarchy = calloc(1, sizeof(struct __ASClusterHierarchy));
+    hierarchy->source = source;
+    hierarchy->context = context;
+    hierarchy->nodeCount = nodeCount;
+    hierarchy->clusters = malloc(((size_t)nodeCount + 1) * sizeof(uint32_t));
+    hierarchy->workspace = ASSearchWorkspaceCreate();
+    NeighborListBind(&hierarchy->neighbors, sizeof(uint32_t));
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+        hierarchy->clusters[n] = clusters[n];
+        if (clusters[n] >= hierarchy->clusterCount) {
+            hierarchy->clusterCount = clusters[n] + 1;
+        }
+    }
+
+    hierarchy->clusterSource = (ASPathNodeIDSource){nodeCount, &ClusterNeighbors, NULL, NULL, source->reverseNodeNeighbors? &ReverseClusterNeighbors : NULL};
+    hierarchy->reverseClusterSource = (ASPathNodeIDSource){nodeCount, &ReverseClusterNeighbors, NULL, NULL, &ClusterNeighbors};
+    hierarchy->refineSource = hierarchy->clusterSource;
+    hierarchy->refineSource.pathCostHeuristic = source->pathCostHeuristic? &ClusterHeuristic : NULL;
+
+    BuildClusterEntrances(hierarchy);
+
+    hierarchy->abstractSource = (ASPathNodeIDSource){hierarchy->entranceCount + 2, &AbstractNeighbors, source->pathCostHeuristic? &AbstractHeuristic : NULL, NULL, &ReverseAbstractNeighbors};
+    hierarchy->costOffsets = malloc(((size_t)hierarchy->clusterCount + 1) * sizeof(size_t));
+
+    for (uint32_t c=0; c<hierarchy->clusterCount; c++) {
+        const size_t count = hierarchy->clusterEntrances[c + 1] - hierarchy->clusterEntrances[c];
+        hierarchy->costOffsets[c] = hierarchy->costCount;
+        hierarchy->costCount += count * count;
+    }
+
+    hierarchy->costs = malloc((hierarchy->costCount + 1) * sizeof(float));
+    for (uint32_t c=0; c<hierarchy->clusterCount; c++) {
+        UpdateClusterCosts(hierarchy, c);
+    }
+
+    return hierarchy;
+}
+
+void ASClusterHierarchyUpdateCluster(ASClusterHierarchy hierarchy, uint32_t cluster)
+{
+    if (!hierarchy || cluster >= hierarchy->clusterCount) {
+        return;
+    }
+
+    for (uint32_t e=hierarchy->clusterEntrances[cluster]; e<hierarchy->clusterEntrances[cluster + 1]; e++) {
+        for (uint32_t edge=hierarchy->crossingOffsets[e]; edge<hierarchy->crossingOffsets[e + 1]; edge++) {
+            UpdateCrossingCost(hierarchy, edge);
+        }
+        for (uint32_t i=hierarchy->reverseCrossingOffsets[e]; i<hierarchy->reverseCrossingOffsets[e + 1]; i++) {
+            UpdateCrossingCost(hierarchy, hierarchy->reverseCrossings[i]);
+        }
+    }
+
+    UpdateClusterCosts(hierarchy, cluster);
+}
+
+uint32_t ASClusterHierarchyGetEntranceCount(ASClusterHierarchy hierarchy)
+{
+    return hierarchy? hierarchy->entranceCount : 0;
+}
+
+size_t ASClusterHierarchyGetMemorySize(ASClusterHierarchy hierarchy)
+{
+    if (!hierarchy) {
+        return 0;
+    }
+
+    const size_t crossingCount = hierarchy->crossingOffsets[hierarchy->entranceCount];
+    return sizeof(struct __ASClusterHierarchy)
+        + (size_t)hierarchy->nodeCount * sizeof(uint32_t)
+        + ((size_t)hierarchy->clusterCount + 1) * (sizeof(uint32_t) + sizeof(size_t))
+        + ((size_t)hierarchy->entranceCount + 1) * 3 * sizeof(uint32_t)
+        + hierarchy->costCount * sizeof(float)
+        + crossingCount * (3 * sizeof(uint32_t) + sizeof(float));
+}
+
+void ASClusterHierarchyDestroy(ASClusterHierarchy hierarchy)
+{
+    if (hierarchy) {
+        free(hierarchy->clusters);
+        free(hierarchy->clusterEntrances);
+        free(hierarchy->entranceNodes);
+        free(hierarchy->costOffsets);
+        free(hierarchy->costs);
+        free(hierarchy->crossingOffsets);
+        free(hierarchy->crossingSources);
+        free(hierarchy->crossingTargets);
+        free(hierarchy->crossingCosts);
+        free(hierarchy->reverseCrossingOffsets);
+        free(hierarchy->reverseCrossings);
+        ASSearchWorkspaceDestroy(hierarchy->workspace);
+        NeighborListFree(&hierarchy->neighbors);
+        free(hierarchy);
+    }
+}
+
+ASPath ASClusterHierarchyCreateAbstractPath(ASSearchWorkspace workspace, ASClusterHierarchy hierarchy, uint32_t startNode, uint32_t goalNode)
+{
+    if (!workspace || !hierarchy || startNode >= hierarchy->nodeCount || goalNode >= hierarchy->nodeCount) {
+        return NULL;
+    }
+
+    const uint32_t startCluster = hierarchy->clusters[startNode];
+    const uint32_t goalCluster = hierarchy->clusters[goalNode];
+    const uint32_t startFirst = hierarchy->clusterEntrances[startCluster];
+    const uint32_t startCount = hierarchy->clusterEntrances[startCluster + 1] - startFirst;
+    const uint32_t goalFirst = hierarchy->clusterEntrances[goalCluster];
+    const uint32_t goalCount = hierarchy->clusterEntrances[goalCluster + 1] - goalFirst;
+
+    // the start's search also looks for the goal if they share a cluster, its cost goes after those of the entrances
+    uint32_t *targets = malloc(((size_t)startCount + 1) * sizeof(uint32_t));
+    float *startCosts = malloc(((size_t)startCount + 1 + goalCount) * sizeof(float));
+    if (!targets || !startCosts) {
+        SearchWorkspaceSetOutOfMemory(workspace);
+        free(targets);
+        free(startCosts);
+        return NULL;
+    }
+    float *goalCosts = startCosts + startCount + 1;
+    memcpy(targets, hierarchy->entranceNodes + startFirst, startCount * sizeof(uint32_t));
+    targets[startCount] = goalNode;
+
+    ClusterSearch search = {hierarchy, startCluster};
+    ASPathCreateMultiWithNodeIDs(workspace, &hierarchy->clusterSource, &search, startNode, targets, startCount + (startCluster == goalCluster), NULL, startCosts);
+    search.cluster = goalCluster;
+    if (ASSearchWorkspaceGetStatus(workspace) == ASSearchCompleted) {
+        ASPathCreateMultiWithNodeIDs(workspace, &hierarchy->reverseClusterSource, &search, goalNode, hierarchy->entranceNodes + goalFirst, goalCount, NULL, goalCosts);
+    }
+
+    // the costs of an entrance search that ran out of memory are incomplete, the abstract search would miss paths
+    if (ASSearchWorkspaceGetStatus(workspace) == ASSearchOutOfMemory) {
+        free(targets);
+        free(startCosts);
+        return NULL;
+    }
+
+    const ClusterQuery query = {hierarchy, startNode, goalNode, startCluster, goalCluster, startCosts, goalCosts, (startCluster == goalCluster)? startCosts[startCount] : INFINITY};
+    ASPath slots = ASPathCreateWithNodeIDs(workspace, &hierarchy->abstractSource, (void *)&query, hierarchy->entranceCount, hierarchy->entranceCount + 1);
+    free(targets);
+    free(startCosts);
+
+    if (!slots) {
+        return NULL;
+    }
+
+    // the start or goal may be an entrance itself and show up twice
+    ASPath path = ASPathAlloc(sizeof(uint32_t), slots->count);
+    if (!path) {
+        SearchWorkspaceSetOutOfMemory(workspace);
+        ASPathDestroy(slots);
+        return NULL;
+    }
+    const uint32_t *slotNodes = slots->nodeKeys;
+    uint32_t *nodes = path->nodeKeys;
+    size_t count = 0;
+
+    for (size_t i=0; i<slots->count; i++) {
+        const uint32_t node = ClusterQueryNode(&query, slotNodes[i]);
+        if (count == 0 || nodes[count - 1] != node) {
+            nodes[count] = node;
+            path->costs[count] = slots->costs[i];
+            count++;
+        }
+    }
+
+    path->count = count;
+    ASPathDestroy(slots);
+    return path;
+}
+
+ASPath ASClusterHierarchyRefinePath(ASSearchWorkspace workspace, ASClusterHierarchy hierarchy, ASPath path, size_t index)
+{
+    if (!workspace || !hierarchy || !path || path->nodeSize != sizeof(uint32_t) || index + 1 >= path->count) {
+        return NULL;
+    }
+
+    const uint32_t *nodes = path->nodeKeys;
+    const uint32_t from = nodes[index];
+    const uint32_t to = nodes[index + 1];
+
+    if (from >= hierarchy->nodeCount || to >= hierarchy->nodeCount) {
+        return NULL;
+    }
+
+    if (hierarchy->clusters[from] != hierarchy->clusters[to]) {
+        // a single edge between two clusters
+        ASPath step = ASPathAlloc(sizeof(uint32_t), 2);
+        if (!step) {
+            SearchWorkspaceSetOutOfMemory(workspace);
+            return NULL;
+        }
+        uint32_t *stepNodes = step->nodeKeys;
+        stepNodes[0] = from;
+        stepNodes[1] = to;
+        step->costs[0] = path->costs[index];
+        step->costs[1] = path->costs[index + 1];
+        return step;
+    }
+
+    ClusterSearch search = {hierarchy, hierarchy->clusters[from]};
+    ASPath step = ASPathCreateWithNodeIDs(workspace, &hierarchy->refineSource, &search, from, to);
+
+    if (step) {
+        for (size_t i=0; i<step->count; i++) {
+            step->costs[i] += path->costs[index];
+        }
+    }
+
+    return step;
+}
+
+ASPath ASPathCreateWithClusterHierarchy(ASSearchWorkspace workspace, ASClusterHierarchy hierarchy, uint32_t startNode, uint32_t goalNode)
+{
+    ASPath abstractPath = ASClusterHierarchyCreateAbstractPath(workspace, hierarchy, startNode, goalNode);
+
+    if (!abstractPath) {
+        return NULL;
+    }
+
+    const size_t stepCount = abstractPath->count - 1;
+    ASPath *steps = malloc((stepCount + 1) * sizeof(ASPath));
+    size_t count = 1;
+
+    if (!steps) {
+        SearchWorkspaceSetOutOfMemory(workspace);
+        ASPathDestroy(abstractPath);
+        return NULL;
+    }
+
+    // a step that can't be refined leaves no path: the cluster changed since its costs were last updated, or the search ran out of memory
+    size_t refinedCount = 0;
+    while (refinedCount < stepCount && (steps[refinedCount] = ASClusterHierarchyRefinePath(workspace, hierarchy, abstractPath, refinedCount))) {
+        count += steps[refinedCount]->count - 1;
+        refinedCount++;
+    }
+
+    // the steps share their end nodes, each one after the first starts where the one before ended
+    ASPath path = (refinedCount == stepCount)? ASPathAlloc(sizeof(uint32_t), count) : NULL;
+
+    if (path) {
+        uint32_t *nodes = path->nodeKeys;
+        nodes[0] = startNode;
+        path->costs[0] = 0;
+        count = 1;
+
+        for (size_t i=0; i<stepCount; i++) {
+            memcpy(nodes + count, (uint32_t *)steps[i]->nodeKeys + 1, (steps[i]->count - 1) * sizeof(uint32_t));
+            memcpy(path->costs + count, steps[i]->costs + 1, (steps[i]->count - 1) * sizeof(float));
+            count += steps[i]->count - 1;
+        }
+    } else if (refinedCount == stepCount) {
+        SearchWorkspaceSetOutOfMemory(workspace);
+    }
+
+    for (size_t i=0; i<refinedCount; i++) {
+        ASPathDestroy(steps[i]);
+    }
+    free(steps);
+    ASPathDestroy(abstractPath);
+
+    return path;
+}
@@ -0,0 +1,393 @@
+/*
+ Copyright (c) 2012, Sean Heber. All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ 1. Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ 
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ 3. Neither the name of Sean Heber nor the names of its contributors may
+ be used to endorse or promote products derived from this software without
+ specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL SEAN HEBER BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "AStarPrivate.h"
+#include <string.h>
+
+// D* Lite searches backwards from the goal and keeps that search tree between calls: g is the cost to the goal a node was last
+// expanded with, rhs the cost its successors currently offer -- only nodes where the two differ (inconsistent) go through the queue,
+// so a changed edge only re-expands the part of the tree whose costs it changed
+// keys are compared (k1, k2) lexicographically, km keeps the keys already queued valid as the start moves along the path
+
+#define PlannerNotQueued    UINT32_MAX
+#define PlannerKeyTolerance 1e-5f
+
+typedef struct {
+    float k1;
+    float k2;
+    uint32_t node;
+} PlannerHeapEntry;
+
+struct __ASPlanner {
+    const ASPathNodeIDSource *source;
+    void *context;
+    uint32_t start;
+    uint32_t last;                      // start when km was last raised
+    uint32_t goal;
+    float km;
+    float *g;
+    float *rhs;
+    uint32_t *heapIndexes;              // slot of every queued node in heap, PlannerNotQueued otherwise
+    size_t heapCount;
+    PlannerHeapEntry *heap;
+    size_t expandedCount;
+    struct __ASNeighborList successors;
+    struct __ASNeighborList predecessors;
+    struct __ASNeighborList pathNodes;
+};
+
+/********************************************/
+
+static inline int PlannerKeyIsLess(float a1, float a2, float b1, float b2)
+{
+    return a1 < b1 || (a1 == b1 && a2 < b2);
+}
+
+static inline float PlannerHeuristic(ASPlanner planner, uint32_t node)
+{
+    return planner->source->pathCostHeuristic? planner->source->pathCostHeuristic(planner->start, node, planner->context) : 0;
+}
+
+static inline PlannerHeapEntry PlannerCalculateKey(ASPlanner planner, uint32_t node)
+{
+    const float cost = fminf(planner->g[node], planner->rhs[node]);
+    return (PlannerHeapEntry){cost + PlannerHeuristic(planner, node) + planner->km, cost, node};
+}
+
+static inline void PlannerHeapSet(ASPlanner planner, size_t index, PlannerHeapEntry entry)
+{
+    planner->heap[index] = entry;
+    planner->heapIndexes[entry.node] = (uint32_t)index;
+}
+
+static void PlannerHeapSiftUp(ASPlanner planner, size_t index)
+{
+    const PlannerHeapEntry entry = planner->heap[index];
+
+    while (index > 0) {
+        const size_t parent = (index - 1) / 2;
+        if (!PlannerKeyIsLess(entry.k1, entry.k2, planner->heap[parent].k1, planner->heap[parent].k2)) {
+            break;
+        }
+        PlannerHeapSet(planner, index, planner->heap[parent]);
+        index = parent;
+    }
+    PlannerHeapSet(planner, index, entry);
+}
+
+static void PlannerHeapSiftDown(ASPlanner planner, size_t index)
+{
+    const PlannerHeapEntry entry = planner->heap[index];
+
+    for (;;) {
+        size_t child = 2 * index + 1;
+        if (child >= planner->heapCount) {
+            break;
+        }
+        if (child + 1 < planner->heapCount && PlannerKeyIsLess(planner->heap[child + 1].k1, planner->heap[child + 1].k2, planner->heap[child].k1, planner->heap[child].k2)) {
+            child++;
+        }
+        if (!PlannerKeyIsLess(planner->heap[child].k1, planner->heap[child].k2, entry.k1, entry.k2)) {
+            break;
+        }
+        PlannerHeapSet(planner, index, planner->heap[child]);
+        index = child;
+    }
+    PlannerHeapSet(planner, index, entry);
+}
+
+static void PlannerHeapRemove(ASPlanner planner, uint32_t node)
+{
+    const size_t index = planner->heapIndexes[node];
+    const PlannerHeapEntry last = planner->heap[--planner->heapCount];
+    planner->heapIndexes[node] = PlannerNotQueued;
+
+    if (index < planner->heapCount) {
+        PlannerHeapSet(planner, index, last);
+        PlannerHeapSiftUp(planner, index);
+        PlannerHeapSiftDown(planner, planner->heapIndexes[last.node]);
+    }
+}
+
+static void UpdatePlannerNode(ASPlanner planner, uint32_t node)
+{
+    // queues the node while it is inconsistent, with its key brought up to date
+    const int queued = planner->heapIndexes[node] != PlannerNotQueued;
+
+    if (planner->g[node] != planner->rhs[node]) {
+        const PlannerHeapEntry entry = PlannerCalculateKey(planner, node);
+        if (queued) {
+            const size_t index = planner->heapIndexes[node];
+            planner->heap[index] = entry;
+            PlannerHeapSiftUp(planner, index);
+            PlannerHeapSiftDown(planner, planner->heapIndexes[node]);
+        } else {
+            planner->heap[planner->heapCount] = entry;
+            planner->heapIndexes[node] = (uint32_t)planner->heapCount;
+            PlannerHeapSiftUp(planner, planner->heapCount++);
+        }
+    } else if (queued) {
+        PlannerHeapRemove(planner, node);
+    }
+}
+
+static inline void GetPlannerSuccessors(ASPlanner planner, uint32_t node)
+{
+    // from_node is the node itself, the costs must not depend on the way a node was reached
+    planner->successors.count = 0;
+    planner->source->nodeNeighbors(&planner->successors, node, 0, node, planner->context);
+}
+
+static inline void GetPlannerPredecessors(ASPlanner planner, uint32_t node)
+{
+    // graphs without reverseNodeNeighbors are taken to be undirected, as in bidirectional search
+    planner->predecessors.count = 0;
+    if (planner->source->reverseNodeNeighbors) {
+        planner->source->reverseNodeNeighbors(&planner->predecessors, node, 0, node, planner->context);
+    } else {
+        planner->source->nodeNeighbors(&planner->predecessors, node, 0, node, planner->context);
+    }
+}
+
+static float GetPlannerBestSuccessor(ASPlanner planner, uint32_t node, uint32_t *best, float *bestEdgeCost)
+{
+    // lowest edge cost plus cost to the goal over the successors of node, bestEdgeCost gets the edge that won so parallel edges count the cheaper one
+    // self loops never lower the cost, and ties go to the successor closer to the goal, so zero cost edges can't send the path walk in circles
+    const uint32_t nodeCount = planner->source->nodeCount;
+    float bestCost = INFINITY;
+    float edgeCost = INFINITY;
+    *best = ASNodeIDNull;
+
+    GetPlannerSuccessors(planner, node);
+    const uint32_t *successors = planner->successors.nodeKeys;
+
+    for (size_t i=0; i<planner->successors.count; i++) {
+        if (successors[i] < nodeCount && successors[i] != node) {
+            const float cost = planner->successors.costs[i] + planner->g[successors[i]];
+            if (cost < bestCost || (cost == bestCost && *best != ASNodeIDNull && planner->g[successors[i]] < planner->g[*best])) {
+                bestCost = cost;
+                edgeCost = planner->successors.costs[i];
+                *best = successors[i];
+            }
+        }
+    }
+
+    if (bestEdgeCost) {
+        *bestEdgeCost = edgeCost;
+    }
+    return bestCost;
+}
+
+static void ComputePlannerShortestPath(ASPlanner planner)
+{
+    const uint32_t nodeCount = planner->source->nodeCount;
+    const uint32_t start = planner->start;
+
+    planner->expandedCount = 0;
+
+    while (planner->heapCount > 0) {
+        const PlannerHeapEntry top = planner->heap[0];
+        const PlannerHeapEntry startKey = PlannerCalculateKey(planner, start);
+
+        // g, h and km are summed in a different order for every node, so a k1 tied with the start's can round to either side of it;
+        // ties within PlannerKeyTolerance are all expanded, expanding one node too many is safe where stopping one early is not
+        if (top.k1 > startKey.k1 + PlannerKeyTolerance * (1 + fabsf(startKey.k1)) && planner->rhs[start] <= planner->g[start]) {
+            break;
+        }
+
+        const uint32_t node = top.node;
+        const PlannerHeapEntry key = PlannerCalculateKey(planner, node);
+
+        if (PlannerKeyIsLess(top.k1, top.k2, key.k1, key.k2)) {
+            // queued before the start moved, requeue with its current key
+            planner->heap[0] = key;
+            PlannerHeapSiftDown(planner, 0);
+            continue;
+        }
+
+        planner->expandedCount++;
+        GetPlannerPredecessors(planner, node);
+        const uint32_t *predecessors = planner->predecessors.nodeKeys;
+
+        if (planner->g[node] > planner->rhs[node]) {
+            // the node got cheaper, which can only lower the cost of its predecessors
+            planner->g[node] = planner->rhs[node];
+            PlannerHeapRemove(planner, node);
+
+            for (size_t i=0; i<planner->predecessors.count; i++) {
+                const uint32_t predecessor = predecessors[i];
+                if (predecessor < nodeCount && predecessor != planner->goal) {
+                    const float cost = planner->predecessors.costs[i] + planner->g[node];
+                    if (cost < planner->rhs[predecessor]) {
+                        planner->rhs[predecessor] = cost;
+                    }
+                    UpdatePlannerNode(planner, predecessor);
+                }
+            }
+        } else {
+            // the node got more expensive, predecessors whose best successor it was look for another one
+            const float oldCost = planner->g[node];
+            uint32_t best;
+            planner->g[node] = INFINITY;
+
+            for (size_t i=0; i<planner->predecessors.count; i++) {
+                const uint32_t predecessor = predecessors[i];
+                if (predecessor < nodeCount && predecessor != planner->goal && planner->rhs[predecessor] >= planner->predecessors.costs[i] + oldCost) {
+                    planner->rhs[predecessor] = GetPlannerBestSuccessor(planner, predecessor, &best, NULL);
+                    UpdatePlannerNode(planner, predecessor);
+                }
+            }
+
+            if (node != planner->goal) {
+                planner->rhs[node] = GetPlannerBestSuccessor(planner, node, &best, NULL);
+            }
+            UpdatePlannerNode(planner, node);
+        }
+    }
+}
+
+/********************************************/
+
+ASPlanner ASPlannerCreate(const ASPathNodeIDSource *source, void *context, uint32_t startNode, uint32_t goalNode)
+{
+    if (!source || !source->nodeNeighbors || startNode >= source->nodeCount || goalNode >= source->nodeCount) {
+        return NULL;
+    }
+
+    const uint32_t nodeCount = source->nodeCount;
+    ASPlanner planner = calloc(1, sizeof(struct __ASPlanner));
+    planner->source = source;
+    planner->context = context;
+    planner->start = startNode;
+    planner->last = startNode;
+    planner->goal = goalNode;
+    planner->g = malloc(nodeCount * sizeof(float));
+    planner->rhs = malloc(nodeCount * sizeof(float));
+    planner->heapIndexes = malloc(nodeCount * sizeof(uint32_t));
+    planner->heap = malloc(nodeCount * sizeof(PlannerHeapEntry));
+    NeighborListBind(&planner->successors, sizeof(uint32_t));
+    NeighborListBind(&planner->predecessors, sizeof(uint32_t));
+    NeighborListBind(&planner->pathNodes, sizeof(uint32_t));
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+        planner->g[n] = INFINITY;
+        planner->rhs[n] = INFINITY;
+        planner->heapIndexes[n] = PlannerNotQueued;
+    }
+
+    planner->rhs[goalNode] = 0;
+    UpdatePlannerNode(planner, goalNode);
+
+    return planner;
+}
+
+void ASPlannerSetStart(ASPlanner planner, uint32_t startNode)
+{
+    if (planner && startNode < planner->source->nodeCount && startNode != planner->start) {
+        // the heuristic is measured from the start, so the keys already queued are too high by at most h(last, start)
+        if (planner->source->pathCostHeuristic) {
+            planner->km += planner->source->pathCostHeuristic(planner->last, startNode, planner->context);
+        }
+        planner->start = startNode;
+        planner->last = startNode;
+    }
+}
+
+void ASPlannerUpdateEdge(ASPlanner planner, uint32_t fromNode, uint32_t toNode)
+{
+    if (planner && fromNode < planner->source->nodeCount && toNode < planner->source->nodeCount && fromNode != planner->goal) {
+        uint32_t best;
+        planner->rhs[fromNode] = GetPlannerBestSuccessor(planner, fromNode, &best, NULL);
+        UpdatePlannerNode(planner, fromNode);
+    }
+}
+
+ASPath ASPlannerCreatePath(ASPlanner planner)
+{
+    if (!planner) {
+        return NULL;
+    }
+
+    ComputePlannerShortestPath(planner);
+
+    // the search may stop with the start itself still queued, its successors already carry the right costs
+    if (planner->rhs[planner->start] == INFINITY) {
+        return NULL;
+    }
+
+    // follow the cheapest successor from the start, the costs along the way are the edge costs as nodeNeighbors reports them now
+    ASNeighborList pathNodes = &planner->pathNodes;
+    uint32_t node = planner->start;
+    float cost = 0;
+    pathNodes->count = 0;
+    size_t stepCount = 0;
+    ASNeighborListAddID(pathNodes, node, 0);
+
+    while (node != planner->goal) {
+        uint32_t best;
+        float edgeCost;
+        GetPlannerBestSuccessor(planner, node, &best, &edgeCost);
+
+        if (best == ASNodeIDNull || ++stepCount > planner->source->nodeCount) {
+            return NULL;
+        }
+
+        cost += edgeCost;
+        node = best;
+        ASNeighborListAddID(pathNodes, node, cost);
+    }
+
+    // the neighbor list drops the nodes it has no memory for
+    ASPath path = (pathNodes->count == stepCount + 1)? ASPathAlloc(sizeof(uint32_t), pathNodes->count) : NULL;
+    if (!path) {
+        return NULL;
+    }
+    memcpy(path->costs, pathNodes->costs, pathNodes->count * sizeof(float));
+    memcpy(path->nodeKeys, pathNodes->nodeKeys, pathNodes->count * sizeof(uint32_t));
+    return path;
+}
+
+size_t ASPlannerGetExpandedCount(ASPlanner planner)
+{
+    return planner? planner->expandedCount : 0;
+}
+
+void ASPlannerDestroy(ASPlanner planner)
+{
+    if (planner) {
+        free(planner->g);
+        free(planner->rhs);
+        free(planner->heapIndexes);
+        free(planner->heap);
+        NeighborListFree(&planner->successors);
+        NeighborListFree(&planner->predecessors);
+        NeighborListFree(&planner->pathNodes);
+        free(planner);
+    }
+}
@@ -0,0 +1,985 @@
+/*
+ Copyright (c) 2012, Sean Heber. All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ 1. Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ 
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ 3. Neither the name of Sean Heber nor the names of its contributors may
+ be used to endorse or promote products derived from this software without
+ specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL SEAN HEBER BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// structures shared by the library sources, not part of the public API
+
+#ifndef AStarPrivate_h
+#define AStarPrivate_h
+
+#include "AStar.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// the bytes held by the scratch buffers of a workspace, against ASSearchOptions.memoryLimit
+typedef struct {
+    size_t limit;                       // 0 for no limit
+    size_t used;
+    int exceeded;                       // a buffer of the current search could not grow, so the search stops
+} SearchMemory;
+
+struct __ASNeighborList {
+    size_t nodeSize;
+    size_t capacity;
+    size_t count;
+    float *costs;
+    void *nodeKeys;
+    SearchMemory *memory;               // the workspace's budget -- NULL for lists outside a workspace
+};
+
+struct __ASPath {
+    atomic_size_t refCount;             // paths never change once created, so ASPathCopy() shares them and the last ASPathDestroy() frees them
+    size_t nodeSize;
+    size_t count;
+    float* costs;
+    void *nodeKeys;
+    // costs and nodeKeys follow in the same allocation
+};
+
+struct __ASGraph {
+    uint32_t nodeCount;
+    uint32_t edgeCount;
+    uint32_t *edgeOffsets;              // nodeCount + 1 entries, the edges of node n are edgeOffsets[n] up to edgeOffsets[n + 1]
+    uint32_t *edgeTargets;
+    float *edgeCosts;
+    uint32_t *reverseEdgeOffsets;       // incoming edges in the same layout -- optional, only built for bidirectional search on directed graphs
+    uint32_t *reverseEdgeTargets;
+    float *reverseEdgeCosts;
+    float *positions;                   // x and y of every node -- optional
+    ASGraphHeuristic heuristic;
+    float heuristicScale;
+    uint32_t landmarkCount;
+    uint32_t landmarkStride;            // landmarkCount rounded up to a multiple of 4, the padding distances are 0
+    uint32_t *landmarks;
+    float *landmarkFrom;                // distances from every landmark to the node, landmarkStride floats per node -- INFINITY if unreachable
+    float *landmarkTo;                  // distances from the node to every landmark, same layout
+    uint32_t *originalIDs;              // id of every node before the graph was first reordered -- optional, NULL if it never was
+    uint32_t *reorderedIDs;             // the inverse, current id of every original id
+    void *mapping;                      // file mapping of a graph opened with ASGraphOpenFile(), arrays inside it are not freed
+    size_t mappingSize;
+};
+
+struct __ASContractionHierarchy {
+    uint32_t nodeCount;
+    uint32_t *ranks;                    // contraction order of every node id
+    uint32_t *nodes;                    // node id of every rank
+    // the graphs below are numbered by rank, which keeps the few high ranked nodes that every query visits close together
+    struct __ASGraph up;                // edges to higher ranked nodes, searched forward from the start
+    struct __ASGraph down;              // edges from higher ranked nodes, stored reversed and searched backward from the goal
+    uint32_t *upMiddles;                // rank of the node a shortcut bypasses, ASNodeIDNull for edges of the original graph -- parallel to up.edgeTargets
+    uint32_t *downMiddles;              // same for down.edgeTargets
+    size_t shortcutCount;
+};
+
+struct __ASGrid {
+    uint32_t width;
+    uint32_t height;
+    ASGridConnectivity connectivity;
+    uint32_t rowWords;                  // 64 bit words per row of rows
+    uint32_t columnWords;               // same for columns
+    uint64_t *rows;                     // bit x of row y is set if cell x, y is open, the padding bits are clear
+    uint64_t *columns;                  // the same bits transposed, so vertical jumps scan words too
+    int32_t *jumps;                     // JPS+ table of GridJump() for every cell and direction -- optional
+};
+
+// search state of a workspace, the generic searches live in AStar.c and the searches by node id share the DenseNodes helpers below
+typedef struct {
+    unsigned isClosed:1;
+    unsigned isOpen:1;
+    unsigned isGoal:1;
+    unsigned hasParent:1;
+    unsigned hasEstimatedCost:1;
+    float estimatedCost;
+    float cost;
+    size_t openIndex;
+    size_t parentIndex;
+    int8_t nodeKey[];
+} NodeRecord;
+
+typedef struct {
+    size_t hash;
+    size_t recordIndex;
+    size_t generation;
+} IndexSlot;
+
+typedef struct {
+    float rank;
+    uint32_t id;
+} OpenEntry;
+
+typedef struct {
+    size_t arity;
+    size_t capacity;
+    size_t count;
+    OpenEntry *entries;                 // d-ary heap of (rank, id) pairs, entries whose node was reopened or closed since are skipped when they surface
+} OpenEntryHeap;
+
+struct __VisitedNodes {
+    const ASPathNodeSource *source;
+    void *context;
+    SearchMemory *memory;               // the workspace's budget for the buffers below
+    size_t nodeRecordsCapacity;
+    size_t nodeRecordsCount;
+    size_t nodeRecordsSize;             // allocated bytes of nodeRecords, kept so the capacity can be recomputed when nodeSize changes
+    void *nodeRecords;
+    size_t nodeRecordsIndexCapacity;
+    size_t *nodeRecordsIndex;           // array of nodeRecords indexes, kept sorted by nodeRecords[i]->nodeKey using source->nodeComparator
+    size_t indexSlotsCapacity;
+    size_t indexGeneration;             // slots stamped with an older generation are empty, so the hash index is cleared without touching it
+    IndexSlot *indexSlots;              // open addressing hash table of nodeRecords indexes, only used when source->nodeHash is set
+    size_t openNodesCapacity;
+    size_t openNodesCount;
+    size_t *openNodes;                  // binary heap of nodeRecords indexes, sorted by the nodeRecords[i]->rank
+    ASOpenSet openSet;                  // ASOpenSetBinaryHeap for openNodes, or one of the d-ary heaps for openEntries
+    OpenEntryHeap openEntries;          // the ids are nodeRecords indexes
+    int tieBreakHigherCost;             // of the nodes tied on rank, the one with the higher cost goes first, see SearchWorkspaceSetTieBreak()
+    ASSearchStats stats;                // counts of the current search, always kept since a few increments cost less than checking whether anyone reads them
+#ifdef ASTAR_TRACE
+    ASTraceCallback traceCallback;
+    void *traceContext;
+#endif
+};
+typedef struct __VisitedNodes *VisitedNodes;
+
+enum {
+    DenseRecordOpen = 1 << 0,
+    DenseRecordClosed = 1 << 1,
+    DenseRecordHasEstimatedCost = 1 << 2,
+    DenseRecordGoal = 1 << 3,           // a goal of ASPathCreateMultiWithNodeIDs() that is not settled yet
+};
+
+typedef struct {
+    float estimatedCost;
+    float cost;
+    uint32_t parent;
+    uint32_t openIndex;
+    uint32_t generation;                // the record only holds search state if this matches the current generation
+    uint32_t flags;
+} DenseRecord;
+
+typedef struct {
+    uint32_t id;
+    uint32_t next;                      // next entry in the same bucket, or UINT32_MAX
+} BucketEntry;
+
+struct __DenseNodes {
+    uint32_t nodeCount;
+    const ASPathNodeIDSource *source;   // neighbors come from source->nodeNeighbors, or from the graph if source is NULL
+    const struct __ASGraph *graph;
+    void *context;
+    uint32_t generation;
+    ASOpenSet openSet;
+    float bucketScale;                  // 1 / costQuantum, turns a rank into its bucket
+    size_t visitedCount;
+    const uint32_t *goals;              // the heuristic estimates the cost to the closest of these
+    size_t goalCount;
+    int reverse;                        // expands along reverse edges -- the backward half of a bidirectional search
+    uint32_t balancedStart;             // ends of a bidirectional search, whose ranks use the average of both heuristics -- ASNodeIDNull otherwise
+    uint32_t balancedGoal;
+    float balancedOffset;               // half the start to goal estimate, so both halves rank their origin 0
+    struct __DenseNodes *opposite;      // the other half of a bidirectional search
+    float meetCost;                     // cheapest path found through a node reached by both halves
+    uint32_t meetNode;
+    SearchMemory *memory;               // the workspace's budget for the buffers below
+    size_t recordsCapacity;
+    DenseRecord *records;               // search state indexed directly by node id
+    size_t openNodesCapacity;
+    size_t openNodesCount;
+    uint32_t *openNodes;                // binary heap of node ids, sorted by the records[id] rank
+    OpenEntryHeap openEntries;
+    size_t bucketsCapacity;
+    size_t bucketsUsed;                 // buckets past this are known to be empty
+    size_t bucketsFirst;                // buckets before this are known to be empty
+    uint32_t *buckets;                  // heads of the bucket entry lists indexed by rank / costQuantum, UINT32_MAX when empty
+    size_t bucketEntriesCapacity;
+    size_t bucketEntriesCount;
+    BucketEntry *bucketEntries;         // like openEntries, stale entries are left in their bucket and skipped when they surface
+    ASSearchStats stats;                // counts of the current search, same as VisitedNodes
+#ifdef ASTAR_TRACE
+    ASTraceCallback traceCallback;
+    void *traceContext;
+#endif
+};
+typedef struct __DenseNodes *DenseNodes;
+
+typedef struct {
+    uint32_t *nodes;                    // the caller's buffer, or NULL to allocate an ASPath
+    float *costs;                       // optional with a caller's buffer
+    size_t capacity;
+    size_t count;                       // nodes in the path, 0 if there is none
+    ASPath path;
+} DensePathOutput;
+
+typedef struct {
+    VisitedNodes nodes;
+    size_t index;
+} Node;
+
+#ifdef ASTAR_TRACE
+#define TraceSearchEvent(nodes, event, node, cost) do { if ((nodes)->traceCallback) { (nodes)->traceCallback((event), (node), (cost), (nodes)->traceContext); } } while (0)
+#else
+#define TraceSearchEvent(nodes, event, node, cost) ((void)0)
+#endif
+
+struct __ASSearchWorkspace {
+    ASSearchOptions options;
+    size_t goalNodesCapacity;
+    Node *goalNodes;                    // goals of ASPathCreateMulti()
+    struct __VisitedNodes visitedNodes;
+    struct __DenseNodes denseNodes;
+    struct __DenseNodes reverseDenseNodes;  // backward half of a bidirectional search
+    struct __ASNeighborList neighborList;
+    SearchMemory memory;                // shared by all the buffers above
+    size_t visitedCount;                // nodes reached by the last search
+    ASSearchStatus status;              // how the last search ended
+};
+
+// allocates a path of count nodes of nodeSize bytes in a single block -- NULL if out of memory
+ASPath ASPathAlloc(size_t nodeSize, size_t count);
+
+// makes ASPathCreateWithWorkspace() take the node with the higher cost first among those tied on rank -- a private option, the
+// searches that set it clear it again when done
+void SearchWorkspaceSetTieBreak(ASSearchWorkspace workspace, int higherCost);
+
+// makes the last search through workspace report ASSearchOutOfMemory, for allocations made after the search itself, like the path
+void SearchWorkspaceSetOutOfMemory(ASSearchWorkspace workspace);
+
+// resizes buffer from bytes to grownBytes against the memory limit -- NULL with buffer left as it was if it cannot
+void *ResizeSearchBuffer(SearchMemory *memory, void *buffer, size_t bytes, size_t grownBytes);
+
+// makes room for at least one more element of buffer and updates capacity -- NULL with both left as they were if it cannot
+void *GrowSearchBuffer(SearchMemory *memory, void *buffer, size_t *capacity, size_t elementSize);
+
+// resets the workspace's memory state for a new search and returns its start time
+double BeginSearch(ASSearchWorkspace workspace);
+
+// sets the workspace's status, visited count and stats after a search of the id engine -- backward is the other half of a bidirectional search or NULL
+void FinishDenseSearch(ASSearchWorkspace workspace, double begin, DenseNodes forward, DenseNodes backward);
+
+// calls run(workspace, i, context) for every i < count on the pool's workers, each with its own workspace -- a temporary pool of one thread per core if pool is NULL
+// returns 0 without calling run if the temporary pool could not be created
+int SearchPoolRun(ASSearchPool pool, size_t count, void (*run)(ASSearchWorkspace workspace, uint32_t index, void *context), void *context);
+
+// fills distances with the cost from origin to every node of the graph (to origin if reverse is set), INFINITY if unreachable
+void ASGraphComputeDistances(ASSearchWorkspace workspace, ASGraph graph, uint32_t origin, int reverse, float *distances);
+
+static inline int GridCellIsOpen(ASGrid grid, int64_t x, int64_t y)
+{
+    if (x < 0 || y < 0 || x >= grid->width || y >= grid->height) {
+        return 0;
+    }
+    return (grid->rows[(size_t)y * grid->rowWords + (size_t)(x >> 6)] >> (x & 63)) & 1;
+}
+
+static inline void NeighborListBind(ASNeighborList list, size_t nodeSize)
+{
+    if (list->nodeSize != nodeSize) {
+        // the existing buffers are sized for another node size, let ASNeighborListAdd() allocate new ones
+        if (list->memory) {
+            list->memory->used -= list->capacity * (sizeof(float) + list->nodeSize);
+        }
+        free(list->costs);
+        free(list->nodeKeys);
+        list->costs = NULL;
+        list->nodeKeys = NULL;
+        list->capacity = 0;
+    }
+    list->nodeSize = nodeSize;
+    list->count = 0;
+}
+
+static inline void NeighborListFree(ASNeighborList list)
+{
+    free(list->costs);
+    free(list->nodeKeys);
+}
+
+static inline int GraphHasHeuristic(const struct __ASGraph *graph)
+{
+    return (graph->heuristic != ASGraphHeuristicNone && graph->positions) || graph->landmarkCount > 0;
+}
+
+static inline float GraphLandmarkHeuristic(const struct __ASGraph *graph, uint32_t fromNode, uint32_t toNode)
+{
+    // triangle inequality, for every landmark L: d(v,t) >= d(L,t) - d(L,v) and d(v,t) >= d(v,L) - d(t,L)
+    // pairs with an unreachable distance give no bound
+    const size_t stride = graph->landmarkStride;
+    const float *fromV = graph->landmarkFrom + (size_t)fromNode * stride;
+    const float *fromT = graph->landmarkFrom + (size_t)toNode * stride;
+    const float *toV = graph->landmarkTo + (size_t)fromNode * stride;
+    const float *toT = graph->landmarkTo + (size_t)toNode * stride;
+
+#ifdef __SSE2__
+    const __m128 infinity = _mm_set1_ps(INFINITY);
+    __m128 best = _mm_setzero_ps();
+
+    for (size_t i=0; i<stride; i+=4) {
+        const __m128 a = _mm_loadu_ps(fromT + i);
+        const __m128 b = _mm_loadu_ps(fromV + i);
+        const __m128 c = _mm_loadu_ps(toV + i);
+        const __m128 d = _mm_loadu_ps(toT + i);
+        const __m128 fromBound = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(a, infinity), _mm_cmplt_ps(b, infinity)), _mm_sub_ps(a, b));
+        const __m128 toBound = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(c, infinity), _mm_cmplt_ps(d, infinity)), _mm_sub_ps(c, d));
+        best = _mm_max_ps(best, _mm_max_ps(fromBound, toBound));
+    }
+
+    best = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(1, 0, 3, 2)));
+    best = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(best);
+#else
+    float best = 0;
+
+    for (size_t i=0; i<stride; i++) {
+        if (fromT[i] < INFINITY && fromV[i] < INFINITY && fromT[i] - fromV[i] > best) {
+            best = fromT[i] - fromV[i];
+        }
+        if (toV[i] < INFINITY && toT[i] < INFINITY && toV[i] - toT[i] > best) {
+            best = toV[i] - toT[i];
+        }
+    }
+
+    return best;
+#endif
+}
+
+static inline float GraphHeuristic(const struct __ASGraph *graph, uint32_t fromNode, uint32_t toNode)
+{
+    // the larger of two consistent heuristics is still consistent
+    float estimate = 0;
+
+    if (graph->heuristic != ASGraphHeuristicNone && graph->positions) {
+        const float dx = graph->positions[2 * fromNode] - graph->positions[2 * toNode];
+        const float dy = graph->positions[2 * fromNode + 1] - graph->positions[2 * toNode + 1];
+
+        if (graph->heuristic == ASGraphHeuristicManhattan) {
+            estimate = (fabsf(dx) + fabsf(dy)) * graph->heuristicScale;
+        } else {
+            estimate = sqrtf(dx * dx + dy * dy) * graph->heuristicScale;
+        }
+    }
+
+    if (graph->landmarkCount > 0) {
+        estimate = fmaxf(estimate, GraphLandmarkHeuristic(graph, fromNode, toNode));
+    }
+
+    return estimate;
+}
+
+// memory budget, open set and node id engine helpers used by the searches of AStar.c, AStarCH.c and AStarGrid.c
+
+static inline int TakeSearchMemory(SearchMemory *memory, size_t bytes)
+{
+    // counts bytes against the limit, a search that would go over it is marked as out of memory instead
+    if (memory->limit && (memory->used > memory->limit || bytes > memory->limit - memory->used)) {
+        memory->exceeded = 1;
+        return 0;
+    }
+    memory->used += bytes;
+    return 1;
+}
+
+static inline size_t GrowSearchCapacity(SearchMemory *memory, size_t capacity, size_t minCapacity, size_t elementSize)
+{
+    // doubles capacity, or takes what is left below the limit if that still holds minCapacity -- 0 if it does not
+    size_t grownCapacity = 1 + (capacity * 2);
+    if (grownCapacity < minCapacity) {
+        grownCapacity = minCapacity;
+    }
+
+    if (memory->limit) {
+        const size_t left = (memory->used < memory->limit)? (memory->limit - memory->used) / elementSize : 0;
+        if (grownCapacity - capacity > left) {
+            grownCapacity = capacity + left;
+        }
+    }
+
+    if (grownCapacity < minCapacity) {
+        memory->exceeded = 1;
+        return 0;
+    }
+    return grownCapacity;
+}
+
+static inline float NeighborListGetEdgeCost(ASNeighborList list, size_t index)
+{
+    return list->costs[index];
+}
+
+static inline void CountOpenSetPush(ASSearchStats *stats)
+{
+    const size_t openCount = ++stats->pushes - stats->pops;
+    if (openCount > stats->peakOpenCount) {
+        stats->peakOpenCount = openCount;
+    }
+}
+
+static inline size_t MinOpenEntryIndex(const OpenEntry *entries, size_t first, size_t count)
+{
+    // returns the index of the lowest ranked entry in entries[first..first+count)
+#if defined(__SSE2__)
+    if (count == 4 || count == 8) {
+        // gather the ranks of the (rank, id) pairs into lanes, reduce to the minimum and find its lane
+        const float *pairs = (const float *)(entries + first);
+        __m128 ranks = _mm_shuffle_ps(_mm_loadu_ps(pairs), _mm_loadu_ps(pairs + 4), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 ranksHigh = ranks;
+        if (count == 8) {
+            ranksHigh = _mm_shuffle_ps(_mm_loadu_ps(pairs + 8), _mm_loadu_ps(pairs + 12), _MM_SHUFFLE(2, 0, 2, 0));
+        }
+        __m128 min = _mm_min_ps(ranks, ranksHigh);
+        min = _mm_min_ps(min, _mm_shuffle_ps(min, min, _MM_SHUFFLE(2, 3, 0, 1)));
+        min = _mm_min_ps(min, _mm_shuffle_ps(min, min, _MM_SHUFFLE(1, 0, 3, 2)));
+        const int mask = _mm_movemask_ps(_mm_cmpeq_ps(ranks, min)) | (_mm_movemask_ps(_mm_cmpeq_ps(ranksHigh, min)) << 4);
+        return first + __builtin_ctz(mask);
+    }
+#endif
+    size_t smallestIndex = first;
+    for (size_t i=first+1; i<first+count; i++) {
+        if (entries[i].rank < entries[smallestIndex].rank) {
+            smallestIndex = i;
+        }
+    }
+    return smallestIndex;
+}
+
+static inline int PushOpenEntry(OpenEntryHeap *heap, SearchMemory *memory, uint32_t id, float rank)
+{
+    if (heap->count == heap->capacity) {
+        OpenEntry *entries = GrowSearchBuffer(memory, heap->entries, &heap->capacity, sizeof(OpenEntry));
+        if (!entries) {
+            return 0;
+        }
+        heap->entries = entries;
+    }
+
+    // moves the hole up until the parent ranks lower, so every level costs one write
+    const size_t arity = heap->arity;
+    size_t index = heap->count++;
+
+    while (index > 0) {
+        const size_t parentIndex = (index - 1) / arity;
+        if (heap->entries[parentIndex].rank < rank) {
+            break;
+        }
+        heap->entries[index] = heap->entries[parentIndex];
+        index = parentIndex;
+    }
+
+    heap->entries[index] = (OpenEntry){rank, id};
+    return 1;
+}
+
+static inline void PopOpenEntry(OpenEntryHeap *heap, ASSearchStats *stats)
+{
+    // moves the hole left by the root down along the lowest ranked children until the last entry fits in it
+    const size_t arity = heap->arity;
+    const size_t count = --heap->count;
+    const OpenEntry last = heap->entries[count];
+    stats->pops++;
+    size_t index = 0;
+
+    for (;;) {
+        const size_t firstChild = (arity * index) + 1;
+        if (firstChild >= count) {
+            break;
+        }
+
+        const size_t childCount = (count - firstChild < arity)? count - firstChild : arity;
+        const size_t smallestIndex = MinOpenEntryIndex(heap->entries, firstChild, childCount);
+        if (!(heap->entries[smallestIndex].rank < last.rank)) {
+            break;
+        }
+
+        heap->entries[index] = heap->entries[smallestIndex];
+        index = smallestIndex;
+    }
+
+    heap->entries[index] = last;
+}
+
+static inline void ClearDenseBuckets(DenseNodes nodes)
+{
+    // only the buckets touched by the previous search can hold anything
+    if (nodes->bucketsUsed > 0) {
+        memset(nodes->buckets, 0xff, nodes->bucketsUsed * sizeof(uint32_t));
+    }
+    nodes->bucketsUsed = 0;
+    nodes->bucketsFirst = 0;
+    nodes->bucketEntriesCount = 0;
+}
+
+static inline int DenseNodesPrepare(DenseNodes nodes, uint32_t nodeCount, const ASSearchOptions *options)
+{
+    // records are only valid when stamped with the current generation, so a new search never has to clear them
+    // returns 0 if there is no memory for a record per node, the search cannot start then
+    nodes->nodeCount = nodeCount;
+    nodes->source = NULL;
+    nodes->graph = NULL;
+    nodes->context = NULL;
+    nodes->visitedCount = 0;
+    nodes->openNodesCount = 0;
+    nodes->openEntries.count = 0;
+    nodes->reverse = 0;
+    nodes->balancedStart = ASNodeIDNull;
+    nodes->balancedGoal = ASNodeIDNull;
+    nodes->opposite = NULL;
+    memset(&nodes->stats, 0, sizeof(ASSearchStats));
+    ClearDenseBuckets(nodes);
+
+    // a bucket queue without a usable cost quantum falls back to the binary heap
+    nodes->openSet = options->openSet;
+    nodes->openEntries.arity = (options->openSet == ASOpenSet8AryHeap)? 8 : 4;
+    if (nodes->openSet == ASOpenSetBucketQueue && !(options->costQuantum > 0)) {
+        nodes->openSet = ASOpenSetBinaryHeap;
+    }
+    nodes->bucketScale = (nodes->openSet == ASOpenSetBucketQueue)? 1.f / options->costQuantum : 0;
+
+    if (nodes->recordsCapacity < nodeCount) {
+        DenseRecord *records = ResizeSearchBuffer(nodes->memory, nodes->records, nodes->recordsCapacity * sizeof(DenseRecord), nodeCount * sizeof(DenseRecord));
+        if (!records) {
+            return 0;
+        }
+        nodes->records = records;
+        memset(nodes->records + nodes->recordsCapacity, 0, (nodeCount - nodes->recordsCapacity) * sizeof(DenseRecord));
+        nodes->recordsCapacity = nodeCount;
+    }
+
+    if (++nodes->generation == 0) {
+        // the generation wrapped around, so old stamps could look current again
+        for (size_t i=0; i<nodes->recordsCapacity; i++) {
+            nodes->records[i].generation = 0;
+        }
+        nodes->generation = 1;
+    }
+
+    return 1;
+}
+
+static inline int DenseNodesBind(DenseNodes nodes, const ASPathNodeIDSource *source, const struct __ASGraph *graph, void *context, const ASSearchOptions *options)
+{
+    const int prepared = DenseNodesPrepare(nodes, source? source->nodeCount : graph->nodeCount, options);
+    nodes->source = source;
+    nodes->graph = graph;
+    nodes->context = context;
+    return prepared;
+}
+
+static inline DenseRecord *GetDenseRecord(DenseNodes nodes, uint32_t id)
+{
+    DenseRecord *record = &nodes->records[id];
+
+    if (record->generation != nodes->generation) {
+        record->generation = nodes->generation;
+        record->flags = 0;
+        record->parent = ASNodeIDNull;
+        record->cost = 0;
+        nodes->visitedCount++;
+    }
+
+    return record;
+}
+
+static inline float GetDenseRank(DenseNodes nodes, uint32_t id)
+{
+    const DenseRecord *record = &nodes->records[id];
+    return record->estimatedCost + record->cost;
+}
+
+static inline void SwapDenseOpenNodesAtIndexes(DenseNodes nodes, size_t index1, size_t index2)
+{
+    if (index1 != index2) {
+        const uint32_t id1 = nodes->openNodes[index1];
+        const uint32_t id2 = nodes->openNodes[index2];
+
+        nodes->records[id1].openIndex = index2;
+        nodes->records[id2].openIndex = index1;
+
+        nodes->openNodes[index1] = id2;
+        nodes->openNodes[index2] = id1;
+    }
+}
+
+static inline void DidRemoveFromDenseOpenSetAtIndex(DenseNodes nodes, size_t index)
+{
+    size_t smallestIndex = index;
+    
+    do {
+        if (smallestIndex != index) {
+            SwapDenseOpenNodesAtIndexes(nodes, smallestIndex, index);
+            index = smallestIndex;
+        }
+
+        const size_t leftIndex = (2 * index) + 1;
+        const size_t rightIndex = (2 * index) + 2;
+        
+        if (leftIndex < nodes->openNodesCount && GetDenseRank(nodes, nodes->openNodes[leftIndex]) < GetDenseRank(nodes, nodes->openNodes[smallestIndex])) {
+            smallestIndex = leftIndex;
+        }
+        
+        if (rightIndex < nodes->openNodesCount && GetDenseRank(nodes, nodes->openNodes[rightIndex]) < GetDenseRank(nodes, nodes->openNodes[smallestIndex])) {
+            smallestIndex = rightIndex;
+        }
+    } while (smallestIndex != index);
+}
+
+static inline void DidInsertIntoDenseOpenSetAtIndex(DenseNodes nodes, size_t index)
+{
+    while (index > 0) {
+        const size_t parentIndex = (index - 1) / 2;
+        
+        if (GetDenseRank(nodes, nodes->openNodes[parentIndex]) < GetDenseRank(nodes, nodes->openNodes[index])) {
+            break;
+        } else {
+            SwapDenseOpenNodesAtIndexes(nodes, parentIndex, index);
+            index = parentIndex;
+        }
+    }
+}
+
+static inline void RemoveFromDenseOpenNodes(DenseNodes nodes, DenseRecord *record)
+{
+    nodes->openNodesCount--;
+    nodes->stats.pops++;
+    
+    const size_t index = record->openIndex;
+    SwapDenseOpenNodesAtIndexes(nodes, index, nodes->openNodesCount);
+    DidRemoveFromDenseOpenSetAtIndex(nodes, index);
+
+    // the node moved into the hole came from the bottom of the heap, so it may also have to move up
+    if (index < nodes->openNodesCount) {
+        DidInsertIntoDenseOpenSetAtIndex(nodes, index);
+    }
+}
+
+static inline int AddToDenseOpenNodes(DenseNodes nodes, uint32_t id, DenseRecord *record)
+{
+    if (nodes->openNodesCount == nodes->openNodesCapacity) {
+        uint32_t *openNodes = GrowSearchBuffer(nodes->memory, nodes->openNodes, &nodes->openNodesCapacity, sizeof(uint32_t));
+        if (!openNodes) {
+            return 0;
+        }
+        nodes->openNodes = openNodes;
+    }
+
+    const size_t openIndex = nodes->openNodesCount;
+    nodes->openNodes[openIndex] = id;
+    nodes->openNodesCount++;
+
+    record->openIndex = openIndex;
+
+    DidInsertIntoDenseOpenSetAtIndex(nodes, openIndex);
+    return 1;
+}
+
+static inline size_t GetDenseBucket(DenseNodes nodes, float rank)
+{
+    const float bucket = rank * nodes->bucketScale;
+    return (bucket > 0)? (size_t)bucket : 0;
+}
+
+static inline int PushDenseBucketEntry(DenseNodes nodes, uint32_t id, float rank)
+{
+    const size_t bucket = GetDenseBucket(nodes, rank);
+
+    if (bucket >= nodes->bucketsCapacity) {
+        const size_t capacity = GrowSearchCapacity(nodes->memory, nodes->bucketsCapacity, bucket + 1, sizeof(uint32_t));
+        uint32_t *buckets = capacity? ResizeSearchBuffer(nodes->memory, nodes->buckets, nodes->bucketsCapacity * sizeof(uint32_t), capacity * sizeof(uint32_t)) : NULL;
+        if (!buckets) {
+            return 0;
+        }
+        nodes->buckets = buckets;
+        memset(nodes->buckets + nodes->bucketsCapacity, 0xff, (capacity - nodes->bucketsCapacity) * sizeof(uint32_t));
+        nodes->bucketsCapacity = capacity;
+    }
+
+    if (nodes->bucketEntriesCount == nodes->bucketEntriesCapacity) {
+        BucketEntry *bucketEntries = GrowSearchBuffer(nodes->memory, nodes->bucketEntries, &nodes->bucketEntriesCapacity, sizeof(BucketEntry));
+        if (!bucketEntries) {
+            return 0;
+        }
+        nodes->bucketEntries = bucketEntries;
+    }
+
+    // buckets are LIFO lists, so among nodes of the same bucket the most recently reached one is expanded first
+    const uint32_t entry = nodes->bucketEntriesCount++;
+    nodes->bucketEntries[entry] = (BucketEntry){id, nodes->buckets[bucket]};
+    nodes->buckets[bucket] = entry;
+
+    if (bucket >= nodes->bucketsUsed) {
+        nodes->bucketsUsed = bucket + 1;
+    }
+    if (bucket < nodes->bucketsFirst) {
+        // only happens with an inconsistent heuristic, ranks are monotone otherwise
+        nodes->bucketsFirst = bucket;
+    }
+    return 1;
+}
+
+static inline int DenseOpenEntryIsCurrent(DenseNodes nodes, OpenEntry entry)
+{
+    // an entry is stale once its node left the open set or was reopened with a lower rank
+    return (nodes->records[entry.id].flags & DenseRecordOpen) && entry.rank == GetDenseRank(nodes, entry.id);
+}
+
+static inline int DenseBucketEntryIsCurrent(DenseNodes nodes, size_t bucket, BucketEntry entry)
+{
+    // same as DenseOpenEntryIsCurrent(), but a lower rank may still land in the same bucket
+    return (nodes->records[entry.id].flags & DenseRecordOpen) && GetDenseBucket(nodes, GetDenseRank(nodes, entry.id)) == bucket;
+}
+
+static inline int HasDenseOpenNode(DenseNodes nodes)
+{
+    switch (nodes->openSet) {
+        case ASOpenSet4AryHeap:
+        case ASOpenSet8AryHeap:
+            while (nodes->openEntries.count > 0 && !DenseOpenEntryIsCurrent(nodes, nodes->openEntries.entries[0])) {
+                PopOpenEntry(&nodes->openEntries, &nodes->stats);
+            }
+            return nodes->openEntries.count > 0;
+
+        case ASOpenSetBucketQueue:
+            while (nodes->bucketsFirst < nodes->bucketsUsed) {
+                const uint32_t entry = nodes->buckets[nodes->bucketsFirst];
+                if (entry == UINT32_MAX) {
+                    nodes->bucketsFirst++;
+                } else if (DenseBucketEntryIsCurrent(nodes, nodes->bucketsFirst, nodes->bucketEntries[entry])) {
+                    return 1;
+                } else {
+                    nodes->buckets[nodes->bucketsFirst] = nodes->bucketEntries[entry].next;
+                    nodes->stats.pops++;
+                }
+            }
+            return 0;
+
+        default:
+            return nodes->openNodesCount > 0;
+    }
+}
+
+static inline uint32_t GetDenseOpenNode(DenseNodes nodes)
+{
+    // only valid after HasDenseOpenNode() returned true
+    switch (nodes->openSet) {
+        case ASOpenSet4AryHeap:
+        case ASOpenSet8AryHeap:     return nodes->openEntries.entries[0].id;
+        case ASOpenSetBucketQueue:  return nodes->bucketEntries[nodes->buckets[nodes->bucketsFirst]].id;
+        default:                    return nodes->openNodes[0];
+    }
+}
+
+static inline void RemoveDenseNodeFromOpenSet(DenseNodes nodes, uint32_t id)
+{
+    DenseRecord *record = &nodes->records[id];
+
+    if (record->flags & DenseRecordOpen) {
+        record->flags &= ~DenseRecordOpen;
+
+        // any other entry of the node is now stale and gets skipped when it surfaces
+        switch (nodes->openSet) {
+            case ASOpenSet4AryHeap:
+            case ASOpenSet8AryHeap:
+                if (nodes->openEntries.entries[0].id == id) {
+                    PopOpenEntry(&nodes->openEntries, &nodes->stats);
+                }
+                break;
+
+            case ASOpenSetBucketQueue:
+                if (nodes->bucketsFirst < nodes->bucketsUsed && nodes->buckets[nodes->bucketsFirst] != UINT32_MAX && nodes->bucketEntries[nodes->buckets[nodes->bucketsFirst]].id == id) {
+                    nodes->buckets[nodes->bucketsFirst] = nodes->bucketEntries[nodes->buckets[nodes->bucketsFirst]].next;
+                    nodes->stats.pops++;
+                }
+                break;
+
+            default:
+                RemoveFromDenseOpenNodes(nodes, record);
+                break;
+        }
+    }
+}
+
+static inline void AddDenseNodeToOpenSet(DenseNodes nodes, uint32_t id, float cost, uint32_t parent)
+{
+    DenseRecord *record = &nodes->records[id];
+    int added;
+
+    record->parent = parent;
+    record->cost = cost;
+
+    switch (nodes->openSet) {
+        case ASOpenSet4AryHeap:
+        case ASOpenSet8AryHeap:     added = PushOpenEntry(&nodes->openEntries, nodes->memory, id, GetDenseRank(nodes, id)); break;
+        case ASOpenSetBucketQueue:  added = PushDenseBucketEntry(nodes, id, GetDenseRank(nodes, id)); break;
+        default:                    added = AddToDenseOpenNodes(nodes, id, record); break;
+    }
+
+    // a node the open set has no room for stays out of it, the search stops as out of memory
+    if (added) {
+        record->flags |= DenseRecordOpen;
+        CountOpenSetPush(&nodes->stats);
+        TraceSearchEvent(nodes, ASTraceOpen, &id, cost);
+    }
+}
+
+static inline int DenseNodesHaveHeuristic(DenseNodes nodes)
+{
+    return nodes->source? nodes->source->pathCostHeuristic != NULL : GraphHasHeuristic(nodes->graph);
+}
+
+static inline float GetDenseHeuristic(DenseNodes nodes, uint32_t fromNode, uint32_t toNode)
+{
+    // only valid if DenseNodesHaveHeuristic()
+    return nodes->source? nodes->source->pathCostHeuristic(fromNode, toNode, nodes->context) : GraphHeuristic(nodes->graph, fromNode, toNode);
+}
+
+static inline float GetDenseGoalsHeuristic(DenseNodes nodes, uint32_t id)
+{
+    // same as GetGoalsHeuristic(), goals that are not valid ids are ignored
+    if (!DenseNodesHaveHeuristic(nodes)) {
+        return 0;
+    }
+
+    float estimate = INFINITY;
+    for (size_t i=0; i<nodes->goalCount; i++) {
+        if (nodes->goals[i] < nodes->nodeCount) {
+            const float goalEstimate = GetDenseHeuristic(nodes, id, nodes->goals[i]);
+            if (goalEstimate < estimate) {
+                estimate = goalEstimate;
+            }
+        }
+    }
+
+    return (estimate < INFINITY)? estimate : 0;
+}
+
+static inline float GetDenseEstimatedCost(DenseNodes nodes, uint32_t id)
+{
+    if (nodes->balancedStart == ASNodeIDNull) {
+        return GetDenseGoalsHeuristic(nodes, id);
+    } else if (!DenseNodesHaveHeuristic(nodes)) {
+        return 0;
+    }
+
+    // both halves of a bidirectional search rank nodes by the average of the estimate to the goal and the negated estimate from the start
+    // the two potentials sum to a constant, so a consistent heuristic keeps every edge's reduced cost non-negative in both directions
+    const float toGoal = GetDenseHeuristic(nodes, id, nodes->balancedGoal);
+    const float fromStart = GetDenseHeuristic(nodes, nodes->balancedStart, id);
+    return (nodes->reverse? fromStart - toGoal : toGoal - fromStart) / 2 - nodes->balancedOffset;
+}
+
+static inline void MeetDenseNode(DenseNodes nodes, uint32_t id)
+{
+    // a node reached by both halves of a bidirectional search joins their paths
+    const DenseNodes opposite = nodes->opposite;
+    const DenseRecord *other = &opposite->records[id];
+
+    if (other->generation == opposite->generation && (other->flags & (DenseRecordOpen | DenseRecordClosed))) {
+        const float cost = nodes->records[id].cost + other->cost;
+        if (cost < nodes->meetCost) {
+            nodes->meetCost = cost;
+            nodes->meetNode = id;
+        }
+    }
+}
+
+static inline void RelaxDenseNeighbor(DenseNodes nodes, uint32_t current, uint32_t neighbor, float cost)
+{
+    DenseRecord *record = GetDenseRecord(nodes, neighbor);
+    nodes->stats.generated++;
+    
+    if (!(record->flags & DenseRecordHasEstimatedCost)) {
+        record->estimatedCost = GetDenseEstimatedCost(nodes, neighbor);
+        record->flags |= DenseRecordHasEstimatedCost;
+    }
+    
+    if ((record->flags & DenseRecordOpen) && cost < record->cost) {
+        RemoveDenseNodeFromOpenSet(nodes, neighbor);
+    }
+    
+    if ((record->flags & DenseRecordClosed) && cost < record->cost) {
+        record->flags &= ~DenseRecordClosed;
+        nodes->stats.reopened++;
+        TraceSearchEvent(nodes, ASTraceReopen, &neighbor, cost);
+    }
+    
+    if (!(record->flags & (DenseRecordOpen | DenseRecordClosed))) {
+        AddDenseNodeToOpenSet(nodes, neighbor, cost, current);
+    }
+
+    if (nodes->opposite) {
+        MeetDenseNode(nodes, neighbor);
+    }
+}
+
+static inline void ExpandDenseNode(DenseNodes nodes, ASNeighborList neighborList, uint32_t current, uint32_t prev_node)
+{
+    RemoveDenseNodeFromOpenSet(nodes, current);
+    nodes->records[current].flags |= DenseRecordClosed;
+    const float currentCost = nodes->records[current].cost;
+    nodes->stats.expanded++;
+    TraceSearchEvent(nodes, ASTraceExpand, &current, currentCost);
+
+    if (!nodes->source) {
+        // walk the graph's adjacency arrays directly, the edge costs are precomputed
+        // graphs without reverse edges are taken to be undirected
+        const struct __ASGraph *graph = nodes->graph;
+        const int reverse = nodes->reverse && graph->reverseEdgeOffsets;
+        const uint32_t *edgeOffsets = reverse? graph->reverseEdgeOffsets : graph->edgeOffsets;
+        const uint32_t *edgeTargets = reverse? graph->reverseEdgeTargets : graph->edgeTargets;
+        const float *edgeCosts = reverse? graph->reverseEdgeCosts : graph->edgeCosts;
+        const uint32_t last = edgeOffsets[current + 1];
+
+        for (uint32_t edge=edgeOffsets[current]; edge<last; edge++) {
+            RelaxDenseNeighbor(nodes, current, edgeTargets[edge], currentCost + edgeCosts[edge]);
+        }
+        return;
+    }
+
+    // search neighbors
+    neighborList->count = 0;
+
+    if (nodes->reverse && nodes->source->reverseNodeNeighbors) {
+        nodes->source->reverseNodeNeighbors(neighborList, current, currentCost, prev_node, nodes->context);
+    } else {
+        nodes->source->nodeNeighbors(neighborList, current, currentCost, prev_node, nodes->context);
+    }
+
+    const uint32_t *neighborIDs = neighborList->nodeKeys;
+
+    // iterate all neighbors
+    for (size_t n=0; n<neighborList->count; n++) {
+        const uint32_t neighbor = neighborIDs[n];
+        if (neighbor < nodes->nodeCount) {
+            RelaxDenseNeighbor(nodes, current, neighbor, currentCost + NeighborListGetEdgeCost(neighborList, n));
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,385 @@
+/*
+ Copyright (c) 2012, Sean Heber. All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ 1. Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ 
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ 3. Neither the name of Sean Heber nor the names of its contributors may
+ be used to endorse or promote products derived from this software without
+ specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL SEAN HEBER BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "AStarPrivate.h"
+#include <string.h>
+
+// a reservation holds a node for one time bucket, keyed by node << 32 | bucket in an open addressing hash table
+// the value is the node the robot moves to from there (the node itself while it waits), so a robot coming the other way
+// over the same edge in the same bucket is caught as a swap without a second table for the edges
+// a robot that reached its goal stays there, which is kept per node in parked rather than as reservations without end
+
+#define ReservationEmpty        UINT64_MAX
+#define ReservationNotParked    UINT32_MAX
+
+typedef struct {
+    uint64_t key;
+    uint32_t next;
+} Reservation;
+
+struct __ASReservationTable {
+    uint32_t nodeCount;
+    float timeStep;
+    float horizon;
+    size_t count;
+    size_t capacity;                    // slots, a power of two kept at least twice count
+    Reservation *slots;
+    uint32_t *parked;                   // bucket from which a robot stays on the node for good, ReservationNotParked otherwise
+    uint32_t *lastBuckets;              // highest reserved bucket of every node plus one, 0 if it has none
+    struct __ASNeighborList neighbors;  // edges of the node being expanded, as nodeNeighbors reports them
+};
+
+// search node of a cooperative search, the node id and the bucket it is reached in
+typedef struct {
+    uint32_t node;
+    uint32_t bucket;
+} CooperativeNode;
+
+typedef struct {
+    ASReservationTable table;
+    const ASPathNodeIDSource *source;
+    void *context;
+    float startTime;
+    uint32_t lastBucket;                // buckets past the horizon are not searched
+} CooperativeSearch;
+
+/********************************************/
+
+static inline uint32_t GetReservationBucket(ASReservationTable table, float time)
+{
+    // the costs along a path are sums of floats, a little slack keeps a time that lands on a bucket boundary in the later bucket
+    return (uint32_t)floorf(time / table->timeStep + 1e-4f);
+}
+
+static inline uint64_t ReservationKey(uint32_t node, uint32_t bucket)
+{
+    return ((uint64_t)node << 32) | bucket;
+}
+
+static inline size_t ReservationSlot(ASReservationTable table, uint64_t key)
+{
+    uint64_t h = key;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (size_t)h & (table->capacity - 1);
+}
+
+static inline const Reservation *GetReservation(ASReservationTable table, uint32_t node, uint32_t bucket)
+{
+    const uint64_t key = ReservationKey(node, bucket);
+    size_t slot = ReservationSlot(table, key);
+
+    while (table->slots[slot].key != ReservationEmpty) {
+        if (table->slots[slot].key == key) {
+            return &table->slots[slot];
+        }
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+
+    return NULL;
+}
+
+static void GrowReservations(ASReservationTable table)
+{
+    const size_t capacity = table->capacity * 2;
+    Reservation *slots = malloc(capacity * sizeof(Reservation));
+    Reservation *old = table->slots;
+    const size_t oldCapacity = table->capacity;
+
+    for (size_t i=0; i<capacity; i++) {
+        slots[i].key = ReservationEmpty;
+    }
+
+    table->slots = slots;
+    table->capacity = capacity;
+
+    for (size_t i=0; i<oldCapacity; i++) {
+        if (old[i].key != ReservationEmpty) {
+            size_t slot = ReservationSlot(table, old[i].key);
+            while (slots[slot].key != ReservationEmpty) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            slots[slot] = old[i];
+        }
+    }
+
+    free(old);
+}
+
+static void AddReservation(ASReservationTable table, uint32_t node, uint32_t bucket, uint32_t next)
+{
+    if (2 * (table->count + 1) > table->capacity) {
+        GrowReservations(table);
+    }
+
+    const uint64_t key = ReservationKey(node, bucket);
+    size_t slot = ReservationSlot(table, key);
+
+    while (table->slots[slot].key != ReservationEmpty) {
+        if (table->slots[slot].key == key) {
+            // reserved twice, the later path wins
+            table->slots[slot].next = next;
+            return;
+        }
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+
+    table->slots[slot] = (Reservation){key, next};
+    table->count++;
+
+    if (bucket + 1 > table->lastBuckets[node]) {
+        table->lastBuckets[node] = bucket + 1;
+    }
+}
+
+static inline int NodeIsFree(ASReservationTable table, uint32_t node, uint32_t bucket)
+{
+    return table->parked[node] > bucket && !GetReservation(table, node, bucket);
+}
+
+static int MoveIsFree(ASReservationTable table, uint32_t fromNode, uint32_t toNode, uint32_t fromBucket, uint32_t toBucket)
+{
+    // the robot holds fromNode until it arrives, must not meet a robot crossing the same edge the other way and needs toNode on arrival
+    const uint32_t lastBucket = (toBucket > fromBucket)? toBucket - 1 : fromBucket;
+
+    for (uint32_t bucket=fromBucket; bucket<=lastBucket; bucket++) {
+        if (bucket > fromBucket && !NodeIsFree(table, fromNode, bucket)) {
+            return 0;
+        }
+
+        const Reservation *reservation = GetReservation(table, toNode, bucket);
+        if (reservation && reservation->next == fromNode && fromNode != toNode) {
+            return 0;
+        }
+    }
+
+    return NodeIsFree(table, toNode, toBucket);
+}
+
+static void CooperativeNodeNeighbors(ASNeighborList neighbors, void *node, float node_cost, void *from_node, void *context)
+{
+    const CooperativeSearch *search = (const CooperativeSearch*)context;
+    const CooperativeNode current = *(const CooperativeNode*)node;
+    const uint32_t fromNode = from_node? ((const CooperativeNode*)from_node)->node : current.node;
+    ASReservationTable table = search->table;
+    ASNeighborList edges = &table->neighbors;
+    const float time = search->startTime + node_cost;
+
+    edges->count = 0;
+    search->source->nodeNeighbors(edges, current.node, node_cost, fromNode, search->context);
+
+    for (size_t i=0; i<edges->count; i++) {
+        const uint32_t neighbor = ((const uint32_t *)edges->nodeKeys)[i];
+        const uint32_t bucket = GetReservationBucket(table, time + edges->costs[i]);
+
+        if (neighbor < table->nodeCount && bucket <= search->lastBucket && MoveIsFree(table, current.node, neighbor, current.bucket, bucket)) {
+            ASNeighborListAdd(neighbors, &(CooperativeNode){neighbor, bucket}, edges->costs[i]);
+        }
+    }
+
+    // waiting in place for a bucket is always an option while the node stays free
+    const uint32_t waitBucket = current.bucket + 1;
+    if (waitBucket <= search->lastBucket && NodeIsFree(table, current.node, waitBucket)) {
+        ASNeighborListAdd(neighbors, &(CooperativeNode){current.node, waitBucket}, (float)waitBucket * table->timeStep - time);
+    }
+}
+
+static float CooperativePathCostHeuristic(void *fromNode, void *toNode, void *context)
+{
+    // the robot cannot stay on the goal before the bucket after its last reservation, which bounds the time left by the buckets until then --
+    // exact when the costs are multiples of timeStep, otherwise it may be up to one bucket too high, the resolution of the table anyway
+    const CooperativeSearch *search = (const CooperativeSearch*)context;
+    const CooperativeNode from = *(const CooperativeNode*)fromNode;
+    const uint32_t goal = ((const CooperativeNode*)toNode)->node;
+    const uint32_t goalBucket = search->table->lastBuckets[goal];
+    float estimate = search->source->pathCostHeuristic? search->source->pathCostHeuristic(from.node, goal, search->context) : 0;
+
+    if (goalBucket > from.bucket) {
+        estimate = fmaxf(estimate, (float)(goalBucket - from.bucket) * search->table->timeStep);
+    }
+
+    return estimate;
+}
+
+static int CooperativeEarlyExit(size_t visitedCount, void *visitingNode, void *goalNode, void *context)
+{
+    // the goal is reached once the robot can stay there, that is nobody passes it later or parks on it
+    const CooperativeSearch *search = (const CooperativeSearch*)context;
+    const CooperativeNode visiting = *(const CooperativeNode*)visitingNode;
+    const uint32_t goal = ((const CooperativeNode*)goalNode)->node;
+
+    if (visiting.node == goal && search->table->parked[goal] == ReservationNotParked && search->table->lastBuckets[goal] <= visiting.bucket) {
+        return 1;
+    }
+
+    return 0;
+}
+
+static size_t CooperativeNodeHash(void *node, void *context)
+{
+    const CooperativeNode n = *(const CooperativeNode*)node;
+    return ((size_t)n.node * 0x9e3779b1u) ^ n.bucket;
+}
+
+/********************************************/
+
+ASReservationTable ASReservationTableCreate(uint32_t nodeCount, float timeStep, float horizon)
+{
+    if (nodeCount == 0 || !(timeStep > 0) || !(horizon > 0)) {
+        return NULL;
+    }
+
+    ASReservationTable table = calloc(1, sizeof(struct __ASReservationTable));
+    table->nodeCount = nodeCount;
+    table->timeStep = timeStep;
+    table->horizon = horizon;
+    table->capacity = 1024;
+    table->slots = malloc(table->capacity * sizeof(Reservation));
+    table->parked = malloc(nodeCount * sizeof(uint32_t));
+    table->lastBuckets = malloc(nodeCount * sizeof(uint32_t));
+    NeighborListBind(&table->neighbors, sizeof(uint32_t));
+    ASReservationTableClear(table);
+
+    return table;
+}
+
+void ASReservationTableClear(ASReservationTable table)
+{
+    if (table) {
+        for (size_t i=0; i<table->capacity; i++) {
+            table->slots[i].key = ReservationEmpty;
+        }
+        for (uint32_t n=0; n<table->nodeCount; n++) {
+            table->parked[n] = ReservationNotParked;
+        }
+        memset(table->lastBuckets, 0, table->nodeCount * sizeof(uint32_t));
+        table->count = 0;
+    }
+}
+
+void ASReservationTableReservePath(ASReservationTable table, ASPath path, float startTime)
+{
+    if (!table || !path || path->count == 0 || path->nodeSize != sizeof(uint32_t)) {
+        return;
+    }
+
+    const uint32_t *nodes = (const uint32_t *)path->nodeKeys;
+
+    for (size_t i=0; i+1<path->count; i++) {
+        // every node is held from the bucket the robot arrives in until the bucket before it arrives at the next one
+        const uint32_t fromBucket = GetReservationBucket(table, startTime + path->costs[i]);
+        const uint32_t toBucket = GetReservationBucket(table, startTime + path->costs[i + 1]);
+        const uint32_t lastBucket = (toBucket > fromBucket)? toBucket - 1 : fromBucket;
+
+        if (nodes[i] < table->nodeCount) {
+            for (uint32_t bucket=fromBucket; bucket<=lastBucket; bucket++) {
+                AddReservation(table, nodes[i], bucket, nodes[i + 1]);
+            }
+        }
+    }
+
+    const uint32_t goal = nodes[path->count - 1];
+    const uint32_t goalBucket = GetReservationBucket(table, startTime + path->costs[path->count - 1]);
+
+    if (goal < table->nodeCount && goalBucket < table->parked[goal]) {
+        table->parked[goal] = goalBucket;
+    }
+}
+
+size_t ASReservationTableGetCount(ASReservationTable table)
+{
+    return table? table->count : 0;
+}
+
+void ASReservationTableDestroy(ASReservationTable table)
+{
+    if (table) {
+        free(table->slots);
+        free(table->parked);
+        free(table->lastBuckets);
+        NeighborListFree(&table->neighbors);
+        free(table);
+    }
+}
+
+ASPath ASPathCreateCooperative(ASSearchWorkspace workspace, ASReservationTable table, const ASPathNodeIDSource *source, void *context, uint32_t startNode, uint32_t goalNode, float startTime)
+{
+    if (!workspace || !table || !source || !source->nodeNeighbors || startNode >= table->nodeCount || goalNode >= table->nodeCount || startTime < 0) {
+        return NULL;
+    }
+
+    if (table->parked[goalNode] != ReservationNotParked) {
+        // another robot already stays there
+        return NULL;
+    }
+
+    // the search runs over (node, bucket) pairs through the hashed generic search, the goal pair is never generated
+    // so the search only ends at a goal through CooperativeEarlyExit()
+    const CooperativeSearch search = {table, source, context, startTime, GetReservationBucket(table, startTime + table->horizon)};
+    const ASPathNodeSource cooperativeSource = {
+        sizeof(CooperativeNode),
+        &CooperativeNodeNeighbors,
+        &CooperativePathCostHeuristic,
+        &CooperativeEarlyExit,
+        NULL,
+        &CooperativeNodeHash
+    };
+    CooperativeNode start = {startNode, GetReservationBucket(table, startTime)};
+    CooperativeNode goal = {goalNode, UINT32_MAX};
+
+    // of the pairs tied on cost plus estimate those further along in time go first, the cost is the time since startTime -- otherwise a
+    // robot waiting for its goal to clear expands every (node, bucket) pair it can reach until then
+    SearchWorkspaceSetTieBreak(workspace, 1);
+    ASPath searchPath = ASPathCreateWithWorkspace(workspace, &cooperativeSource, (void *)&search, &start, &goal);
+    SearchWorkspaceSetTieBreak(workspace, 0);
+
+    if (!searchPath) {
+        return NULL;
+    }
+
+    // the path lists node ids like the other id searches, a wait shows up as the same node twice
+    ASPath path = ASPathAlloc(sizeof(uint32_t), searchPath->count);
+    if (!path) {
+        SearchWorkspaceSetOutOfMemory(workspace);
+        ASPathDestroy(searchPath);
+        return NULL;
+    }
+    const CooperativeNode *searchNodes = (const CooperativeNode *)searchPath->nodeKeys;
+
+    for (size_t i=0; i<searchPath->count; i++) {
+        ((uint32_t *)path->nodeKeys)[i] = searchNodes[i].node;
+        path->costs[i] = searchPath->costs[i];
+    }
+
+    ASPathDestroy(searchPath);
+    ASReservationTableReservePath(table, path, startTime);
+
+    return path;
+}
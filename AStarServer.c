@@ -0,0 +1,625 @@
+/*
+ Copyright (c) 2012, Sean Heber. All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ 1. Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ 
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ 3. Neither the name of Sean Heber nor the names of its contributors may
+ be used to endorse or promote products derived from this software without
+ specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL SEAN HEBER BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// astar_server: loads a compiled graph once and answers batches of path queries for any number of clients
+//
+// usage: astar_server [-s socketPath] [-t threads] [-c] [-b] [-m bytes] graphFile
+//   -s  listens on a Unix domain socket, one client per connection -- without it the server reads stdin and writes stdout
+//   -t  number of worker threads, one per core by default
+//   -c  builds a contraction hierarchy at startup and answers every query from it
+//   -b  searches from both ends, see ASSearchOptions.bidirectional -- ignored with -c. Files written without reverse edges get them
+//       built at startup, as a directed graph would otherwise be searched as undirected -- store them with the file to share them
+//   -m  bytes the workspace of each worker may hold, see ASSearchOptions.memoryLimit
+//
+// the graph is mapped with ASGraphOpenFile(), so its landmark tables are shared with every other process that opens the file
+// node ids on the wire are the ones from before the graph was reordered with ASGraphReorder(), if it was
+// a client sends ASServerBatchHeader + queries (AStarServer.h) as often as it likes without waiting for answers, every query
+// goes to a shared queue the moment it is read and its ASServerResponse is sent the moment a worker has solved it
+// each connection has a reader and a writer thread, so reading the next batch and writing answers overlap with the searches
+
+#include "AStar.h"
+#include "AStarServer.h"
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define ServerReadChunk     256         // queries read and queued at a time
+#define ServerMaxPending    8192        // unanswered queries per connection before its reader waits, so a client that stops reading cannot fill memory
+
+typedef struct {
+    int inFd;
+    int outFd;
+    int ownsFds;                        // closes the socket when done, stdin and stdout are left open
+    pthread_t writer;
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;             // output was added, pending dropped or the reader finished
+    uint8_t *output;                    // responses not yet written
+    size_t outputCount;
+    size_t outputCapacity;
+    size_t pending;                     // queries queued or being solved
+    int readerDone;
+    int writeFailed;                    // the client went away, answers are dropped from then on
+} Connection;
+
+typedef struct {
+    Connection *connection;
+    ASServerQuery query;
+    uint32_t flags;
+} Job;
+
+typedef struct {
+    ASGraph graph;
+    ASContractionHierarchy hierarchy;   // NULL unless -c
+    ASSearchOptions options;
+    pthread_mutex_t mutex;
+    pthread_cond_t available;
+    Job *jobs;                          // ring buffer of queued queries, capacity is a power of 2
+    size_t head;
+    size_t count;
+    size_t capacity;
+    int shutdown;
+} Server;
+
+static const char *listeningPath = NULL;
+
+/********************************************/
+
+static int ReadFully(int fd, void *buffer, size_t size)
+{
+    uint8_t *bytes = buffer;
+
+    while (size > 0) {
+        const ssize_t n = read(fd, bytes, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return 0;
+        }
+        bytes += n;
+        size -= (size_t)n;
+    }
+
+    return 1;
+}
+
+static int WriteFully(int fd, const void *buffer, size_t size)
+{
+    const uint8_t *bytes = buffer;
+
+    while (size > 0) {
+        const ssize_t n = write(fd, bytes, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return 0;
+        }
+        bytes += n;
+        size -= (size_t)n;
+    }
+
+    return 1;
+}
+
+/********************************************/
+
+// returns 0 without queueing anything if the queue can't grow
+static int ServerPush(Server *server, Connection *connection, uint32_t flags, const ASServerQuery *queries, size_t count)
+{
+    pthread_mutex_lock(&server->mutex);
+
+    if (server->count + count > server->capacity) {
+        size_t capacity = server->capacity? server->capacity : 1024;
+        while (capacity < server->count + count) {
+            capacity *= 2;
+        }
+
+        // unwrap the ring into the new buffer
+        Job *jobs = malloc(capacity * sizeof(Job));
+        if (!jobs) {
+            pthread_mutex_unlock(&server->mutex);
+            return 0;
+        }
+        for (size_t i=0; i<server->count; i++) {
+            jobs[i] = server->jobs[(server->head + i) & (server->capacity - 1)];
+        }
+        free(server->jobs);
+        server->jobs = jobs;
+        server->head = 0;
+        server->capacity = capacity;
+    }
+
+    for (size_t i=0; i<count; i++) {
+        server->jobs[(server->head + server->count + i) & (server->capacity - 1)] = (Job){connection, queries[i], flags};
+    }
+    server->count += count;
+
+    pthread_cond_broadcast(&server->available);
+    pthread_mutex_unlock(&server->mutex);
+    return 1;
+}
+
+static int ServerPop(Server *server, Job *job)
+{
+    pthread_mutex_lock(&server->mutex);
+
+    while (server->count == 0 && !server->shutdown) {
+        pthread_cond_wait(&server->available, &server->mutex);
+    }
+
+    const int found = server->count > 0;
+    if (found) {
+        *job = server->jobs[server->head];
+        server->head = (server->head + 1) & (server->capacity - 1);
+        server->count--;
+    }
+
+    pthread_mutex_unlock(&server->mutex);
+    return found;
+}
+
+/********************************************/
+
+static void ConnectionRespond(Connection *connection, const ASServerResponse *response, const uint32_t *nodes)
+{
+    const size_t size = sizeof(ASServerResponse) + response->nodeCount * sizeof(uint32_t);
+
+    pthread_mutex_lock(&connection->mutex);
+
+    if (!connection->writeFailed) {
+        if (connection->outputCount + size > connection->outputCapacity) {
+            size_t capacity = connection->outputCapacity? connection->outputCapacity : 4096;
+            while (capacity < connection->outputCount + size) {
+                capacity *= 2;
+            }
+            uint8_t *output = realloc(connection->output, capacity);
+            if (output) {
+                connection->output = output;
+                connection->outputCapacity = capacity;
+            } else {
+                connection->writeFailed = 1;
+            }
+        }
+        if (!connection->writeFailed) {
+            memcpy(connection->output + connection->outputCount, response, sizeof(ASServerResponse));
+            if (response->nodeCount > 0) {
+                memcpy(connection->output + connection->outputCount + sizeof(ASServerResponse), nodes, response->nodeCount * sizeof(uint32_t));
+            }
+            connection->outputCount += size;
+        }
+    }
+
+    // the reader frees the connection once pending is 0 and the writer is gone, so it must not be touched after unlocking
+    connection->pending--;
+    pthread_cond_broadcast(&connection->changed);
+    pthread_mutex_unlock(&connection->mutex);
+}
+
+static void *ConnectionWrite(void *argument)
+{
+    Connection *connection = argument;
+    uint8_t *buffer = NULL;
+    size_t capacity = 0;
+
+    pthread_mutex_lock(&connection->mutex);
+
+    for (;;) {
+        while (connection->outputCount == 0 && !(connection->readerDone && connection->pending == 0)) {
+            pthread_cond_wait(&connection->changed, &connection->mutex);
+        }
+        if (connection->outputCount == 0) {
+            break;
+        }
+
+        // swap buffers, so the workers keep appending while this one is written
+        uint8_t *output = connection->output;
+        const size_t outputCapacity = connection->outputCapacity;
+        const size_t count = connection->outputCount;
+        connection->output = buffer;
+        connection->outputCapacity = capacity;
+        connection->outputCount = 0;
+        buffer = output;
+        capacity = outputCapacity;
+
+        pthread_mutex_unlock(&connection->mutex);
+        const int written = WriteFully(connection->outFd, buffer, count);
+        pthread_mutex_lock(&connection->mutex);
+
+        if (!written) {
+            connection->writeFailed = 1;
+            connection->outputCount = 0;
+        }
+    }
+
+    pthread_mutex_unlock(&connection->mutex);
+    free(buffer);
+    return NULL;
+}
+
+// reads batches until the client closes its end, then waits for the last answers to be written and frees the connection
+static void ConnectionServe(Server *server, Connection *connection)
+{
+    ASServerQuery queries[ServerReadChunk];
+    ASServerBatchHeader header;
+    // without a writer nothing could be answered, the connection is closed right away
+    const int writing = pthread_create(&connection->writer, NULL, ConnectionWrite, connection) == 0;
+    int open = writing;
+
+    if (!writing) {
+        fprintf(stderr, "astar_server: cannot start a writer thread, closing the connection\n");
+    }
+
+    while (open && ReadFully(connection->inFd, &header, sizeof(header))) {
+        if (header.magic != ASServerRequestMagic) {
+            fprintf(stderr, "astar_server: bad batch header, closing the connection\n");
+            break;
+        }
+
+        uint32_t remaining = header.count;
+        while (open && remaining > 0) {
+            const size_t count = remaining < ServerReadChunk? remaining : ServerReadChunk;
+            if (!ReadFully(connection->inFd, queries, count * sizeof(ASServerQuery))) {
+                break;
+            }
+            remaining -= count;
+
+            pthread_mutex_lock(&connection->mutex);
+            while (connection->pending >= ServerMaxPending && !connection->writeFailed) {
+                pthread_cond_wait(&connection->changed, &connection->mutex);
+            }
+            // nobody reads the answers any more
+            open = !connection->writeFailed;
+            connection->pending += open? count : 0;
+            pthread_mutex_unlock(&connection->mutex);
+
+            if (open && !ServerPush(server, connection, header.flags, queries, count)) {
+                // the queue is out of memory: these queries get their answer here, the rest of the connection is dropped
+                for (size_t i=0; i<count; i++) {
+                    const ASServerResponse response = {queries[i].tag, ASServerOutOfMemory, INFINITY, 0};
+                    ConnectionRespond(connection, &response, NULL);
+                }
+                fprintf(stderr, "astar_server: out of memory, closing the connection\n");
+                open = 0;
+            }
+        }
+        open = open && remaining == 0;
+    }
+
+    pthread_mutex_lock(&connection->mutex);
+    connection->readerDone = 1;
+    pthread_cond_broadcast(&connection->changed);
+    pthread_mutex_unlock(&connection->mutex);
+
+    if (writing) {
+        pthread_join(connection->writer, NULL);
+    }
+
+    if (connection->ownsFds) {
+        close(connection->inFd);
+    }
+    pthread_cond_destroy(&connection->changed);
+    pthread_mutex_destroy(&connection->mutex);
+    free(connection->output);
+    free(connection);
+}
+
+static Connection *ConnectionCreate(int inFd, int outFd, int ownsFds)
+{
+    Connection *connection = calloc(1, sizeof(Connection));
+    if (!connection) {
+        return NULL;
+    }
+    connection->inFd = inFd;
+    connection->outFd = outFd;
+    connection->ownsFds = ownsFds;
+    pthread_mutex_init(&connection->mutex, NULL);
+    pthread_cond_init(&connection->changed, NULL);
+    return connection;
+}
+
+typedef struct {
+    Server *server;
+    Connection *connection;
+} ConnectionStart;
+
+static void *ConnectionThread(void *argument)
+{
+    ConnectionStart start = *(ConnectionStart *)argument;
+    free(argument);
+    ConnectionServe(start.server, start.connection);
+    return NULL;
+}
+
+/********************************************/
+
+static int GrowBuffers(uint32_t **nodes, float **costs, size_t *capacity, size_t count)
+{
+    // both buffers are replaced or neither, the old ones stay usable if either allocation fails
+    uint32_t *grownNodes = malloc(count * sizeof(uint32_t));
+    float *grownCosts = malloc(count * sizeof(float));
+
+    if (!grownNodes || !grownCosts) {
+        free(grownNodes);
+        free(grownCosts);
+        return 0;
+    }
+
+    free(*nodes);
+    free(*costs);
+    *nodes = grownNodes;
+    *costs = grownCosts;
+    *capacity = count;
+    return 1;
+}
+
+static void *Worker(void *argument)
+{
+    Server *server = argument;
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    size_t capacity = 1024;
+    uint32_t *nodes = malloc(capacity * sizeof(uint32_t));
+    float *costs = malloc(capacity * sizeof(float));
+    // a worker that could not allocate its buffers answers every query as out of memory
+    const int ready = workspace && nodes && costs;
+    Job job;
+
+    if (ready) {
+        ASSearchWorkspaceSetOptions(workspace, &server->options);
+    }
+
+    while (ServerPop(server, &job)) {
+        const ASServerQuery *query = &job.query;
+        ASServerResponse response = {query->tag, ASServerInvalidNode, INFINITY, 0};
+        // clients use the ids from before the graph was reordered, if it was
+        const uint32_t startNode = ASGraphGetNodeIDFromOriginal(server->graph, query->startNode);
+        const uint32_t goalNode = ASGraphGetNodeIDFromOriginal(server->graph, query->goalNode);
+        size_t count = 0;
+        int outOfMemory = !ready;
+
+        if (ready && startNode != ASNodeIDNull && goalNode != ASNodeIDNull) {
+            if (server->hierarchy) {
+                ASPath path = ASPathCreateWithContractionHierarchy(workspace, server->hierarchy, startNode, goalNode);
+                count = ASPathGetCount(path);
+                if (count > capacity && !GrowBuffers(&nodes, &costs, &capacity, count)) {
+                    count = 0;
+                    outOfMemory = 1;
+                }
+                for (size_t i=0; i<count; i++) {
+                    nodes[i] = ASPathGetNodeID(path, i);
+                    costs[i] = ASPathGetCost(path, i);
+                }
+                ASPathDestroy(path);
+            } else {
+                count = ASPathWriteWithGraph(workspace, server->graph, startNode, goalNode, nodes, costs, capacity);
+                if (count > capacity) {
+                    // too long for the buffers, search again with room for it -- they keep their size for the next queries
+                    if (GrowBuffers(&nodes, &costs, &capacity, count)) {
+                        count = ASPathWriteWithGraph(workspace, server->graph, startNode, goalNode, nodes, costs, capacity);
+                    } else {
+                        count = 0;
+                        outOfMemory = 1;
+                    }
+                }
+            }
+
+            if (outOfMemory) {
+                response.status = ASServerOutOfMemory;
+            } else if (count > 0) {
+                response.status = ASServerFound;
+                response.cost = costs[count - 1];
+                response.nodeCount = (job.flags & ASServerFlagNodes)? (uint32_t)count : 0;
+                for (uint32_t i=0; i<response.nodeCount; i++) {
+                    nodes[i] = ASGraphGetOriginalNodeID(server->graph, nodes[i]);
+                }
+            } else if (ASSearchWorkspaceGetStatus(workspace) == ASSearchOutOfMemory) {
+                response.status = ASServerOutOfMemory;
+            } else {
+                response.status = ASServerNoPath;
+            }
+        } else if (outOfMemory) {
+            response.status = ASServerOutOfMemory;
+        }
+
+        ConnectionRespond(job.connection, &response, nodes);
+    }
+
+    free(costs);
+    free(nodes);
+    ASSearchWorkspaceDestroy(workspace);
+    return NULL;
+}
+
+/********************************************/
+
+static void RemoveSocket(int signalNumber)
+{
+    // unlink() and _exit() are safe in a signal handler
+    unlink(listeningPath);
+    _exit(0);
+}
+
+static int Listen(Server *server, const char *path)
+{
+    struct sockaddr_un address = {0};
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0 || strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "astar_server: cannot listen on %s\n", path);
+        return 1;
+    }
+
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    unlink(path);           // left behind by a server that was killed
+
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, 64) != 0) {
+        fprintf(stderr, "astar_server: cannot listen on %s: %s\n", path, strerror(errno));
+        close(fd);
+        return 1;
+    }
+
+    listeningPath = path;
+    signal(SIGINT, RemoveSocket);
+    signal(SIGTERM, RemoveSocket);
+
+    for (;;) {
+        const int client = accept(fd, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            fprintf(stderr, "astar_server: accept failed: %s\n", strerror(errno));
+            break;
+        }
+
+        // a connection that can't be set up is closed, the server keeps serving the others
+        ConnectionStart *start = malloc(sizeof(ConnectionStart));
+        Connection *connection = start? ConnectionCreate(client, client, 1) : NULL;
+        pthread_t thread;
+
+        if (connection) {
+            start->server = server;
+            start->connection = connection;
+        }
+        if (!connection || pthread_create(&thread, NULL, ConnectionThread, start) != 0) {
+            fprintf(stderr, "astar_server: cannot serve a new connection, closing it\n");
+            if (connection) {
+                pthread_cond_destroy(&connection->changed);
+                pthread_mutex_destroy(&connection->mutex);
+                free(connection);
+            }
+            free(start);
+            close(client);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+
+    close(fd);
+    unlink(path);
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    Server server = {0};
+    const char *socketPath = NULL;
+    long threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+    int useHierarchy = 0;
+    int option;
+
+    while ((option = getopt(argc, argv, "s:t:cbm:")) != -1) {
+        switch (option) {
+            case 's': socketPath = optarg; break;
+            case 't': threadCount = atol(optarg); break;
+            case 'c': useHierarchy = 1; break;
+            case 'b': server.options.bidirectional = 1; break;
+            case 'm': server.options.memoryLimit = strtoull(optarg, NULL, 10); break;
+            default: optind = argc + 1; break;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: astar_server [-s socketPath] [-t threads] [-c] [-b] [-m bytes] graphFile\n");
+        return 2;
+    }
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+
+    server.graph = ASGraphOpenFile(argv[optind]);
+    if (!server.graph) {
+        fprintf(stderr, "astar_server: cannot open graph %s\n", argv[optind]);
+        return 1;
+    }
+    if (server.options.bidirectional && !useHierarchy) {
+        // does nothing if the file has them
+        ASGraphBuildReverseEdges(server.graph);
+    }
+    if (useHierarchy) {
+        server.hierarchy = ASContractionHierarchyCreate(server.graph);
+    }
+
+    // a client that disconnects early makes write() fail instead of killing the server
+    signal(SIGPIPE, SIG_IGN);
+    pthread_mutex_init(&server.mutex, NULL);
+    pthread_cond_init(&server.available, NULL);
+
+    // runs with the workers that could be started
+    pthread_t *workers = malloc(threadCount * sizeof(pthread_t));
+    long startedCount = 0;
+    while (workers && startedCount < threadCount && pthread_create(&workers[startedCount], NULL, Worker, &server) == 0) {
+        startedCount++;
+    }
+    threadCount = startedCount;
+    if (threadCount == 0) {
+        fprintf(stderr, "astar_server: cannot start any worker threads\n");
+        return 1;
+    }
+
+    fprintf(stderr, "astar_server: %u nodes, %zu edges, %u landmarks, %zu shortcuts, %ld workers\n", ASGraphGetNodeCount(server.graph), ASGraphGetEdgeCount(server.graph), ASGraphGetLandmarkCount(server.graph), server.hierarchy? ASContractionHierarchyGetShortcutCount(server.hierarchy) : 0, threadCount);
+
+    int result = 0;
+    if (socketPath) {
+        result = Listen(&server, socketPath);
+    } else {
+        Connection *connection = ConnectionCreate(STDIN_FILENO, STDOUT_FILENO, 0);
+        if (connection) {
+            ConnectionServe(&server, connection);
+        } else {
+            fprintf(stderr, "astar_server: out of memory\n");
+            result = 1;
+        }
+    }
+
+    pthread_mutex_lock(&server.mutex);
+    server.shutdown = 1;
+    pthread_cond_broadcast(&server.available);
+    pthread_mutex_unlock(&server.mutex);
+
+    for (long i=0; i<threadCount; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    free(workers);
+    free(server.jobs);
+    pthread_cond_destroy(&server.available);
+    pthread_mutex_destroy(&server.mutex);
+    if (server.hierarchy) {
+        ASContractionHierarchyDestroy(server.hierarchy);
+    }
+    ASGraphDestroy(server.graph);
+    return result;
+}
@@ -0,0 +1,72 @@
+/*
+ Copyright (c) 2012, Sean Heber. All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 
+ 1. Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ 
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+ 
+ 3. Neither the name of Sean Heber nor the names of its contributors may
+ be used to endorse or promote products derived from this software without
+ specific prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL SEAN HEBER BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// wire format of astar_server, see AStarServer.c -- all fields are 32 bits wide in the byte order of the host, so client and server must run on the same machine
+
+#ifndef AStarServer_h
+#define AStarServer_h
+
+#include <stdint.h>
+
+#define ASServerRequestMagic 0x31515341u   // "ASQ1"
+
+// flags of a request batch
+enum {
+    ASServerFlagNodes = 1 << 0,         // the responses list the nodes of every path, otherwise they only carry the cost
+};
+
+// starts a request batch, followed by count ASServerQuery records
+typedef struct {
+    uint32_t magic;
+    uint32_t flags;
+    uint32_t count;
+} ASServerBatchHeader;
+
+typedef struct {
+    uint32_t tag;                       // chosen by the client and copied into the response, which may arrive in any order
+    uint32_t startNode;
+    uint32_t goalNode;
+} ASServerQuery;
+
+typedef enum {
+    ASServerFound = 0,
+    ASServerNoPath,
+    ASServerOutOfMemory,                // the worker's memory limit stopped the search, see ASSearchOptions.memoryLimit
+    ASServerInvalidNode,                // start or goal is not a node of the graph
+} ASServerStatus;
+
+// sent for every query as soon as it is solved, followed by nodeCount uint32_t node ids from start to goal
+typedef struct {
+    uint32_t tag;
+    uint32_t status;                    // ASServerStatus
+    float cost;                         // INFINITY unless found
+    uint32_t nodeCount;                 // 0 unless found and the batch had ASServerFlagNodes set
+} ASServerResponse;
+
+#endif
@@ -0,0 +1,79 @@
+// Anytime search benchmark: queries across a 1024x1024 8-connected grid with random obstacles, once with an optimal
+// ASPathCreateWithNodeIDs() search and once with an ARA* search under a 5 ms budget. Reports how many queries had a path
+// within the budget, the suboptimality bound the search could prove, the cost against the optimum and the time of both.
+
+#include "bench_common.h"
+#include <stdio.h>
+
+#define WIDTH   1024
+#define QUERIES 100
+#define BUDGET  0.005
+
+int main(int argc, char** argv) {
+    const uint32_t nodeCount = WIDTH * WIDTH;
+    uint8_t *blocked = malloc(nodeCount);
+    benchGrid grid = {WIDTH, blocked, NULL, 1, 1};
+    const ASPathNodeIDSource source = {nodeCount, &cellNeighbors, &cellHeuristic, NULL, NULL};
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    ASAnytimeSearch anytime = ASAnytimeSearchCreate(&source, &grid, 3);
+    size_t queries = 0, withinBudget = 0, provenOptimal = 0;
+    double optimalTime = 0, anytimeTime = 0, firstTime = 0, boundSum = 0, ratioSum = 0, worstRatio = 1;
+    srand(1);
+
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        blocked[i] = (rand() % 100) < 30;
+    }
+
+    while (queries < QUERIES) {
+        // starts and goals on opposite sides of the map, so the optimal search has a long way to go
+        const uint32_t start = (rand() % WIDTH) * WIDTH + rand() % (WIDTH / 8);
+        const uint32_t goal = (rand() % WIDTH) * WIDTH + WIDTH - 1 - rand() % (WIDTH / 8);
+        if (blocked[start] || blocked[goal]) {
+            continue;
+        }
+
+        double begin = now();
+        ASPath optimal = ASPathCreateWithNodeIDs(workspace, &source, &grid, start, goal);
+        optimalTime += now() - begin;
+        if (!optimal) {
+            continue;
+        }
+        const float optimalCost = ASPathGetCost(optimal, ASPathGetCount(optimal) - 1);
+        ASPathDestroy(optimal);
+        queries++;
+
+        // slices of 0.1 ms until the first path shows up, then the rest of the budget in one call
+        begin = now();
+        ASAnytimeSearchStart(anytime, start, goal);
+        ASPath path = NULL;
+        while (!path && now() - begin < BUDGET) {
+            path = ASAnytimeSearchImprove(anytime, 0.0001, 0);
+        }
+        firstTime += now() - begin;
+        if (path && now() - begin < BUDGET) {
+            ASPathDestroy(path);
+            path = ASAnytimeSearchImprove(anytime, BUDGET - (now() - begin), 0);
+        }
+        anytimeTime += now() - begin;
+
+        if (path) {
+            const double ratio = ASPathGetCost(path, ASPathGetCount(path) - 1) / optimalCost;
+            withinBudget++;
+            boundSum += ASAnytimeSearchGetBound(anytime);
+            ratioSum += ratio;
+            worstRatio = (ratio > worstRatio)? ratio : worstRatio;
+            provenOptimal += (ASAnytimeSearchGetBound(anytime) <= 1);
+        }
+        ASPathDestroy(path);
+    }
+
+    printf("%dx%d grid, %zu queries, %.0f ms budget\n", WIDTH, WIDTH, queries, BUDGET * 1e3);
+    printf("  optimal A*  %9.1fus per query\n", 1e6 * optimalTime / queries);
+    printf("  anytime     %9.1fus per query, first path after %.1fus\n", 1e6 * anytimeTime / queries, 1e6 * firstTime / queries);
+    printf("  %zu with a path in budget, %zu proven optimal, average bound %.3f, cost / optimal %.4f average %.4f worst\n", withinBudget, provenOptimal, boundSum / withinBudget, ratioSum / withinBudget, worstRatio);
+
+    ASAnytimeSearchDestroy(anytime);
+    ASSearchWorkspaceDestroy(workspace);
+    free(blocked);
+    return 0;
+}
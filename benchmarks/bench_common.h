@@ -0,0 +1,120 @@
+// Fixtures shared by the benchmarks: a clock, and square grids of cells searched either by node id (y * width + x) or as
+// (x, y) struct nodes behind a hash index. Every function is static inline so a benchmark only compiles in what it uses.
+
+#ifndef bench_common_h
+#define bench_common_h
+
+#include "AStar.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+typedef struct {
+    uint32_t width;                     // the grid is width x width cells
+    const uint8_t *blocked;             // nonzero for a blocked cell -- NULL if every cell is open
+    const float *cellCosts;             // cost of stepping onto each cell -- NULL for steps of 1, and sqrt(2) diagonally
+    int diagonals;                      // 8-connected if set, 4-connected otherwise
+    int cornerCutting;                  // a diagonal step may pass the corner of a blocked cell
+    size_t expansions;                  // counted by the neighbor callbacks
+} benchGrid;
+
+typedef struct {
+    int32_t x;
+    int32_t y;
+} benchCell;
+
+static inline double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline int isOpen(const benchGrid *grid, int x, int y) {
+    return x >= 0 && x < (int)grid->width && y >= 0 && y < (int)grid->width && !(grid->blocked && grid->blocked[(size_t)y * grid->width + x]);
+}
+
+static inline int canStep(const benchGrid *grid, int x, int y, int dx, int dy) {
+    if ((!dx && !dy) || (dx && dy && !grid->diagonals) || !isOpen(grid, x + dx, y + dy)) {
+        return 0;
+    }
+    return !(dx && dy) || grid->cornerCutting || (isOpen(grid, x + dx, y) && isOpen(grid, x, y + dy));
+}
+
+static inline float stepCost(const benchGrid *grid, int x, int y, int dx, int dy) {
+    if (grid->cellCosts) {
+        return grid->cellCosts[(size_t)(y + dy) * grid->width + x + dx];
+    }
+    return (dx && dy)? 1.41421356f : 1.f;
+}
+
+static inline float gridDistance(const benchGrid *grid, int fromX, int fromY, int toX, int toY) {
+    // Manhattan distance on 4-connected grids, octile distance on 8-connected ones -- the cheapest steps cost 1, so it never overestimates
+    const float dx = fabsf((float)(fromX - toX));
+    const float dy = fabsf((float)(fromY - toY));
+    if (!grid->diagonals) {
+        return dx + dy;
+    }
+    return fmaxf(dx, dy) + 0.41421356f * fminf(dx, dy);
+}
+
+// node id callbacks, the context is the benchGrid
+
+static inline void cellNeighbors(ASNeighborList neighbors, uint32_t node, float node_cost, uint32_t from_node, void *context) {
+    benchGrid *grid = (benchGrid *)context;
+    const int x = node % grid->width;
+    const int y = node / grid->width;
+    grid->expansions++;
+
+    // a blocked cell is only expanded if a search starts on it, or if it was blocked after it was reached
+    if (!isOpen(grid, x, y)) {
+        return;
+    }
+
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            if (canStep(grid, x, y, dx, dy)) {
+                ASNeighborListAddID(neighbors, (y + dy) * grid->width + x + dx, stepCost(grid, x, y, dx, dy));
+            }
+        }
+    }
+}
+
+static inline float cellHeuristic(uint32_t from_node, uint32_t to_node, void *context) {
+    const benchGrid *grid = (const benchGrid *)context;
+    return gridDistance(grid, from_node % grid->width, from_node / grid->width, to_node % grid->width, to_node / grid->width);
+}
+
+// benchCell callbacks, same grid
+
+static inline void cellNodeNeighbors(ASNeighborList neighbors, void *node, float node_cost, void *from_node, void *context) {
+    benchGrid *grid = (benchGrid *)context;
+    const benchCell *cell = (const benchCell *)node;
+    grid->expansions++;
+
+    if (!isOpen(grid, cell->x, cell->y)) {
+        return;
+    }
+
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            if (canStep(grid, cell->x, cell->y, dx, dy)) {
+                benchCell neighbor = {cell->x + dx, cell->y + dy};
+                ASNeighborListAdd(neighbors, &neighbor, stepCost(grid, cell->x, cell->y, dx, dy));
+            }
+        }
+    }
+}
+
+static inline float cellNodeHeuristic(void *fromNode, void *toNode, void *context) {
+    const benchCell *from = (const benchCell *)fromNode;
+    const benchCell *to = (const benchCell *)toNode;
+    return gridDistance((const benchGrid *)context, from->x, from->y, to->x, to->y);
+}
+
+static inline size_t cellHash(void *node, void *context) {
+    const benchCell *cell = (const benchCell *)node;
+    return (size_t)cell->y * ((const benchGrid *)context)->width + (size_t)cell->x;
+}
+
+#endif
@@ -0,0 +1,70 @@
+// Bidirectional benchmark: runs the same random queries on a corridor map (rooms joined by long walls with few gaps)
+// once forward only and once with ASSearchOptions.bidirectional, and reports expansions, mean and p99 latency.
+
+#include "bench_common.h"
+#include <stdio.h>
+
+#define WIDTH   512
+#define QUERIES 500
+
+static int compareTimes(const void *a, const void *b) {
+    const double t1 = *(const double*)a, t2 = *(const double*)b;
+    return (t1 > t2) - (t1 < t2);
+}
+
+static void run(const char *name, ASSearchWorkspace workspace, const ASPathNodeIDSource *source, benchGrid *g, const uint32_t *starts, const uint32_t *goals, int bidirectional) {
+    const ASSearchOptions options = {ASOpenSetBinaryHeap, 0, bidirectional};
+    double times[QUERIES], total = 0, checksum = 0;
+    ASSearchWorkspaceSetOptions(workspace, &options);
+    g->expansions = 0;
+
+    for (size_t q = 0; q < QUERIES; q++) {
+        const double begin = now();
+        ASPath path = ASPathCreateWithNodeIDs(workspace, source, g, starts[q], goals[q]);
+        times[q] = now() - begin;
+        total += times[q];
+        if (path) {
+            checksum += ASPathGetCost(path, ASPathGetCount(path) - 1);
+        }
+        ASPathDestroy(path);
+    }
+
+    qsort(times, QUERIES, sizeof(double), &compareTimes);
+    printf("  %-14s expansions=%-10zu mean=%8.1fus p99=%8.1fus checksum=%.1f\n", name, g->expansions, 1e6 * total / QUERIES, 1e6 * times[QUERIES * 99 / 100], checksum);
+}
+
+int main(int argc, char** argv) {
+    const uint32_t nodeCount = WIDTH * WIDTH;
+    uint8_t *blocked = calloc(nodeCount, 1);
+    benchGrid g = {WIDTH, blocked, NULL, 0, 0};
+    const ASPathNodeIDSource source = {nodeCount, &cellNeighbors, &cellHeuristic, NULL, NULL};
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    uint32_t starts[QUERIES], goals[QUERIES];
+    srand(1);
+
+    // walls every 16 rows and columns, two thirds of the wall segments between crossings get a one cell gap
+    for (uint32_t y = 0; y < WIDTH; y++) {
+        for (uint32_t x = 0; x < WIDTH; x++) {
+            blocked[y * WIDTH + x] = (x % 16 == 15) || (y % 16 == 15);
+        }
+    }
+    for (uint32_t y = 0; y < WIDTH; y += 16) {
+        for (uint32_t x = 0; x < WIDTH; x += 16) {
+            if (x + 15 < WIDTH) blocked[(y + rand() % 15) * WIDTH + x + 15] = (rand() % 3 == 0);
+            if (y + 15 < WIDTH) blocked[(y + 15) * WIDTH + x + rand() % 15] = (rand() % 3 == 0);
+        }
+    }
+
+    for (size_t q = 0; q < QUERIES; q++) {
+        do { starts[q] = rand() % nodeCount; } while (blocked[starts[q]]);
+        do { goals[q] = rand() % nodeCount; } while (blocked[goals[q]]);
+    }
+
+    printf("%dx%d corridor map, %d queries\n", WIDTH, WIDTH, QUERIES);
+    run("forward", workspace, &source, &g, starts, goals, 0);
+    run("bidirectional", workspace, &source, &g, starts, goals, 1);
+
+    ASSearchWorkspaceDestroy(workspace);
+    free(blocked);
+    return 0;
+}
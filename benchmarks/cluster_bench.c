@@ -0,0 +1,97 @@
+// Cluster hierarchy benchmark: splits a 1024x1024 8-connected site map (halls of 128x128 cells behind walls with a few doors,
+// scattered obstacles inside) into 32x32 clusters and runs the same
+// random queries through ASPathCreateWithNodeIDs() (flat A*) and through the hierarchy, once for the path through the entrances
+// only and once refined into grid cells. Reports build time, entrances, memory, query latency, the cost against the optimum and
+// the time to update one cluster after some of its cells are blocked.
+
+#include "bench_common.h"
+#include <stdio.h>
+
+#define WIDTH   1024
+#define CLUSTER 32
+#define QUERIES 100
+#define HALL    128
+#define DOOR    6
+
+int main(int argc, char** argv) {
+    const uint32_t nodeCount = WIDTH * WIDTH;
+    uint8_t *blocked = malloc(nodeCount);
+    benchGrid grid = {WIDTH, blocked, NULL, 1, 1};
+    const ASPathNodeIDSource source = {nodeCount, &cellNeighbors, &cellHeuristic, NULL, NULL};
+    uint32_t *clusters = malloc(nodeCount * sizeof(uint32_t));
+    uint32_t starts[QUERIES], goals[QUERIES];
+    float optimalCosts[QUERIES];
+    size_t found = 0, mismatches = 0;
+    double times[3] = {0}, ratioSum = 0, worstRatio = 1;
+    srand(1);
+
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        const uint32_t x = i % WIDTH, y = i / WIDTH;
+        const int wall = (x % HALL == 0 && (y % HALL) / DOOR != 5 && (y % HALL) / DOOR != 15) || (y % HALL == 0 && (x % HALL) / DOOR != 10);
+        blocked[i] = wall || (rand() % 100) < 10;
+        clusters[i] = (i / WIDTH / CLUSTER) * (WIDTH / CLUSTER) + (i % WIDTH) / CLUSTER;
+    }
+    for (int q = 0; q < QUERIES; q++) {
+        do { starts[q] = rand() % nodeCount; } while (blocked[starts[q]]);
+        do { goals[q] = rand() % nodeCount; } while (blocked[goals[q]]);
+    }
+
+    double begin = now();
+    ASClusterHierarchy hierarchy = ASClusterHierarchyCreate(&source, &grid, clusters);
+    const double buildTime = now() - begin;
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+
+    begin = now();
+    for (int q = 0; q < QUERIES; q++) {
+        ASPath path = ASPathCreateWithNodeIDs(workspace, &source, &grid, starts[q], goals[q]);
+        optimalCosts[q] = path? ASPathGetCost(path, ASPathGetCount(path) - 1) : INFINITY;
+        ASPathDestroy(path);
+    }
+    times[0] = now() - begin;
+
+    begin = now();
+    for (int q = 0; q < QUERIES; q++) {
+        ASPath path = ASClusterHierarchyCreateAbstractPath(workspace, hierarchy, starts[q], goals[q]);
+        ASPathDestroy(path);
+    }
+    times[1] = now() - begin;
+
+    begin = now();
+    for (int q = 0; q < QUERIES; q++) {
+        ASPath path = ASPathCreateWithClusterHierarchy(workspace, hierarchy, starts[q], goals[q]);
+        if (!path != (optimalCosts[q] == INFINITY)) {
+            mismatches++;
+        } else if (path) {
+            const double ratio = ASPathGetCost(path, ASPathGetCount(path) - 1) / optimalCosts[q];
+            found++;
+            ratioSum += ratio;
+            worstRatio = (ratio > worstRatio)? ratio : worstRatio;
+        }
+        ASPathDestroy(path);
+    }
+    times[2] = now() - begin;
+
+    // block a wall through the middle of one cluster and bring the hierarchy up to date
+    const uint32_t cluster = (WIDTH / CLUSTER / 2) * (WIDTH / CLUSTER) + WIDTH / CLUSTER / 2;
+    const uint32_t left = (cluster % (WIDTH / CLUSTER)) * CLUSTER;
+    const uint32_t top = (cluster / (WIDTH / CLUSTER)) * CLUSTER;
+    for (uint32_t y = top + 2; y < top + CLUSTER - 2; y++) {
+        blocked[y * WIDTH + left + CLUSTER / 2] = 1;
+    }
+    begin = now();
+    ASClusterHierarchyUpdateCluster(hierarchy, cluster);
+    const double updateTime = now() - begin;
+
+    printf("%dx%d grid, %dx%d clusters, %d queries\n", WIDTH, WIDTH, CLUSTER, CLUSTER, QUERIES);
+    printf("  build %.1fms, %u entrances, %.1f MB, cluster update %.1fus\n", 1e3 * buildTime, ASClusterHierarchyGetEntranceCount(hierarchy), ASClusterHierarchyGetMemorySize(hierarchy) / 1048576.0, 1e6 * updateTime);
+    printf("  flat A*         %9.1fus per query\n", 1e6 * times[0] / QUERIES);
+    printf("  entrances only  %9.1fus per query\n", 1e6 * times[1] / QUERIES);
+    printf("  refined         %9.1fus per query\n", 1e6 * times[2] / QUERIES);
+    printf("  %zu paths, %zu reachability mismatches, cost / optimal %.4f average %.4f worst\n", found, mismatches, ratioSum / (found? found : 1), worstRatio);
+
+    ASClusterHierarchyDestroy(hierarchy);
+    ASSearchWorkspaceDestroy(workspace);
+    free(clusters);
+    free(blocked);
+    return 0;
+}
@@ -0,0 +1,101 @@
+// Cooperative planning benchmark: robots on a 96x96 warehouse floor with shelf rows are planned one after another
+// with ASPathCreateCooperative() against one shared reservation table, then every pair of paths is checked for robots
+// on the same cell at the same time or swapping cells. Reports the planning time per robot, the reservations made and
+// the delay the robots take on against their paths without other robots.
+
+#include "bench_common.h"
+#include <stdio.h>
+
+#define WIDTH   96
+#define ROBOTS  160
+#define HORIZON 600
+
+static void fillTimeline(ASPath path, uint32_t *timeline) {
+    // the node the robot is on at every time step, robots stay on their goal
+    size_t i = 0;
+    for (int t = 0; t <= HORIZON; t++) {
+        while (i + 1 < ASPathGetCount(path) && ASPathGetCost(path, i + 1) <= t + 0.5f) {
+            i++;
+        }
+        timeline[t] = ASPathGetNodeID(path, i);
+    }
+}
+
+int main(int argc, char** argv) {
+    const uint32_t nodeCount = WIDTH * WIDTH;
+    uint8_t *blocked = calloc(nodeCount, 1);
+    benchGrid map = {WIDTH, blocked, NULL, 0, 0};
+    uint8_t *taken = calloc(nodeCount, 1);
+    const ASPathNodeIDSource source = {nodeCount, &cellNeighbors, &cellHeuristic, NULL, NULL};
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    ASReservationTable table = ASReservationTableCreate(nodeCount, 1, HORIZON);
+    ASPath paths[ROBOTS];
+    uint32_t *timelines = malloc(ROBOTS * (HORIZON + 1) * sizeof(uint32_t));
+    size_t planned = 0, failed = 0, conflicts = 0, visited = 0;
+    double soloCost = 0, cooperativeCost = 0;
+    srand(1);
+
+    // shelf rows two cells deep with an aisle every 12 cells
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        const int x = i % WIDTH, y = i / WIDTH;
+        blocked[i] = (y % 5 >= 3) && (x % 12 > 1) && x > 2 && x < WIDTH - 3;
+    }
+
+    const double begin = now();
+
+    for (int r = 0; r < ROBOTS; r++) {
+        // robots start on the left and right edges and drive to the opposite side, no two share a start or a goal
+        uint32_t start, goal;
+        do { start = (rand() % WIDTH) * WIDTH + (r % 2? WIDTH - 1 - rand() % 3 : rand() % 3); } while (blocked[start] || (taken[start] & 1));
+        do { goal = (rand() % WIDTH) * WIDTH + (r % 2? rand() % 3 : WIDTH - 1 - rand() % 3); } while (blocked[goal] || (taken[goal] & 2));
+        taken[start] |= 1;
+        taken[goal] |= 2;
+
+        ASPath path = ASPathCreateCooperative(workspace, table, &source, &map, start, goal, 0);
+        visited += ASSearchWorkspaceGetVisitedCount(workspace);
+
+        if (path) {
+            paths[planned++] = path;
+        } else {
+            failed++;
+        }
+    }
+
+    const double planTime = now() - begin;
+
+    for (size_t a = 0; a < planned; a++) {
+        fillTimeline(paths[a], timelines + a * (HORIZON + 1));
+    }
+
+    for (size_t a = 0; a < planned; a++) {
+        const uint32_t *timelineA = timelines + a * (HORIZON + 1);
+        ASPath solo = ASPathCreateWithNodeIDs(workspace, &source, &map, ASPathGetNodeID(paths[a], 0), ASPathGetNodeID(paths[a], ASPathGetCount(paths[a]) - 1));
+        soloCost += ASPathGetCost(solo, ASPathGetCount(solo) - 1);
+        cooperativeCost += ASPathGetCost(paths[a], ASPathGetCount(paths[a]) - 1);
+        ASPathDestroy(solo);
+
+        for (size_t b = a + 1; b < planned; b++) {
+            const uint32_t *timelineB = timelines + b * (HORIZON + 1);
+            for (int t = 0; t < HORIZON; t++) {
+                if (timelineA[t] == timelineB[t] || (timelineA[t] == timelineB[t + 1] && timelineA[t + 1] == timelineB[t])) {
+                    conflicts++;
+                    break;
+                }
+            }
+        }
+    }
+
+    printf("%dx%d floor, %d robots, %zu planned, %zu without a path, %zu conflicts\n", WIDTH, WIDTH, ROBOTS, planned, failed, conflicts);
+    printf("  planning %9.1fus per robot, %.1f nodes visited per robot, %zu reservations\n", 1e6 * planTime / ROBOTS, (double)visited / ROBOTS, ASReservationTableGetCount(table));
+    printf("  average path time %.1f against %.1f without other robots\n", cooperativeCost / planned, soloCost / planned);
+
+    for (size_t a = 0; a < planned; a++) {
+        ASPathDestroy(paths[a]);
+    }
+    ASReservationTableDestroy(table);
+    ASSearchWorkspaceDestroy(workspace);
+    free(timelines);
+    free(taken);
+    free(blocked);
+    return 0;
+}
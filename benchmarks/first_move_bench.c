@@ -0,0 +1,120 @@
+// First-move table benchmark: builds the table for the 32x32 4-connected map of main.c and for a 64x64 8-connected grid with
+// random obstacles, then compares paths from the table against ASPathCreateWithGraph() (A* with the Euclidean heuristic).
+// Reports build time, runs and size against an uncompressed table of one byte per pair, query latency of both and cost mismatches.
+
+#include "bench_common.h"
+#include <stdio.h>
+
+#define MAIN_WIDTH  32
+#define GRID_WIDTH  64
+#define SEARCHES    20000
+#define LOOKUPS     1000000
+
+static ASGraph createGrid(uint32_t width, int diagonals, int obstaclePercent, float stepCost) {
+    const uint32_t nodeCount = width * width;
+    uint8_t *blocked = malloc(nodeCount);
+    ASGraphEdge *edges = malloc(nodeCount * 8 * sizeof(ASGraphEdge));
+    float *positions = malloc(nodeCount * 2 * sizeof(float));
+    size_t edgeCount = 0;
+
+    for (uint32_t n = 0; n < nodeCount; n++) {
+        blocked[n] = (rand() % 100) < obstaclePercent;
+        positions[2 * n] = (float)(n % width);
+        positions[2 * n + 1] = (float)(n / width);
+    }
+
+    for (uint32_t n = 0; n < nodeCount; n++) {
+        const int x = n % width, y = n / width;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                const int nx = x + dx, ny = y + dy;
+                if ((dx || dy) && (diagonals || !dx || !dy) && nx >= 0 && ny >= 0 && nx < (int)width && ny < (int)width && !blocked[n] && !blocked[ny * width + nx]) {
+                    edges[edgeCount++] = (ASGraphEdge){n, ny * width + nx, (dx && dy)? 1.41421356f * stepCost : stepCost};
+                }
+            }
+        }
+    }
+
+    ASGraph graph = ASGraphCreateWithEdges(nodeCount, edges, edgeCount);
+    ASGraphSetPositions(graph, positions, ASGraphHeuristicEuclidean, stepCost);
+    free(positions);
+    free(edges);
+    free(blocked);
+    return graph;
+}
+
+static void run(const char *name, ASGraph graph, ASSearchPool pool) {
+    const uint32_t nodeCount = ASGraphGetNodeCount(graph);
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    size_t mismatches = 0, steps = 0;
+
+    double begin = now();
+    ASFirstMoveTable table = ASFirstMoveTableCreate(graph, pool);
+    const double buildTime = now() - begin;
+
+    uint32_t *starts = malloc(SEARCHES * sizeof(uint32_t));
+    uint32_t *goals = malloc(SEARCHES * sizeof(uint32_t));
+    float *costs = malloc(SEARCHES * sizeof(float));
+    for (int q = 0; q < SEARCHES; q++) {
+        starts[q] = rand() % nodeCount;
+        goals[q] = rand() % nodeCount;
+    }
+
+    begin = now();
+    for (int q = 0; q < SEARCHES; q++) {
+        ASPath path = ASPathCreateWithGraph(workspace, graph, starts[q], goals[q]);
+        costs[q] = path? ASPathGetCost(path, ASPathGetCount(path) - 1) : INFINITY;
+        ASPathDestroy(path);
+    }
+    const double searchTime = now() - begin;
+
+    begin = now();
+    for (int q = 0; q < SEARCHES; q++) {
+        ASPath path = ASPathCreateWithFirstMoveTable(table, starts[q], goals[q]);
+        const float cost = path? ASPathGetCost(path, ASPathGetCount(path) - 1) : INFINITY;
+        mismatches += (cost != costs[q] && !(fabsf(cost - costs[q]) <= 1e-4f * costs[q]));
+        ASPathDestroy(path);
+    }
+    const double tableTime = now() - begin;
+
+    // the bare lookups, following next nodes without building paths
+    begin = now();
+    for (int q = 0; q < LOOKUPS; q++) {
+        const uint32_t goal = (uint32_t)(((uint64_t)q * 2654435761u) % nodeCount);
+        uint32_t node = (uint32_t)q % nodeCount;
+        while (node != goal && node != ASNodeIDNull) {
+            node = ASFirstMoveTableGetNextNode(table, node, goal);
+            steps++;
+        }
+    }
+    const double lookupTime = now() - begin;
+
+    printf("%s: %u nodes, %zu edges\n", name, nodeCount, ASGraphGetEdgeCount(graph));
+    printf("  build %.1fms on %zu threads, %zu runs (%.1f per node), %.1f KB against %.1f KB uncompressed\n", 1e3 * buildTime, ASSearchPoolGetThreadCount(pool), ASFirstMoveTableGetRunCount(table), (double)ASFirstMoveTableGetRunCount(table) / nodeCount, ASFirstMoveTableGetMemorySize(table) / 1024.0, (double)nodeCount * nodeCount / 1024.0);
+    printf("  A*          %9.2fus per path\n", 1e6 * searchTime / SEARCHES);
+    printf("  table       %9.2fus per path, %zu cost mismatches\n", 1e6 * tableTime / SEARCHES, mismatches);
+    printf("  lookups     %9.1fns per step\n", 1e9 * lookupTime / steps);
+
+    free(costs);
+    free(goals);
+    free(starts);
+    ASFirstMoveTableDestroy(table);
+    ASSearchWorkspaceDestroy(workspace);
+}
+
+int main(int argc, char** argv) {
+    ASSearchPool pool = ASSearchPoolCreate(0);
+    srand(1);
+
+    // main.c: x and y from 0 to 31, neighbors one step apart, edge cost distance / 2
+    ASGraph mainGraph = createGrid(MAIN_WIDTH, 0, 0, 0.5f);
+    run("main.c map", mainGraph, pool);
+    ASGraphDestroy(mainGraph);
+
+    ASGraph grid = createGrid(GRID_WIDTH, 1, 20, 1.f);
+    run("grid", grid, pool);
+    ASGraphDestroy(grid);
+
+    ASSearchPoolDestroy(pool);
+    return 0;
+}
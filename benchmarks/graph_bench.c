@@ -0,0 +1,97 @@
+// Compiled graph benchmark: runs the same random queries on an 8-connected grid once through the nodeNeighbors
+// callback and once through an ASGraph built from that callback, then writes the graph to a file, maps it back
+// with ASGraphOpenFile() and runs the queries again. Reports build and open time, search time and checksums.
+
+#include "bench_common.h"
+#include <stdio.h>
+
+#define WIDTH   256
+#define QUERIES 2000
+#define GRAPH_FILE "graph_bench.asgraph"
+
+static float euclideanHeuristic(uint32_t fromNode, uint32_t toNode, void *context) {
+    // the same estimate as the graph's ASGraphHeuristicEuclidean, so both searches expand the same nodes
+    const float dx = (float)(fromNode % WIDTH) - (float)(toNode % WIDTH);
+    const float dy = (float)(fromNode / WIDTH) - (float)(toNode / WIDTH);
+    return sqrtf(dx*dx + dy*dy);
+}
+
+int main(int argc, char** argv) {
+    const uint32_t nodeCount = WIDTH * WIDTH;
+    uint8_t *blocked = calloc(nodeCount, 1);
+    benchGrid g = {WIDTH, blocked, NULL, 1, 1};
+    float *positions = malloc(nodeCount * 2 * sizeof(float));
+    const ASPathNodeIDSource source = {nodeCount, &cellNeighbors, &euclideanHeuristic, NULL};
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    uint32_t *starts = malloc(QUERIES * sizeof(uint32_t));
+    uint32_t *goals = malloc(QUERIES * sizeof(uint32_t));
+    double callbackChecksum = 0, graphChecksum = 0, fileChecksum = 0;
+    srand(1);
+
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        positions[2 * i] = (float)(i % WIDTH);
+        positions[2 * i + 1] = (float)(i / WIDTH);
+        blocked[i] = (rand() % 100) < 20;
+    }
+
+    for (size_t q = 0; q < QUERIES; q++) {
+        do { starts[q] = rand() % nodeCount; } while (blocked[starts[q]]);
+        do { goals[q] = rand() % nodeCount; } while (blocked[goals[q]]);
+    }
+
+    double begin = now();
+    ASGraph graph = ASGraphCreateWithNodeIDSource(&source, &g);
+    ASGraphSetPositions(graph, positions, ASGraphHeuristicEuclidean, 1);
+    const double buildTime = now() - begin;
+
+    begin = now();
+    for (size_t q = 0; q < QUERIES; q++) {
+        ASPath path = ASPathCreateWithNodeIDs(workspace, &source, &g, starts[q], goals[q]);
+        callbackChecksum += ASPathGetCost(path, ASPathGetCount(path) - 1);
+        ASPathDestroy(path);
+    }
+    const double callbackTime = now() - begin;
+
+    begin = now();
+    for (size_t q = 0; q < QUERIES; q++) {
+        ASPath path = ASPathCreateWithGraph(workspace, graph, starts[q], goals[q]);
+        graphChecksum += ASPathGetCost(path, ASPathGetCount(path) - 1);
+        ASPathDestroy(path);
+    }
+    const double graphTime = now() - begin;
+
+    if (ASGraphWriteFile(graph, GRAPH_FILE) != 0) {
+        fprintf(stderr, "could not write %s\n", GRAPH_FILE);
+        return 1;
+    }
+
+    begin = now();
+    ASGraph fileGraph = ASGraphOpenFile(GRAPH_FILE);
+    const double openTime = now() - begin;
+
+    begin = now();
+    for (size_t q = 0; q < QUERIES; q++) {
+        ASPath path = ASPathCreateWithGraph(workspace, fileGraph, starts[q], goals[q]);
+        fileChecksum += ASPathGetCost(path, ASPathGetCount(path) - 1);
+        ASPathDestroy(path);
+    }
+    const double fileTime = now() - begin;
+
+    printf("%dx%d grid, %zu edges, %d queries\n", WIDTH, WIDTH, ASGraphGetEdgeCount(graph), QUERIES);
+    printf("  build     time=%8.4fs\n", buildTime);
+    printf("  callback  time=%8.4fs checksum=%.1f\n", callbackTime, callbackChecksum);
+    printf("  graph     time=%8.4fs checksum=%.1f\n", graphTime, graphChecksum);
+    printf("  open      time=%8.4fs\n", openTime);
+    printf("  file      time=%8.4fs checksum=%.1f\n", fileTime, fileChecksum);
+    printf("  speedup %.1fx\n", callbackTime / graphTime);
+
+    ASGraphDestroy(fileGraph);
+    ASGraphDestroy(graph);
+    remove(GRAPH_FILE);
+    ASSearchWorkspaceDestroy(workspace);
+    free(starts);
+    free(goals);
+    free(positions);
+    free(blocked);
+    return 0;
+}
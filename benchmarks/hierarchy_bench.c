@@ -0,0 +1,80 @@
+// Contraction hierarchy benchmark: builds a hierarchy for an 8-connected grid of over 100k nodes and runs the
+// same random queries through ASPathCreateWithGraph() (A* with the Euclidean heuristic) and through the hierarchy.
+// Reports preprocessing time, shortcut count, memory and query latency of both.
+
+#include "bench_common.h"
+#include <stdio.h>
+
+#define WIDTH   320
+#define QUERIES 1000
+
+static double runQueries(ASSearchWorkspace workspace, ASGraph graph, ASContractionHierarchy hierarchy, const uint32_t *starts, const uint32_t *goals, double *checksum) {
+    const double begin = now();
+    *checksum = 0;
+
+    for (size_t q = 0; q < QUERIES; q++) {
+        ASPath path = hierarchy? ASPathCreateWithContractionHierarchy(workspace, hierarchy, starts[q], goals[q]) : ASPathCreateWithGraph(workspace, graph, starts[q], goals[q]);
+        if (path) {
+            *checksum += ASPathGetCost(path, ASPathGetCount(path) - 1);
+        }
+        ASPathDestroy(path);
+    }
+
+    return (now() - begin) / QUERIES;
+}
+
+int main(int argc, char** argv) {
+    const uint32_t nodeCount = WIDTH * WIDTH;
+    uint8_t *blocked = calloc(nodeCount, 1);
+    benchGrid g = {WIDTH, blocked, NULL, 1, 1};
+    float *positions = malloc(nodeCount * 2 * sizeof(float));
+    const ASPathNodeIDSource source = {nodeCount, &cellNeighbors, NULL, NULL, NULL};
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    uint32_t starts[QUERIES], goals[QUERIES];
+    double astarChecksum, hierarchyChecksum;
+    srand(1);
+
+    // scattered wall segments
+    for (int s = 0; s < WIDTH * 2; s++) {
+        const int x = rand() % WIDTH, y = rand() % WIDTH, horizontal = rand() % 2;
+        for (int i = 0; i < 12; i++) {
+            const int wx = horizontal? x + i : x, wy = horizontal? y : y + i;
+            if (wx < WIDTH && wy < WIDTH) {
+                blocked[wy * WIDTH + wx] = 1;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        positions[2 * i] = (float)(i % WIDTH);
+        positions[2 * i + 1] = (float)(i / WIDTH);
+    }
+
+    for (size_t q = 0; q < QUERIES; q++) {
+        do { starts[q] = rand() % nodeCount; } while (blocked[starts[q]]);
+        do { goals[q] = rand() % nodeCount; } while (blocked[goals[q]]);
+    }
+
+    ASGraph graph = ASGraphCreateWithNodeIDSource(&source, &g);
+    ASGraphSetPositions(graph, positions, ASGraphHeuristicEuclidean, 1);
+
+    double begin = now();
+    ASContractionHierarchy hierarchy = ASContractionHierarchyCreate(graph);
+    const double buildTime = now() - begin;
+
+    const double astarTime = runQueries(workspace, graph, NULL, starts, goals, &astarChecksum);
+    const double hierarchyTime = runQueries(workspace, graph, hierarchy, starts, goals, &hierarchyChecksum);
+
+    printf("%dx%d grid, %u nodes, %zu edges, %d queries\n", WIDTH, WIDTH, nodeCount, ASGraphGetEdgeCount(graph), QUERIES);
+    printf("  preprocessing time=%.2fs shortcuts=%zu memory=%.1fMB\n", buildTime, ASContractionHierarchyGetShortcutCount(hierarchy), ASContractionHierarchyGetMemorySize(hierarchy) / 1048576.0);
+    printf("  A*         %9.1fus per query checksum=%.1f\n", 1e6 * astarTime, astarChecksum);
+    printf("  hierarchy  %9.1fus per query checksum=%.1f\n", 1e6 * hierarchyTime, hierarchyChecksum);
+    printf("  speedup %.1fx\n", astarTime / hierarchyTime);
+
+    ASContractionHierarchyDestroy(hierarchy);
+    ASGraphDestroy(graph);
+    ASSearchWorkspaceDestroy(workspace);
+    free(positions);
+    free(blocked);
+    return 0;
+}
@@ -0,0 +1,42 @@
+// Visited node index benchmark: explores a whole 4-connected grid (goalNode == NULL) and reports
+// expansions per second with the hash index (nodeHash set) and with the sorted index fallback.
+// The sorted index is O(n) per new node, so it is capped at SORTED_MAX_EXPANSIONS expansions.
+
+#include "bench_common.h"
+#include <stdio.h>
+
+#define SORTED_MAX_EXPANSIONS 100000
+
+typedef struct {
+    benchGrid grid;                     // first, so the cell callbacks can take the same context
+    size_t maxExpansions;
+} limitedGrid;
+
+static int cellEarlyExit(size_t visitedCount, void *visitingNode, void *goalNode, void *context) {
+    limitedGrid *g = (limitedGrid*)context;
+    return (g->maxExpansions && g->grid.expansions >= g->maxExpansions)? -1 : 0;
+}
+
+static void run(const char *name, const ASPathNodeSource *source, int32_t width, size_t maxExpansions) {
+    limitedGrid g = {{(uint32_t)width, NULL, NULL, 0, 0}, maxExpansions};
+    benchCell start = {0, 0};
+
+    const double begin = now();
+    ASPath path = ASPathCreate(source, &g, &start, NULL);
+    const double elapsed = now() - begin;
+    ASPathDestroy(path);
+
+    printf("%-8s nodes=%-9d expansions=%-9zu time=%9.4fs expansions/s=%.0f\n", name, width*width, g.grid.expansions, elapsed, g.grid.expansions / elapsed);
+}
+
+int main(int argc, char** argv) {
+    const ASPathNodeSource hashed = {sizeof(benchCell), &cellNodeNeighbors, NULL, &cellEarlyExit, NULL, &cellHash};
+    const ASPathNodeSource sorted = {sizeof(benchCell), &cellNodeNeighbors, NULL, &cellEarlyExit, NULL, NULL};
+    const int32_t widths[] = {32, 317, 1000};   // ~1k, ~100k and 1M nodes
+
+    for (size_t i = 0; i < sizeof(widths)/sizeof(widths[0]); i++) {
+        run("hash", &hashed, widths[i], 0);
+        run("sorted", &sorted, widths[i], SORTED_MAX_EXPANSIONS);
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Jump Point Search benchmark: a 512x512 floor with scattered shelf blocks, searched four and eight connected with
+// A* over the compiled graph, with JPS scanning the grid's bit rows and with JPS+ reading the jump table.
+// Reports the nodes each search reached (its open list traffic), the search time and the JPS+ preprocessing time.
+
+#include "bench_common.h"
+#include <stdio.h>
+
+#define WIDTH   512
+#define QUERIES 500
+
+static void report(const char *name, ASSearchWorkspace workspace, ASGraph graph, ASGrid grid, const uint32_t *starts, const uint32_t *goals) {
+    size_t visited = 0;
+    double checksum = 0;
+    const double begin = now();
+
+    for (size_t q = 0; q < QUERIES; q++) {
+        ASPath path = graph? ASPathCreateWithGraph(workspace, graph, starts[q], goals[q]) : ASPathCreateWithGrid(workspace, grid, starts[q], goals[q]);
+        visited += ASSearchWorkspaceGetVisitedCount(workspace);
+        if (path) {
+            checksum += ASPathGetCost(path, ASPathGetCount(path) - 1);
+        }
+        ASPathDestroy(path);
+    }
+
+    const double searchTime = (now() - begin) / QUERIES;
+    printf("  %-6s visited=%-9zu %8.1fus per query checksum=%.1f\n", name, visited / QUERIES, 1e6 * searchTime, checksum);
+}
+
+int main(int argc, char** argv) {
+    const uint32_t nodeCount = WIDTH * WIDTH;
+    uint8_t *blocked = calloc(nodeCount, 1);
+    float *positions = malloc(nodeCount * 2 * sizeof(float));
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    uint32_t starts[QUERIES], goals[QUERIES];
+    srand(1);
+
+    // shelf blocks of 2 to 9 cells on a side, leaving most of the floor open
+    for (int b = 0; b < WIDTH * WIDTH / 120; b++) {
+        const int x = rand() % WIDTH, y = rand() % WIDTH, w = 2 + rand() % 8, h = 2 + rand() % 8;
+        for (int by = y; by < y + h && by < WIDTH; by++) {
+            for (int bx = x; bx < x + w && bx < WIDTH; bx++) {
+                blocked[by * WIDTH + bx] = 1;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        positions[2 * i] = (float)(i % WIDTH);
+        positions[2 * i + 1] = (float)(i / WIDTH);
+    }
+
+    for (size_t q = 0; q < QUERIES; q++) {
+        do { starts[q] = rand() % nodeCount; } while (blocked[starts[q]]);
+        do { goals[q] = rand() % nodeCount; } while (blocked[goals[q]]);
+    }
+
+    for (int c = 0; c < 2; c++) {
+        // same moves as the grid: no diagonal step past the corner of a blocked cell
+        const ASGridConnectivity connectivity = c? ASGridEightConnected : ASGridFourConnected;
+        benchGrid map = {WIDTH, blocked, NULL, c, 0};
+        const ASPathNodeIDSource source = {nodeCount, &cellNeighbors, NULL, NULL, NULL};
+        ASGraph graph = ASGraphCreateWithNodeIDSource(&source, &map);
+        ASGrid grid = ASGridCreate(WIDTH, WIDTH, blocked, connectivity);
+        ASGrid jumpGrid = ASGridCreate(WIDTH, WIDTH, blocked, connectivity);
+
+        // Euclidean distance is admissible for both, Manhattan distance is tighter without diagonal steps
+        ASGraphSetPositions(graph, positions, c? ASGraphHeuristicEuclidean : ASGraphHeuristicManhattan, 1);
+
+        const double begin = now();
+        ASGridBuildJumpTable(jumpGrid);
+        const double buildTime = now() - begin;
+
+        printf("%dx%d floor, %d connected, %d queries, jump table built in %.3fs\n", WIDTH, WIDTH, connectivity, QUERIES, buildTime);
+        report("A*", workspace, graph, NULL, starts, goals);
+        report("JPS", workspace, NULL, grid, starts, goals);
+        report("JPS+", workspace, NULL, jumpGrid, starts, goals);
+
+        ASGraphDestroy(graph);
+        ASGridDestroy(grid);
+        ASGridDestroy(jumpGrid);
+    }
+
+    ASSearchWorkspaceDestroy(workspace);
+    free(positions);
+    free(blocked);
+    return 0;
+}
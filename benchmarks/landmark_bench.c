@@ -0,0 +1,108 @@
+// Landmark benchmark: a warehouse map of shelf blocks with one-way aisles, searched with the Manhattan heuristic
+// alone and with 4, 8 and 16 ALT landmarks on top of it. Reports preprocessing time, expansions and search time.
+
+#include "bench_common.h"
+#include <stdio.h>
+
+#define WIDTH   256
+#define QUERIES 1000
+
+typedef struct {
+    benchGrid grid;
+    ASGraph graph;
+} warehouse;
+
+static int canMove(const warehouse *w, int x, int y, int dx, int dy) {
+    if (!isOpen(&w->grid, x + dx, y + dy)) {
+        return 0;
+    }
+    // aisles between shelf blocks are one-way, alternating direction from one aisle to the next
+    if (dx == 0 && x % 8 >= 6) {
+        return (x / 8) % 2 ? dy > 0 : dy < 0;
+    }
+    return 1;
+}
+
+static void aisleNeighbors(ASNeighborList neighbors, uint32_t node, float node_cost, uint32_t from_node, void *context) {
+    warehouse *w = (warehouse*)context;
+    const int x = node % WIDTH;
+    const int y = node / WIDTH;
+    w->grid.expansions++;
+
+    if (!isOpen(&w->grid, x, y)) {
+        return;
+    }
+
+    if (canMove(w, x, y, -1, 0)) ASNeighborListAddID(neighbors, node - 1, 1);
+    if (canMove(w, x, y, 1, 0))  ASNeighborListAddID(neighbors, node + 1, 1);
+    if (canMove(w, x, y, 0, -1)) ASNeighborListAddID(neighbors, node - WIDTH, 1);
+    if (canMove(w, x, y, 0, 1))  ASNeighborListAddID(neighbors, node + WIDTH, 1);
+}
+
+static float landmarkHeuristic(uint32_t fromNode, uint32_t toNode, void *context) {
+    return ASGraphEstimateCost(((warehouse*)context)->graph, fromNode, toNode);
+}
+
+int main(int argc, char** argv) {
+    const uint32_t nodeCount = WIDTH * WIDTH;
+    const uint32_t landmarkCounts[] = {0, 4, 8, 16};
+    uint8_t *blocked = calloc(nodeCount, 1);
+    warehouse w = {{WIDTH, blocked, NULL, 0, 0}, NULL};
+    float *positions = malloc(nodeCount * 2 * sizeof(float));
+    const ASPathNodeIDSource source = {nodeCount, &aisleNeighbors, &landmarkHeuristic, NULL, NULL};
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    uint32_t starts[QUERIES], goals[QUERIES];
+    srand(1);
+
+    // shelf blocks of 6x62 cells with 2 cell aisles, and a cross aisle every 64 rows and along the bottom
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        const uint32_t x = i % WIDTH, y = i / WIDTH;
+        blocked[i] = (x % 8 < 6) && (y % 64 > 1) && (y < WIDTH - 2);
+        positions[2 * i] = (float)x;
+        positions[2 * i + 1] = (float)y;
+    }
+
+    for (size_t q = 0; q < QUERIES; q++) {
+        do { starts[q] = rand() % nodeCount; } while (blocked[starts[q]]);
+        do { goals[q] = rand() % nodeCount; } while (blocked[goals[q]]);
+    }
+
+    w.graph = ASGraphCreateWithNodeIDSource(&source, &w);
+    ASGraphSetPositions(w.graph, positions, ASGraphHeuristicManhattan, 1);
+
+    printf("%dx%d warehouse, %d queries\n", WIDTH, WIDTH, QUERIES);
+
+    size_t baseExpansions = 0;
+    for (size_t l = 0; l < sizeof(landmarkCounts) / sizeof(landmarkCounts[0]); l++) {
+        double begin = now();
+        const uint32_t landmarks = landmarkCounts[l]? ASGraphBuildLandmarks(w.graph, landmarkCounts[l]) : 0;
+        const double buildTime = now() - begin;
+        double checksum = 0;
+
+        w.grid.expansions = 0;
+        for (size_t q = 0; q < QUERIES; q++) {
+            ASPath path = ASPathCreateWithNodeIDs(workspace, &source, &w, starts[q], goals[q]);
+            if (path) {
+                checksum += ASPathGetCost(path, ASPathGetCount(path) - 1);
+            }
+            ASPathDestroy(path);
+        }
+
+        begin = now();
+        for (size_t q = 0; q < QUERIES; q++) {
+            ASPathDestroy(ASPathCreateWithGraph(workspace, w.graph, starts[q], goals[q]));
+        }
+        const double searchTime = now() - begin;
+
+        if (l == 0) {
+            baseExpansions = w.grid.expansions;
+        }
+        printf("  landmarks=%-3u build=%7.3fs expansions=%-9zu (%5.1f%%) graph search=%7.4fs checksum=%.1f\n", landmarks, buildTime, w.grid.expansions, 100.0 * w.grid.expansions / baseExpansions, searchTime, checksum);
+    }
+
+    ASGraphDestroy(w.graph);
+    ASSearchWorkspaceDestroy(workspace);
+    free(positions);
+    free(blocked);
+    return 0;
+}
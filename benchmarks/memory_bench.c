@@ -0,0 +1,94 @@
+// Memory limit benchmark: a 2048x2048 8-connected grid with random obstacles and a goal walled in on all sides, so every search
+// explores all it can reach before giving up -- once with (x, y) struct nodes behind a hash index (ASPathCreateWithWorkspace())
+// and once with dense node ids (ASPathCreateWithNodeIDs()). Each runs without a limit, then with a quarter of what that search
+// held (a dense search needs its record per node id in full, so only the rest is cut), then a reachable query runs under the
+// same limit. Reports the status, the time, the nodes visited and the bytes the workspace holds.
+
+#include "bench_common.h"
+#include <stdio.h>
+
+#define WIDTH   2048
+
+static benchGrid grid = {WIDTH, NULL, NULL, 1, 1};
+
+static ASPath search(ASSearchWorkspace workspace, int dense, uint32_t start, uint32_t goal) {
+    static const ASPathNodeIDSource idSource = {WIDTH * WIDTH, &cellNeighbors, &cellHeuristic, NULL, NULL};
+    static const ASPathNodeSource cellSource = {sizeof(benchCell), &cellNodeNeighbors, &cellNodeHeuristic, NULL, NULL, &cellHash};
+
+    if (dense) {
+        return ASPathCreateWithNodeIDs(workspace, &idSource, &grid, start, goal);
+    }
+    benchCell startCell = {start % WIDTH, start / WIDTH};
+    benchCell goalCell = {goal % WIDTH, goal / WIDTH};
+    return ASPathCreateWithWorkspace(workspace, &cellSource, &grid, &startCell, &goalCell);
+}
+
+static void run(const char *name, int dense, uint32_t start, uint32_t walledGoal, uint32_t openGoal) {
+    static const char *statusNames[] = {"completed", "out of memory"};
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    ASSearchOptions options = {0};
+
+    double begin = now();
+    ASPath path = search(workspace, dense, start, walledGoal);
+    const double unlimitedTime = now() - begin;
+    const size_t unlimitedBytes = ASSearchWorkspaceGetMemorySize(workspace);
+    const size_t visited = ASSearchWorkspaceGetVisitedCount(workspace);
+    ASPathDestroy(path);
+
+    // a quarter of it, though the records of a dense search have to fit in full
+    const size_t recordBytes = dense? (size_t)WIDTH * WIDTH * 24 : 0;
+    options.memoryLimit = recordBytes + (unlimitedBytes - recordBytes) / 4;
+    ASSearchWorkspaceDestroy(workspace);
+    workspace = ASSearchWorkspaceCreate();
+    ASSearchWorkspaceSetOptions(workspace, &options);
+
+    begin = now();
+    path = search(workspace, dense, start, walledGoal);
+    const double limitedTime = now() - begin;
+    const ASSearchStatus limitedStatus = ASSearchWorkspaceGetStatus(workspace);
+    const size_t limitedBytes = ASSearchWorkspaceGetMemorySize(workspace);
+    const size_t limitedVisited = ASSearchWorkspaceGetVisitedCount(workspace);
+    ASPathDestroy(path);
+
+    begin = now();
+    path = search(workspace, dense, start, openGoal);
+    const double openTime = now() - begin;
+
+    printf("%s\n", name);
+    printf("  walled in goal, no limit   %-13s %9.1fms %8zu visited %8.1f MB\n", statusNames[0], 1e3 * unlimitedTime, visited, unlimitedBytes / 1048576.0);
+    printf("  walled in goal, %5.1f MB   %-13s %9.1fms %8zu visited %8.1f MB\n", options.memoryLimit / 1048576.0, statusNames[limitedStatus], 1e3 * limitedTime, limitedVisited, limitedBytes / 1048576.0);
+    printf("  nearby goal,    %5.1f MB   %-13s %9.1fms %8zu visited %8.1f MB, path of %zu nodes\n", options.memoryLimit / 1048576.0, statusNames[ASSearchWorkspaceGetStatus(workspace)], 1e3 * openTime, ASSearchWorkspaceGetVisitedCount(workspace), ASSearchWorkspaceGetMemorySize(workspace) / 1048576.0, ASPathGetCount(path));
+
+    ASPathDestroy(path);
+    ASSearchWorkspaceDestroy(workspace);
+}
+
+int main(int argc, char** argv) {
+    const uint32_t nodeCount = WIDTH * WIDTH;
+    srand(1);
+
+    uint8_t *blocked = malloc(nodeCount);
+    grid.blocked = blocked;
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        blocked[i] = (rand() % 100) < 20;
+    }
+
+    // the start in one corner, the walled in goal in the other and a reachable goal a short way off
+    const uint32_t start = 8 * WIDTH + 8;
+    const uint32_t walledGoal = (WIDTH - 9) * WIDTH + WIDTH - 9;
+    const uint32_t openGoal = 200 * WIDTH + 200;
+    blocked[start] = blocked[walledGoal] = blocked[openGoal] = 0;
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            if (dx || dy) {
+                blocked[walledGoal + dy * WIDTH + dx] = 1;
+            }
+        }
+    }
+
+    run("struct nodes", 0, start, walledGoal, openGoal);
+    run("node ids", 1, start, walledGoal, openGoal);
+
+    free(blocked);
+    return 0;
+}
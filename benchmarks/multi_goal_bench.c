@@ -0,0 +1,60 @@
+// One-to-many benchmark: for every start, finds the paths to a set of goals once with one ASPathCreateWithNodeIDs()
+// per goal and once with a single ASPathCreateMultiWithNodeIDs(), and reports time and expansions of both.
+
+#include "bench_common.h"
+#include <stdio.h>
+
+#define WIDTH   128
+#define STARTS  16
+#define GOALS   256
+
+int main(int argc, char** argv) {
+    float *cellCosts = malloc(WIDTH * WIDTH * sizeof(float));
+    benchGrid g = {WIDTH, NULL, cellCosts, 0, 0};
+    const ASPathNodeIDSource source = {WIDTH * WIDTH, &cellNeighbors, NULL, NULL};
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    uint32_t goals[GOALS];
+    float costs[GOALS];
+    double singleChecksum = 0, multiChecksum = 0, singleTime = 0, multiTime = 0;
+    size_t singleExpansions = 0, multiExpansions = 0;
+    srand(1);
+
+    for (uint32_t i = 0; i < WIDTH * WIDTH; i++) {
+        cellCosts[i] = 1 + (rand() % 100) / 10.0f;
+    }
+
+    for (size_t s = 0; s < STARTS; s++) {
+        const uint32_t start = rand() % (WIDTH * WIDTH);
+        for (size_t i = 0; i < GOALS; i++) {
+            goals[i] = rand() % (WIDTH * WIDTH);
+        }
+
+        g.expansions = 0;
+        double begin = now();
+        for (size_t i = 0; i < GOALS; i++) {
+            ASPath path = ASPathCreateWithNodeIDs(workspace, &source, &g, start, goals[i]);
+            singleChecksum += ASPathGetCost(path, ASPathGetCount(path) - 1);
+            ASPathDestroy(path);
+        }
+        singleTime += now() - begin;
+        singleExpansions += g.expansions;
+
+        g.expansions = 0;
+        begin = now();
+        ASPathCreateMultiWithNodeIDs(workspace, &source, &g, start, goals, GOALS, NULL, costs);
+        multiTime += now() - begin;
+        multiExpansions += g.expansions;
+        for (size_t i = 0; i < GOALS; i++) {
+            multiChecksum += costs[i];
+        }
+    }
+
+    printf("%dx%d grid, %d starts x %d goals\n", WIDTH, WIDTH, STARTS, GOALS);
+    printf("  single  time=%8.4fs expansions=%-10zu checksum=%.1f\n", singleTime, singleExpansions, singleChecksum);
+    printf("  multi   time=%8.4fs expansions=%-10zu checksum=%.1f\n", multiTime, multiExpansions, multiChecksum);
+    printf("  speedup %.1fx\n", singleTime / multiTime);
+
+    ASSearchWorkspaceDestroy(workspace);
+    free(cellCosts);
+    return 0;
+}
@@ -0,0 +1,63 @@
+// Open set benchmark: runs the same dense node id searches with every ASOpenSet and reports the time
+// and expansions per second of each, on 4-connected grids with random cell costs so the open set stays busy.
+// The cell costs are multiples of 0.1, which is the cost quantum given to the bucket queue.
+
+#include "bench_common.h"
+#include <stdio.h>
+
+#define QUERIES 64
+
+static void run(const char *name, ASOpenSet openSet, float costQuantum, benchGrid *g, const ASPathNodeIDSource *source, const uint32_t *starts, const uint32_t *goals) {
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    ASSearchOptions options = {openSet, costQuantum};
+    ASSearchWorkspaceSetOptions(workspace, &options);
+    double checksum = 0;
+    g->expansions = 0;
+
+    const double begin = now();
+    for (size_t i = 0; i < QUERIES; i++) {
+        ASPath path = ASPathCreateWithNodeIDs(workspace, source, g, starts[i], goals[i]);
+        checksum += ASPathGetCost(path, ASPathGetCount(path) - 1);
+        ASPathDestroy(path);
+    }
+    const double elapsed = now() - begin;
+    ASSearchWorkspaceDestroy(workspace);
+
+    printf("  %-8s time=%8.4fs expansions=%-10zu expansions/s=%-10.0f checksum=%.1f\n", name, elapsed, g->expansions, g->expansions / elapsed, checksum);
+}
+
+int main(int argc, char** argv) {
+    const uint32_t widths[] = {256, 512};
+    uint32_t starts[QUERIES], goals[QUERIES];
+    srand(1);
+
+    for (size_t w = 0; w < sizeof(widths)/sizeof(widths[0]); w++) {
+        float *cellCosts = malloc(widths[w] * widths[w] * sizeof(float));
+        benchGrid g = {widths[w], NULL, cellCosts, 0, 0};
+        for (uint32_t i = 0; i < widths[w] * widths[w]; i++) {
+            cellCosts[i] = 1 + (rand() % 100) / 10.0f;
+        }
+        for (size_t i = 0; i < QUERIES; i++) {
+            starts[i] = rand() % (widths[w] * widths[w]);
+            goals[i] = rand() % (widths[w] * widths[w]);
+        }
+
+        const ASPathNodeIDSource dijkstra = {widths[w] * widths[w], &cellNeighbors, NULL, NULL};
+        const ASPathNodeIDSource astar = {widths[w] * widths[w], &cellNeighbors, &cellHeuristic, NULL};
+
+        printf("%ux%u grid, %d queries without heuristic\n", widths[w], widths[w], QUERIES);
+        run("binary", ASOpenSetBinaryHeap, 0, &g, &dijkstra, starts, goals);
+        run("4-ary", ASOpenSet4AryHeap, 0, &g, &dijkstra, starts, goals);
+        run("8-ary", ASOpenSet8AryHeap, 0, &g, &dijkstra, starts, goals);
+        run("bucket", ASOpenSetBucketQueue, 0.1f, &g, &dijkstra, starts, goals);
+
+        printf("%ux%u grid, %d queries with manhattan heuristic\n", widths[w], widths[w], QUERIES);
+        run("binary", ASOpenSetBinaryHeap, 0, &g, &astar, starts, goals);
+        run("4-ary", ASOpenSet4AryHeap, 0, &g, &astar, starts, goals);
+        run("8-ary", ASOpenSet8AryHeap, 0, &g, &astar, starts, goals);
+        run("bucket", ASOpenSetBucketQueue, 0.1f, &g, &astar, starts, goals);
+
+        free(cellCosts);
+    }
+    return 0;
+}
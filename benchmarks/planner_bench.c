@@ -0,0 +1,97 @@
+// Incremental replanning benchmark: a robot drives across a 256x256 warehouse floor one cell per step while forklifts park
+// on cells next to its path. After every step it replans once with the D* Lite planner (which only repairs the part of the
+// search tree the blocked cells touched) and once from scratch with ASPathCreateWithNodeIDs(), and both paths are compared.
+// Reports the nodes expanded and the time per replan of both.
+
+#include "bench_common.h"
+#include <stdio.h>
+
+#define WIDTH   256
+#define RUNS    20
+
+static void blockCell(uint8_t *blocked, ASPlanner planner, uint32_t cell) {
+    // a blocked cell changes the edges into it and out of it
+    const int x = cell % WIDTH;
+    const int y = cell / WIDTH;
+    blocked[cell] = 1;
+
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            const int nx = x + dx, ny = y + dy;
+            if ((dx || dy) && nx >= 0 && nx < WIDTH && ny >= 0 && ny < WIDTH) {
+                ASPlannerUpdateEdge(planner, ny * WIDTH + nx, cell);
+                ASPlannerUpdateEdge(planner, cell, ny * WIDTH + nx);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    const uint32_t nodeCount = WIDTH * WIDTH;
+    uint8_t *blocked = malloc(nodeCount);
+    benchGrid map = {WIDTH, blocked, NULL, 1, 1};
+    const ASPathNodeIDSource source = {nodeCount, &cellNeighbors, &cellHeuristic, NULL, NULL};
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    size_t replans = 0, mismatches = 0, plannerExpanded = 0, searchVisited = 0, initialExpanded = 0;
+    double plannerTime = 0, searchTime = 0, initialTime = 0;
+    srand(1);
+
+    for (int run = 0; run < RUNS; run++) {
+        // shelf rows with gaps every few cells
+        for (uint32_t i = 0; i < nodeCount; i++) {
+            const int x = i % WIDTH, y = i / WIDTH;
+            blocked[i] = (y % 8 == 4) && (x % 24 > 3) && (rand() % 100 < 90);
+        }
+
+        uint32_t start, goal;
+        do { start = rand() % (WIDTH * 16); } while (blocked[start]);
+        do { goal = nodeCount - 1 - rand() % (WIDTH * 16); } while (blocked[goal]);
+
+        double begin = now();
+        ASPlanner planner = ASPlannerCreate(&source, &map, start, goal);
+        ASPath path = ASPlannerCreatePath(planner);
+        initialTime += now() - begin;
+        initialExpanded += ASPlannerGetExpandedCount(planner);
+
+        while (path && ASPathGetCount(path) > 2) {
+            // step along the path, then park a forklift a few cells ahead of the robot
+            start = ASPathGetNodeID(path, 1);
+            ASPlannerSetStart(planner, start);
+
+            const uint32_t ahead = ASPathGetNodeID(path, ASPathGetCount(path) > 6? 6 : ASPathGetCount(path) - 1);
+            if (ahead != goal && rand() % 4 == 0) {
+                blockCell(blocked, planner, ahead);
+            }
+            ASPathDestroy(path);
+
+            begin = now();
+            path = ASPlannerCreatePath(planner);
+            plannerTime += now() - begin;
+            plannerExpanded += ASPlannerGetExpandedCount(planner);
+
+            begin = now();
+            ASPath fresh = ASPathCreateWithNodeIDs(workspace, &source, &map, start, goal);
+            searchTime += now() - begin;
+            searchVisited += ASSearchWorkspaceGetVisitedCount(workspace);
+
+            if (!path != !fresh || (path && fabsf(ASPathGetCost(path, ASPathGetCount(path) - 1) - ASPathGetCost(fresh, ASPathGetCount(fresh) - 1)) > 1e-2f)) {
+                mismatches++;
+            }
+            ASPathDestroy(fresh);
+            replans++;
+        }
+
+        ASPathDestroy(path);
+        ASPlannerDestroy(planner);
+    }
+
+    printf("%dx%d floor, %d runs, %zu replans, %zu cost mismatches\n", WIDTH, WIDTH, RUNS, replans, mismatches);
+    printf("  initial plan      %9.1f expanded %9.1fus\n", (double)initialExpanded / RUNS, 1e6 * initialTime / RUNS);
+    printf("  replan D* Lite    %9.1f expanded %9.1fus\n", (double)plannerExpanded / replans, 1e6 * plannerTime / replans);
+    printf("  replan A*         %9.1f visited  %9.1fus\n", (double)searchVisited / replans, 1e6 * searchTime / replans);
+    printf("  speedup %.1fx\n", searchTime / plannerTime);
+
+    ASSearchWorkspaceDestroy(workspace);
+    free(blocked);
+    return 0;
+}
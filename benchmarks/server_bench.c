@@ -0,0 +1,226 @@
+// Planner daemon benchmark: writes a 256x256 8-connected grid with random obstacles and 8 landmarks to a graph file, starts
+// astar_server on it over pipes and streams queries to it in batches of 256 from one thread while another reads the answers.
+// Runs the server with one worker and with one per core, against ASPathWriteWithGraph() in this process on one thread, and
+// bidirectionally (-b) on a directed version of the grid whose file has no reverse edges.
+// Reports queries per second, when the first answer arrived, and answers whose cost differs from the in-process search.
+// Pass the path of astar_server as the first argument to use another build than the one next to this benchmark.
+
+#include "bench_common.h"
+#include "AStarServer.h"
+#include <stdio.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define WIDTH       256
+#define QUERIES     4000
+#define BATCH       256
+
+static uint32_t starts[QUERIES];
+static uint32_t goals[QUERIES];
+static float costs[QUERIES];
+static float directedCosts[QUERIES];
+
+typedef struct {
+    int fd;
+    uint32_t flags;
+} Sender;
+
+static int readFully(int fd, void *buffer, size_t size) {
+    uint8_t *bytes = buffer;
+    while (size > 0) {
+        const ssize_t n = read(fd, bytes, size);
+        if (n <= 0) {
+            return 0;
+        }
+        bytes += n;
+        size -= (size_t)n;
+    }
+    return 1;
+}
+
+static ASGraph createGrid(int directed) {
+    const uint32_t nodeCount = WIDTH * WIDTH;
+    uint8_t *blocked = malloc(nodeCount);
+    ASGraphEdge *edges = malloc(nodeCount * 8 * sizeof(ASGraphEdge));
+    float *positions = malloc(nodeCount * 2 * sizeof(float));
+    size_t edgeCount = 0;
+
+    // the directed grid has the same cells, with a quarter of the edges dropped so that their opposite edges are one-way
+    srand(1);
+    for (uint32_t n = 0; n < nodeCount; n++) {
+        blocked[n] = (rand() % 100) < 20;
+        positions[2 * n] = (float)(n % WIDTH);
+        positions[2 * n + 1] = (float)(n / WIDTH);
+    }
+
+    for (uint32_t n = 0; n < nodeCount; n++) {
+        const int x = n % WIDTH, y = n / WIDTH;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                const int nx = x + dx, ny = y + dy;
+                if ((dx || dy) && nx >= 0 && ny >= 0 && nx < WIDTH && ny < WIDTH && !blocked[n] && !blocked[ny * WIDTH + nx] && (!directed || rand() % 4)) {
+                    edges[edgeCount++] = (ASGraphEdge){n, ny * WIDTH + nx, (dx && dy)? 1.41421356f : 1.f};
+                }
+            }
+        }
+    }
+
+    ASGraph graph = ASGraphCreateWithEdges(nodeCount, edges, edgeCount);
+    ASGraphSetPositions(graph, positions, ASGraphHeuristicEuclidean, 1.f);
+    ASGraphBuildLandmarks(graph, 8);
+    free(positions);
+    free(edges);
+    free(blocked);
+    return graph;
+}
+
+// writes all queries without waiting for answers, so the server always has the next batch at hand
+static void *sendQueries(void *argument) {
+    const Sender *sender = argument;
+    ASServerQuery queries[BATCH];
+
+    for (uint32_t first = 0; first < QUERIES; first += BATCH) {
+        const uint32_t count = (QUERIES - first < BATCH)? QUERIES - first : BATCH;
+        const ASServerBatchHeader header = {ASServerRequestMagic, sender->flags, count};
+        for (uint32_t i = 0; i < count; i++) {
+            queries[i] = (ASServerQuery){first + i, starts[first + i], goals[first + i]};
+        }
+        if (write(sender->fd, &header, sizeof(header)) != sizeof(header) || write(sender->fd, queries, count * sizeof(ASServerQuery)) != (ssize_t)(count * sizeof(ASServerQuery))) {
+            break;
+        }
+    }
+
+    close(sender->fd);
+    return NULL;
+}
+
+static void solve(ASGraph graph, float *expectedCosts) {
+    // runs the queries in this process on one thread and keeps the cost of each, INFINITY where there is no path
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    uint32_t *nodes = malloc(WIDTH * WIDTH * sizeof(uint32_t));
+    float *pathCosts = malloc(WIDTH * WIDTH * sizeof(float));
+
+    for (int q = 0; q < QUERIES; q++) {
+        const size_t count = ASPathWriteWithGraph(workspace, graph, starts[q], goals[q], nodes, pathCosts, WIDTH * WIDTH);
+        expectedCosts[q] = (count > 0)? pathCosts[count - 1] : INFINITY;
+    }
+
+    free(pathCosts);
+    free(nodes);
+    ASSearchWorkspaceDestroy(workspace);
+}
+
+static void runServer(const char *serverPath, const char *graphPath, const char *threads, uint32_t flags, const char *mode, const float *expectedCosts) {
+    int toServer[2], fromServer[2];
+    if (pipe(toServer) != 0 || pipe(fromServer) != 0) {
+        perror("pipe");
+        exit(1);
+    }
+
+    const double begin = now();
+    const pid_t pid = fork();
+    if (pid == 0) {
+        dup2(toServer[0], STDIN_FILENO);
+        dup2(fromServer[1], STDOUT_FILENO);
+        close(toServer[0]);
+        close(toServer[1]);
+        close(fromServer[0]);
+        close(fromServer[1]);
+        if (mode) {
+            execl(serverPath, "astar_server", "-t", threads, mode, graphPath, (char *)NULL);
+        } else {
+            execl(serverPath, "astar_server", "-t", threads, graphPath, (char *)NULL);
+        }
+        perror(serverPath);
+        _exit(1);
+    }
+    close(toServer[0]);
+    close(fromServer[1]);
+
+    Sender sender = {toServer[1], flags};
+    pthread_t thread;
+    pthread_create(&thread, NULL, sendQueries, &sender);
+
+    size_t answers = 0, mismatches = 0, nodes = 0;
+    double firstAnswer = 0;
+    uint32_t *pathNodes = malloc(WIDTH * WIDTH * sizeof(uint32_t));
+    ASServerResponse response;
+
+    while (readFully(fromServer[0], &response, sizeof(response))) {
+        if (answers++ == 0) {
+            firstAnswer = now() - begin;
+        }
+        if (!readFully(fromServer[0], pathNodes, response.nodeCount * sizeof(uint32_t))) {
+            break;
+        }
+        nodes += response.nodeCount;
+
+        const float expected = expectedCosts[response.tag];
+        const float cost = (response.status == ASServerFound)? response.cost : INFINITY;
+        mismatches += (cost != expected && !(fabsf(cost - expected) <= 1e-4f * expected));
+        if (response.nodeCount > 0 && (pathNodes[0] != starts[response.tag] || pathNodes[response.nodeCount - 1] != goals[response.tag])) {
+            mismatches++;
+        }
+    }
+    const double elapsed = now() - begin;
+
+    pthread_join(thread, NULL);
+    close(fromServer[0]);
+    waitpid(pid, NULL, 0);
+    free(pathNodes);
+
+    printf("  server, %s worker(s)%s%s %9.0f queries/s, first answer after %.1fms, %zu answers, %zu mismatches\n", threads, mode? " -b" : "   ", (flags & ASServerFlagNodes)? ", with nodes:" : ":            ", QUERIES / elapsed, 1e3 * firstAnswer, answers, mismatches + (QUERIES - answers));
+}
+
+int main(int argc, char** argv) {
+    const char *serverPath = (argc > 1)? argv[1] : ASTAR_SERVER_PATH;
+    char graphPath[] = "/tmp/server_benchXXXXXX";
+    char directedPath[] = "/tmp/server_benchXXXXXX";
+    char cores[32];
+
+    const int fd = mkstemp(graphPath);
+    const int directedFd = mkstemp(directedPath);
+    if (fd < 0 || directedFd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    close(directedFd);
+
+    // the directed file is written without reverse edges, which a bidirectional search must not take as undirected
+    ASGraph graph = createGrid(0);
+    ASGraph directed = createGrid(1);
+    if (ASGraphWriteFile(graph, graphPath) != 0 || ASGraphWriteFile(directed, directedPath) != 0) {
+        fprintf(stderr, "cannot write the graph files\n");
+        return 1;
+    }
+
+    for (int q = 0; q < QUERIES; q++) {
+        starts[q] = rand() % (WIDTH * WIDTH);
+        goals[q] = rand() % (WIDTH * WIDTH);
+    }
+
+    // the same queries in this process, which also gives the costs to check the answers against
+    const double begin = now();
+    solve(graph, costs);
+    const double elapsed = now() - begin;
+    solve(directed, directedCosts);
+
+    printf("%u nodes, %zu edges (%zu directed), 8 landmarks, %d queries in batches of %d\n", ASGraphGetNodeCount(graph), ASGraphGetEdgeCount(graph), ASGraphGetEdgeCount(directed), QUERIES, BATCH);
+    printf("  in process, 1 thread:                %9.0f queries/s\n", QUERIES / elapsed);
+
+    signal(SIGPIPE, SIG_IGN);
+    snprintf(cores, sizeof(cores), "%ld", sysconf(_SC_NPROCESSORS_ONLN));
+    runServer(serverPath, graphPath, "1", 0, NULL, costs);
+    runServer(serverPath, graphPath, cores, 0, NULL, costs);
+    runServer(serverPath, graphPath, cores, ASServerFlagNodes, NULL, costs);
+    runServer(serverPath, directedPath, cores, ASServerFlagNodes, "-b", directedCosts);
+
+    unlink(directedPath);
+    unlink(graphPath);
+    ASGraphDestroy(directed);
+    ASGraphDestroy(graph);
+    return 0;
+}
@@ -0,0 +1,600 @@
+// Benchmark suite: compiles graphs of several families (open grids, mazes, random geometric graphs, road-like grids)
+// at several sizes into an ASGraph and runs random connected queries through ASPathCreateWithGraph() with one warm
+// workspace. For every case it reports the query latency percentiles, the nodes visited per second, the allocations
+// per query and the peak resident set size, and with -o it writes all results as JSON to track them between releases.
+// Every case also runs on the graph renumbered by ASGraphReorder(), with the same queries, and reports the nodes expanded
+// per second and the last level cache misses per expansion (from perf_event_open() on Linux, where the kernel allows it).
+//
+// usage: suite_bench [-f families] [-s sizes] [-r orders] [-q queries] [-o results.json]
+//   -f  comma separated families out of grid, maze, geometric, road -- all by default
+//   -s  comma separated node counts -- 1000,10000,100000,1000000 by default, a case of 10000000 needs about 1GB
+//   -r  comma separated node orders out of none, hilbert, morton, bfs, rcm -- none,hilbert by default
+//   -q  queries per case -- by default 1000, fewer for the larger graphs so that each case takes seconds
+// every case runs in its own child process so its peak RSS is its own
+
+#include "bench_common.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#define MAX_DEGREE  32
+#define MAX_CASES   128
+
+typedef enum {
+    FamilyGrid,         // 8-connected open grid, costs 1 and sqrt(2)
+    FamilyMaze,         // 4-connected perfect maze carved into a grid, walls are nodes without edges
+    FamilyGeometric,    // random points at density 1, connected within GEOMETRIC_RADIUS
+    FamilyRoad,         // jittered 4-connected lattice with missing local roads and fast highways every 16 rows and columns
+    FamilyCount
+} family;
+
+static const char *familyNames[FamilyCount] = {"grid", "maze", "geometric", "road"};
+
+// "none" keeps the ids the families are built with, the others are ASGraphOrder + 1
+#define ORDER_COUNT 5
+static const char *orderNames[ORDER_COUNT] = {"none", "hilbert", "morton", "bfs", "rcm"};
+
+#define GEOMETRIC_RADIUS    1.3f
+#define HIGHWAY_SPACING     16
+#define HIGHWAY_SPEED       3.f
+
+typedef struct {
+    family kind;
+    uint32_t width;
+    uint32_t nodeCount;
+    float *positions;           // x and y of every node
+    uint8_t *open;              // maze cells that are not walls
+    uint8_t *roads;             // road: bit 0 and bit 1 are set if the road to the right and down is missing
+    uint32_t bucketWidth;       // geometric: points sorted into square buckets of GEOMETRIC_RADIUS
+    uint32_t *bucketOffsets;
+    uint32_t *bucketNodes;
+} graphSpec;
+
+typedef struct {
+    char family[16];
+    char order[8];
+    uint32_t nodes;
+    uint64_t edges;
+    uint32_t queries;
+    uint32_t unreachable;
+    double buildSeconds;
+    double reorderSeconds;
+    double p50, p90, p99, max;  // microseconds
+    double visitedPerSecond;
+    double expandedPerSecond;
+    double cacheMissesPerExpansion; // -1 if the counter is not available
+    double allocationsPerQuery; // -1 if allocations are not counted on this platform
+    long peakRSSKB;
+} caseResult;
+
+/********************************************/
+
+// allocation counting: glibc exports its allocator as __libc_*, so the benchmark can wrap malloc for itself and the library
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+static size_t allocationCount;
+
+void *malloc(size_t size) {
+    allocationCount++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    allocationCount++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) {
+    allocationCount++;
+    return __libc_realloc(pointer, size);
+}
+#define ALLOCATIONS_COUNTED 1
+#else
+static size_t allocationCount;
+#define ALLOCATIONS_COUNTED 0
+#endif
+
+// last level cache misses of this process, -1 where there is no counter (other systems, no PMU, perf_event_paranoid)
+#ifdef __linux__
+static int openCacheMissCounter(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void startCounter(int counter) {
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+static int64_t stopCounter(int counter) {
+    uint64_t count;
+    if (counter < 0) {
+        return -1;
+    }
+    ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+    return (read(counter, &count, sizeof(count)) == sizeof(count))? (int64_t)count : -1;
+}
+#else
+static int openCacheMissCounter(void) { return -1; }
+static void startCounter(int counter) {}
+static int64_t stopCounter(int counter) { return -1; }
+#endif
+
+static uint64_t rngState;
+
+static uint32_t random32(void) {
+    // xorshift, rand() is too short for ten million nodes
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return (uint32_t)(rngState >> 16);
+}
+
+static float randomUnit(void) {
+    return (random32() & 0xffffff) / 16777216.f;
+}
+
+static float distance(const graphSpec *spec, uint32_t a, uint32_t b) {
+    const float dx = spec->positions[2 * a] - spec->positions[2 * b];
+    const float dy = spec->positions[2 * a + 1] - spec->positions[2 * b + 1];
+    return sqrtf(dx * dx + dy * dy);
+}
+
+/********************************************/
+
+static size_t specNeighbors(const graphSpec *spec, uint32_t node, uint32_t *neighbors, float *costs) {
+    const int w = spec->width;
+    const int x = node % spec->width;
+    const int y = node / spec->width;
+    size_t count = 0;
+
+    if (spec->kind == FamilyGrid) {
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                const int nx = x + dx, ny = y + dy;
+                if ((dx || dy) && nx >= 0 && nx < w && ny >= 0 && ny < w) {
+                    neighbors[count] = ny * w + nx;
+                    costs[count++] = (dx && dy)? 1.41421356f : 1.f;
+                }
+            }
+        }
+    } else if (spec->kind == FamilyMaze) {
+        static const int steps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+        for (int i = 0; spec->open[node] && i < 4; i++) {
+            const int nx = x + steps[i][0], ny = y + steps[i][1];
+            if (nx >= 0 && nx < w && ny >= 0 && ny < w && spec->open[ny * w + nx]) {
+                neighbors[count] = ny * w + nx;
+                costs[count++] = 1.f;
+            }
+        }
+    } else if (spec->kind == FamilyRoad) {
+        static const int steps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+        for (int i = 0; i < 4; i++) {
+            const int nx = x + steps[i][0], ny = y + steps[i][1];
+            if (nx < 0 || nx >= w || ny < 0 || ny >= w) {
+                continue;
+            }
+            // the missing bits are stored on the left or upper end of a road
+            const uint32_t owner = (steps[i][0] < 0 || steps[i][1] < 0)? ny * w + nx : node;
+            if (spec->roads[owner] & (steps[i][1]? 2 : 1)) {
+                continue;
+            }
+            const int highway = steps[i][1]? (x % HIGHWAY_SPACING == 0) : (y % HIGHWAY_SPACING == 0);
+            neighbors[count] = ny * w + nx;
+            costs[count] = distance(spec, node, neighbors[count]) / (highway? HIGHWAY_SPEED : 1.f);
+            count++;
+        }
+    } else {
+        const float px = spec->positions[2 * node], py = spec->positions[2 * node + 1];
+        const int bx = (int)(px / GEOMETRIC_RADIUS), by = (int)(py / GEOMETRIC_RADIUS);
+        const int bw = spec->bucketWidth;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                const int nx = bx + dx, ny = by + dy;
+                if (nx < 0 || nx >= bw || ny < 0 || ny >= bw) {
+                    continue;
+                }
+                const uint32_t bucket = ny * bw + nx;
+                for (uint32_t i = spec->bucketOffsets[bucket]; i < spec->bucketOffsets[bucket + 1] && count < MAX_DEGREE; i++) {
+                    const uint32_t other = spec->bucketNodes[i];
+                    const float d = distance(spec, node, other);
+                    if (other != node && d <= GEOMETRIC_RADIUS) {
+                        neighbors[count] = other;
+                        costs[count++] = d;
+                    }
+                }
+            }
+        }
+    }
+
+    return count;
+}
+
+static void specNodeNeighbors(ASNeighborList neighbors, uint32_t node, float node_cost, uint32_t from_node, void *context) {
+    uint32_t nodes[MAX_DEGREE];
+    float costs[MAX_DEGREE];
+    const size_t count = specNeighbors((const graphSpec*)context, node, nodes, costs);
+
+    for (size_t i = 0; i < count; i++) {
+        ASNeighborListAddID(neighbors, nodes[i], costs[i]);
+    }
+}
+
+static void carveMaze(graphSpec *spec) {
+    // iterative depth first search over the cells at even coordinates, opening the wall cell between two cells it links
+    const uint32_t w = spec->width;
+    const uint32_t cells = (w + 1) / 2;
+    uint32_t *stack = malloc((size_t)cells * cells * sizeof(uint32_t));
+    size_t depth = 0;
+
+    spec->open[0] = 1;
+    stack[depth++] = 0;
+
+    while (depth > 0) {
+        const uint32_t cell = stack[depth - 1];
+        const uint32_t cx = cell % cells, cy = cell / cells;
+        uint32_t options[4];
+        int optionCount = 0;
+
+        if (cx > 0 && !spec->open[(2 * cy) * w + 2 * (cx - 1)]) options[optionCount++] = cell - 1;
+        if (cx + 1 < cells && !spec->open[(2 * cy) * w + 2 * (cx + 1)]) options[optionCount++] = cell + 1;
+        if (cy > 0 && !spec->open[(2 * (cy - 1)) * w + 2 * cx]) options[optionCount++] = cell - cells;
+        if (cy + 1 < cells && !spec->open[(2 * (cy + 1)) * w + 2 * cx]) options[optionCount++] = cell + cells;
+
+        if (optionCount == 0) {
+            depth--;
+            continue;
+        }
+
+        const uint32_t next = options[random32() % optionCount];
+        const uint32_t nx = next % cells, ny = next / cells;
+        spec->open[(2 * ny) * w + 2 * nx] = 1;
+        spec->open[(cy + ny) * w + cx + nx] = 1;
+        stack[depth++] = next;
+    }
+
+    free(stack);
+}
+
+static void specCreate(graphSpec *spec, family kind, uint32_t nodeCount) {
+    memset(spec, 0, sizeof(graphSpec));
+    spec->kind = kind;
+    spec->width = (uint32_t)ceil(sqrt((double)nodeCount));
+    spec->nodeCount = (kind == FamilyGeometric)? nodeCount : spec->width * spec->width;
+    spec->positions = malloc((size_t)spec->nodeCount * 2 * sizeof(float));
+
+    for (uint32_t i = 0; i < spec->nodeCount; i++) {
+        if (kind == FamilyGeometric) {
+            spec->positions[2 * i] = randomUnit() * spec->width;
+            spec->positions[2 * i + 1] = randomUnit() * spec->width;
+        } else if (kind == FamilyRoad) {
+            spec->positions[2 * i] = (i % spec->width) + 0.6f * (randomUnit() - 0.5f);
+            spec->positions[2 * i + 1] = (i / spec->width) + 0.6f * (randomUnit() - 0.5f);
+        } else {
+            spec->positions[2 * i] = (float)(i % spec->width);
+            spec->positions[2 * i + 1] = (float)(i / spec->width);
+        }
+    }
+
+    if (kind == FamilyMaze) {
+        spec->open = calloc(spec->nodeCount, 1);
+        carveMaze(spec);
+    } else if (kind == FamilyRoad) {
+        spec->roads = calloc(spec->nodeCount, 1);
+        for (uint32_t i = 0; i < spec->nodeCount; i++) {
+            const uint32_t x = i % spec->width, y = i / spec->width;
+            if (y % HIGHWAY_SPACING && random32() % 100 < 15) spec->roads[i] |= 1;
+            if (x % HIGHWAY_SPACING && random32() % 100 < 15) spec->roads[i] |= 2;
+        }
+    } else if (kind == FamilyGeometric) {
+        // counting sort of the points into their buckets
+        spec->bucketWidth = (uint32_t)(spec->width / GEOMETRIC_RADIUS) + 1;
+        const size_t bucketCount = (size_t)spec->bucketWidth * spec->bucketWidth;
+        spec->bucketOffsets = calloc(bucketCount + 1, sizeof(uint32_t));
+        spec->bucketNodes = malloc((size_t)spec->nodeCount * sizeof(uint32_t));
+        for (uint32_t i = 0; i < spec->nodeCount; i++) {
+            const uint32_t bucket = (uint32_t)(spec->positions[2 * i + 1] / GEOMETRIC_RADIUS) * spec->bucketWidth + (uint32_t)(spec->positions[2 * i] / GEOMETRIC_RADIUS);
+            spec->bucketOffsets[bucket + 1]++;
+        }
+        for (size_t b = 0; b < bucketCount; b++) {
+            spec->bucketOffsets[b + 1] += spec->bucketOffsets[b];
+        }
+        uint32_t *fill = malloc(bucketCount * sizeof(uint32_t));
+        memcpy(fill, spec->bucketOffsets, bucketCount * sizeof(uint32_t));
+        for (uint32_t i = 0; i < spec->nodeCount; i++) {
+            const uint32_t bucket = (uint32_t)(spec->positions[2 * i + 1] / GEOMETRIC_RADIUS) * spec->bucketWidth + (uint32_t)(spec->positions[2 * i] / GEOMETRIC_RADIUS);
+            spec->bucketNodes[fill[bucket]++] = i;
+        }
+        free(fill);
+    }
+}
+
+static void specDestroy(graphSpec *spec) {
+    free(spec->positions);
+    free(spec->open);
+    free(spec->roads);
+    free(spec->bucketOffsets);
+    free(spec->bucketNodes);
+}
+
+static uint32_t findRoot(uint32_t *parents, uint32_t node) {
+    while (parents[node] != node) {
+        parents[node] = parents[parents[node]];
+        node = parents[node];
+    }
+    return node;
+}
+
+static uint32_t *specComponents(const graphSpec *spec) {
+    // union-find over the edges, queries are drawn within one component so none of them searches the whole graph in vain
+    uint32_t *parents = malloc((size_t)spec->nodeCount * sizeof(uint32_t));
+    uint32_t neighbors[MAX_DEGREE];
+    float costs[MAX_DEGREE];
+
+    for (uint32_t i = 0; i < spec->nodeCount; i++) {
+        parents[i] = i;
+    }
+
+    for (uint32_t i = 0; i < spec->nodeCount; i++) {
+        const size_t count = specNeighbors(spec, i, neighbors, costs);
+        for (size_t n = 0; n < count; n++) {
+            const uint32_t a = findRoot(parents, i), b = findRoot(parents, neighbors[n]);
+            if (a != b) {
+                parents[a] = b;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < spec->nodeCount; i++) {
+        parents[i] = findRoot(parents, i);
+    }
+
+    return parents;
+}
+
+/********************************************/
+
+static int compareDoubles(const void *a, const void *b) {
+    const double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, size_t count, double p) {
+    // nearest rank
+    size_t rank = (size_t)ceil(p * count);
+    return sorted[rank > 0? rank - 1 : 0];
+}
+
+static void runCase(family kind, uint32_t nodeCount, int order, uint32_t queries, caseResult *result) {
+    graphSpec spec;
+    rngState = 0x9e3779b97f4a7c15ULL ^ ((uint64_t)kind << 32) ^ nodeCount;
+
+    double begin = now();
+    specCreate(&spec, kind, nodeCount);
+    const ASPathNodeIDSource source = {spec.nodeCount, &specNodeNeighbors, NULL, NULL, NULL};
+    ASGraph graph = ASGraphCreateWithNodeIDSource(&source, &spec);
+    ASGraphSetPositions(graph, spec.positions, kind == FamilyMaze? ASGraphHeuristicManhattan : ASGraphHeuristicEuclidean, kind == FamilyRoad? 1 / HIGHWAY_SPEED : 1);
+    const double buildSeconds = now() - begin;
+
+    begin = now();
+    if (order > 0) {
+        ASGraphReorder(graph, (ASGraphOrder)(order - 1));
+    }
+    const double reorderSeconds = now() - begin;
+
+    uint32_t *components = specComponents(&spec);
+    uint32_t *starts = malloc(queries * sizeof(uint32_t));
+    uint32_t *goals = malloc(queries * sizeof(uint32_t));
+    double *latencies = malloc(queries * sizeof(double));
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    ASSearchStats stats;
+    const ASSearchOptions options = {.stats = &stats};
+    const int cacheMisses = openCacheMissCounter();
+    size_t visited = 0, expanded = 0;
+    uint32_t unreachable = 0;
+
+    ASSearchWorkspaceSetOptions(workspace, &options);
+
+    for (uint32_t q = 0; q < queries; q++) {
+        // a start with edges, and a goal in its component if one turns up within a few tries
+        do { starts[q] = random32() % spec.nodeCount; } while (kind == FamilyMaze && !spec.open[starts[q]]);
+        for (int tries = 0; tries < 1000; tries++) {
+            goals[q] = random32() % spec.nodeCount;
+            if (components[goals[q]] == components[starts[q]] && goals[q] != starts[q]) {
+                break;
+            }
+        }
+    }
+
+    // the queries are drawn by the ids of the spec, which a reordered graph translates
+    for (uint32_t q = 0; q < queries; q++) {
+        starts[q] = ASGraphGetNodeIDFromOriginal(graph, starts[q]);
+        goals[q] = ASGraphGetNodeIDFromOriginal(graph, goals[q]);
+    }
+
+    // one query to warm the workspace up, its buffers then stay at their high-water size
+    ASPathDestroy(ASPathCreateWithGraph(workspace, graph, starts[0], goals[0]));
+
+    const size_t allocationsBefore = allocationCount;
+    const double queriesBegin = now();
+    startCounter(cacheMisses);
+
+    for (uint32_t q = 0; q < queries; q++) {
+        const double queryBegin = now();
+        ASPath path = ASPathCreateWithGraph(workspace, graph, starts[q], goals[q]);
+        latencies[q] = now() - queryBegin;
+        visited += ASSearchWorkspaceGetVisitedCount(workspace);
+        expanded += stats.expanded;
+        unreachable += !path;
+        ASPathDestroy(path);
+    }
+
+    const int64_t misses = stopCounter(cacheMisses);
+    const double queriesSeconds = now() - queriesBegin;
+    const size_t allocations = allocationCount - allocationsBefore;
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    qsort(latencies, queries, sizeof(double), &compareDoubles);
+    memset(result, 0, sizeof(caseResult));
+    snprintf(result->family, sizeof(result->family), "%s", familyNames[kind]);
+    snprintf(result->order, sizeof(result->order), "%s", orderNames[order]);
+    result->nodes = spec.nodeCount;
+    result->edges = ASGraphGetEdgeCount(graph);
+    result->queries = queries;
+    result->unreachable = unreachable;
+    result->buildSeconds = buildSeconds;
+    result->reorderSeconds = reorderSeconds;
+    result->p50 = 1e6 * percentile(latencies, queries, 0.50);
+    result->p90 = 1e6 * percentile(latencies, queries, 0.90);
+    result->p99 = 1e6 * percentile(latencies, queries, 0.99);
+    result->max = 1e6 * latencies[queries - 1];
+    result->visitedPerSecond = visited / queriesSeconds;
+    result->expandedPerSecond = expanded / queriesSeconds;
+    result->cacheMissesPerExpansion = (misses >= 0 && expanded > 0)? (double)misses / expanded : -1;
+    result->allocationsPerQuery = ALLOCATIONS_COUNTED? (double)allocations / queries : -1;
+    result->peakRSSKB = usage.ru_maxrss;    // kilobytes on Linux, bytes on macOS
+
+    if (cacheMisses >= 0) {
+        close(cacheMisses);
+    }
+    ASSearchWorkspaceDestroy(workspace);
+    ASGraphDestroy(graph);
+    free(latencies);
+    free(goals);
+    free(starts);
+    free(components);
+    specDestroy(&spec);
+}
+
+static int runCaseInChild(family kind, uint32_t nodeCount, int order, uint32_t queries, caseResult *result) {
+    // a fresh process per case, so the peak RSS and the allocator state of one case do not carry over into the next
+    int pipeEnds[2];
+    if (pipe(pipeEnds) != 0) {
+        return -1;
+    }
+
+    fflush(stdout);
+    const pid_t child = fork();
+    if (child == 0) {
+        close(pipeEnds[0]);
+        runCase(kind, nodeCount, order, queries, result);
+        const ssize_t written = write(pipeEnds[1], result, sizeof(caseResult));
+        _exit(written == sizeof(caseResult)? 0 : 1);
+    }
+
+    close(pipeEnds[1]);
+    const ssize_t received = (child > 0)? read(pipeEnds[0], result, sizeof(caseResult)) : -1;
+    close(pipeEnds[0]);
+    if (child > 0) {
+        waitpid(child, NULL, 0);
+    }
+
+    return (received == sizeof(caseResult))? 0 : -1;
+}
+
+static void writeJSON(FILE *file, const caseResult *results, size_t count) {
+    fprintf(file, "{\n  \"suite\": \"fast_astar\",\n  \"format\": 2,\n  \"allocations_counted\": %s,\n  \"cases\": [\n", ALLOCATIONS_COUNTED? "true" : "false");
+    for (size_t i = 0; i < count; i++) {
+        const caseResult *r = &results[i];
+        fprintf(file, "    {\"family\": \"%s\", \"order\": \"%s\", \"nodes\": %u, \"edges\": %llu, \"queries\": %u, \"unreachable\": %u, "
+                "\"build_seconds\": %.6f, \"reorder_seconds\": %.6f, \"p50_us\": %.3f, \"p90_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f, "
+                "\"visited_per_second\": %.0f, \"expanded_per_second\": %.0f, \"cache_misses_per_expansion\": %.3f, \"allocations_per_query\": %.3f, \"peak_rss_kb\": %ld}%s\n",
+                r->family, r->order, r->nodes, (unsigned long long)r->edges, r->queries, r->unreachable,
+                r->buildSeconds, r->reorderSeconds, r->p50, r->p90, r->p99, r->max,
+                r->visitedPerSecond, r->expandedPerSecond, r->cacheMissesPerExpansion, r->allocationsPerQuery, r->peakRSSKB, (i + 1 < count)? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+    const char *familyList = "grid,maze,geometric,road";
+    const char *sizeList = "1000,10000,100000,1000000";
+    const char *orderList = "none,hilbert";
+    const char *outputPath = NULL;
+    long queryOption = 0;
+    int option;
+
+    while ((option = getopt(argc, argv, "f:s:r:q:o:")) != -1) {
+        switch (option) {
+            case 'f': familyList = optarg; break;
+            case 's': sizeList = optarg; break;
+            case 'r': orderList = optarg; break;
+            case 'q': queryOption = atol(optarg); break;
+            case 'o': outputPath = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-f grid,maze,geometric,road] [-s 1000,10000,...] [-r none,hilbert,morton,bfs,rcm] [-q queries] [-o results.json]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    caseResult results[MAX_CASES];
+    size_t resultCount = 0;
+
+    printf("%-10s %-8s %9s %10s %7s %8s %10s %10s %10s %10s %12s %12s %9s %8s %9s\n", "family", "order", "nodes", "edges", "queries", "build s", "p50 us", "p90 us", "p99 us", "max us", "visited/s", "expanded/s", "miss/exp", "allocs/q", "RSS MB");
+
+    for (int kind = 0; kind < FamilyCount; kind++) {
+        if (!strstr(familyList, familyNames[kind])) {
+            continue;
+        }
+
+        for (const char *size = sizeList; *size && resultCount < MAX_CASES; ) {
+            const long nodeCount = atol(size);
+            // queries scale down with the graph so every case takes seconds rather than minutes
+            const uint32_t queries = queryOption > 0? (uint32_t)queryOption : (nodeCount > 1000000? 20 : nodeCount > 100000? 100 : 1000);
+
+            for (int order = 0; order < ORDER_COUNT && resultCount < MAX_CASES; order++) {
+                caseResult *r = &results[resultCount];
+                char misses[16] = "n/a";
+
+                if (!strstr(orderList, orderNames[order])) {
+                    continue;
+                }
+
+                if (nodeCount > 1 && runCaseInChild(kind, (uint32_t)nodeCount, order, queries, r) == 0) {
+                    if (r->cacheMissesPerExpansion >= 0) {
+                        snprintf(misses, sizeof(misses), "%.2f", r->cacheMissesPerExpansion);
+                    }
+                    printf("%-10s %-8s %9u %10llu %7u %8.2f %10.1f %10.1f %10.1f %10.1f %12.0f %12.0f %9s %8.2f %9.1f\n", r->family, r->order, r->nodes, (unsigned long long)r->edges, r->queries,
+                           r->buildSeconds + r->reorderSeconds, r->p50, r->p90, r->p99, r->max, r->visitedPerSecond, r->expandedPerSecond, misses, r->allocationsPerQuery, r->peakRSSKB / 1024.0);
+                    resultCount++;
+                } else {
+                    fprintf(stderr, "%s with %ld nodes in %s order failed\n", familyNames[kind], nodeCount, orderNames[order]);
+                }
+            }
+
+            size = strchr(size, ',');
+            size = size? size + 1 : "";
+        }
+    }
+
+    if (outputPath) {
+        FILE *file = fopen(outputPath, "w");
+        if (!file) {
+            fprintf(stderr, "could not write %s\n", outputPath);
+            return 1;
+        }
+        writeJSON(file, results, resultCount);
+        fclose(file);
+    }
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Template engine benchmark: the same 8-connected grid queries through the C API (callbacks through function pointers, a
+// neighbor list in between) and through astar::Search from AStar.hpp (callbacks inlined into the search loop), once with
+// dense node ids (ASPathCreateWithNodeIDs()) and once with (x, y) struct nodes behind a hash index (ASPathCreateWithWorkspace()).
+// Both run the same algorithm, so the costs and the visited counts must match exactly. Reports the time per query of each.
+
+#include "bench_common.h"
+#include "AStar.hpp"
+#include <cstdio>
+#include <vector>
+
+#define WIDTH   1024
+#define QUERIES 200
+
+static std::vector<uint8_t> blocked;
+static benchGrid grid = {WIDTH, NULL, NULL, 1, 1};
+
+struct Cell {
+    int32_t x, y;
+    bool operator==(const Cell &other) const { return x == other.x && y == other.y; }
+};
+
+// the same callbacks as traits
+
+struct IDTraits {
+    uint32_t nodeCount() const { return WIDTH * WIDTH; }
+
+    template <class Add>
+    void neighbors(uint32_t node, float nodeCost, uint32_t fromNode, Add &&add) const {
+        const int x = node % WIDTH, y = node / WIDTH;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                if (canStep(&grid, x, y, dx, dy)) {
+                    add((uint32_t)((y + dy) * WIDTH + x + dx), stepCost(&grid, x, y, dx, dy));
+                }
+            }
+        }
+    }
+
+    float heuristic(uint32_t fromNode, uint32_t toNode) const {
+        return gridDistance(&grid, fromNode % WIDTH, fromNode / WIDTH, toNode % WIDTH, toNode / WIDTH);
+    }
+};
+
+struct CellTraits {
+    struct Hash {
+        size_t operator()(const Cell &cell) const { return (size_t)cell.y * WIDTH + cell.x; }
+    };
+
+    template <class Add>
+    void neighbors(const Cell &cell, float nodeCost, const Cell &fromNode, Add &&add) const {
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                if (canStep(&grid, cell.x, cell.y, dx, dy)) {
+                    add(Cell{cell.x + dx, cell.y + dy}, stepCost(&grid, cell.x, cell.y, dx, dy));
+                }
+            }
+        }
+    }
+
+    float heuristic(const Cell &from, const Cell &to) const {
+        return gridDistance(&grid, from.x, from.y, to.x, to.y);
+    }
+};
+
+int main(int argc, char **argv) {
+    const uint32_t nodeCount = WIDTH * WIDTH;
+    std::vector<uint32_t> starts(QUERIES), goals(QUERIES);
+    std::vector<float> costs(QUERIES);
+    std::vector<size_t> visited(QUERIES);
+    size_t mismatches = 0;
+    srand(1);
+
+    blocked.resize(nodeCount);
+    grid.blocked = blocked.data();
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        blocked[i] = (rand() % 100) < 25;
+    }
+    for (int q = 0; q < QUERIES; q++) {
+        do { starts[q] = rand() % nodeCount; } while (blocked[starts[q]]);
+        do { goals[q] = rand() % nodeCount; } while (blocked[goals[q]]);
+    }
+
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    const ASPathNodeIDSource idSource = {nodeCount, &cellNeighbors, &cellHeuristic, NULL, NULL};
+    const ASPathNodeSource cellSource = {sizeof(benchCell), &cellNodeNeighbors, &cellNodeHeuristic, NULL, NULL, &cellHash};
+    astar::Search<uint32_t, IDTraits> idSearch;
+    astar::Search<Cell, CellTraits> cellSearch;
+    astar::Path<uint32_t> idPath;
+    astar::Path<Cell> cellPath;
+    double times[4] = {0};
+
+    // node ids, C then template
+    double begin = now();
+    for (int q = 0; q < QUERIES; q++) {
+        ASPath path = ASPathCreateWithNodeIDs(workspace, &idSource, &grid, starts[q], goals[q]);
+        costs[q] = path? ASPathGetCost(path, ASPathGetCount(path) - 1) : INFINITY;
+        visited[q] = ASSearchWorkspaceGetVisitedCount(workspace);
+        ASPathDestroy(path);
+    }
+    times[0] = now() - begin;
+
+    begin = now();
+    for (int q = 0; q < QUERIES; q++) {
+        idSearch.find(starts[q], goals[q], idPath);
+        mismatches += (idPath.cost() != costs[q] || idSearch.visitedCount() != visited[q]);
+    }
+    times[1] = now() - begin;
+
+    // struct nodes, C then template
+    begin = now();
+    for (int q = 0; q < QUERIES; q++) {
+        benchCell start = {(int32_t)(starts[q] % WIDTH), (int32_t)(starts[q] / WIDTH)};
+        benchCell goal = {(int32_t)(goals[q] % WIDTH), (int32_t)(goals[q] / WIDTH)};
+        ASPath path = ASPathCreateWithWorkspace(workspace, &cellSource, &grid, &start, &goal);
+        mismatches += ((path? ASPathGetCost(path, ASPathGetCount(path) - 1) : INFINITY) != costs[q]);
+        ASPathDestroy(path);
+    }
+    times[2] = now() - begin;
+
+    begin = now();
+    for (int q = 0; q < QUERIES; q++) {
+        cellSearch.find(Cell{(int32_t)(starts[q] % WIDTH), (int32_t)(starts[q] / WIDTH)}, Cell{(int32_t)(goals[q] % WIDTH), (int32_t)(goals[q] / WIDTH)}, cellPath);
+        mismatches += (cellPath.cost() != costs[q] || cellSearch.visitedCount() != visited[q]);
+    }
+    times[3] = now() - begin;
+
+    printf("%dx%d grid, %d queries, %zu mismatches\n", WIDTH, WIDTH, QUERIES, mismatches);
+    printf("  node ids      C %9.1fus  template %9.1fus  %.2fx\n", 1e6 * times[0] / QUERIES, 1e6 * times[1] / QUERIES, times[0] / times[1]);
+    printf("  struct nodes  C %9.1fus  template %9.1fus  %.2fx\n", 1e6 * times[2] / QUERIES, 1e6 * times[3] / QUERIES, times[2] / times[3]);
+
+    ASSearchWorkspaceDestroy(workspace);
+    return 0;
+}
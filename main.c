@@ -25,6 +25,7 @@ typedef struct Context {
     float v;
     float w;
     float timestamp;
+    node **graph;
 } Context;
 
 static float manhetten_dist(float x1, float y1, float x2, float y2) {
@@ -86,30 +87,34 @@ static float neighborCost(void *srcNode, void *dstNode, void *fromsrcNode, void
     return euclidian_dist(src->x, src->y, dst->x, dst->y)/c->v + k;
 }
 
-static void nodeNeighbors(ASNeighborList neighbors, void* srcNode, float srcNode_cost, void* fromsrcNode, void* context) {
-    node* src = (node*)srcNode;
+static void nodeNeighbors(ASNeighborList neighbors, uint32_t srcNode, float srcNode_cost, uint32_t fromsrcNode, void* context) {
     Context *ctx = (Context *)context;
+    node* src = ctx->graph[srcNode];
 
     int i;
     for (i = 0; i < src->neighbors_count; i++) {
         // check if node collision by time (cost) with existing paths (get from context)
         if (src->neighbors[i]) {
-            float neighbor_cost = neighborCost(srcNode, (void*)(src->neighbors[i]), fromsrcNode,  context);
+            float neighbor_cost = neighborCost(src, (void*)(src->neighbors[i]), ctx->graph[fromsrcNode],  context);
             
             // get cost for all robots path in src->neighbors[i] node
             
             //if ((ctx->timestamp + srcNode_cost + neighbor_cost) is not equal for x/y and cost for all robots
             
-            ASNeighborListAdd(neighbors, (void*)src->neighbors[i], neighbor_cost);
+            ASNeighborListAddID(neighbors, src->neighbors[i]->index, neighbor_cost);
         }
     }
 }
 
-static const ASPathNodeSource pathSource = {
-    sizeof(node), 
+static float nodeHopCost(uint32_t srcNode, uint32_t dstNode, void *context) {
+    Context *ctx = (Context *)context;
+    return hopCost(ctx->graph[srcNode], ctx->graph[dstNode], context);
+}
+
+static const ASPathNodeIDSource pathSource = {
+    MAX_NODES,
     &nodeNeighbors,
-    &hopCost,
-    NULL,
+    &nodeHopCost,
     NULL
 };
 
@@ -144,34 +149,34 @@ int main(int argc, char** argv) {
     context.v = 2.0;
     context.w = 1.0;
     context.timestamp = clock() / CLOCKS_PER_SEC;
+    context.graph = graph;
 
-    clock_t begin = clock();
+    // optional first argument: number of search threads, all cores by default
+    ASSearchPool pool = ASSearchPoolCreate(argc > 1 ? atoi(argv[1]) : 0);
+    ASBatchOptions batchOptions = {pool, 0, NULL};
+    uint32_t starts[MAX_NODES], goals[MAX_NODES];
+    ASPath paths[MAX_NODES];
 
-    i = 0;
-    j = 1023;
-    float cost;
+    // timing lives in benchmarks/suite_bench.c, this only runs the workload and sums up the paths
+    size_t found = 0;
+    double totalCost = 0;
     for (i = 0; i < MAX_NODES; i++) {
-        printf("Processing... %d%\n", 100*i/MAX_NODES);
         for (j = 0; j < MAX_NODES; j++) {
-
-                ASPath path = ASPathCreate(&pathSource, (void*)(&context), graph[i], graph[j]);
-                ASPath path_ = ASPathCopy(path);
-                hopCount = ASPathGetCount(path_);
-                cost = ASPathGetCost(path_, hopCount);
-                for (int ind=0; ind<hopCount; ind++) {
-                    cost = ASPathGetCost(path_, ind);
-                    node *n = (node*)ASPathGetNode(path_, ind);
-                    //printf("index %ld: x=%f y=%f cost=%f neighbors=%ld\n", n->index, n->x, n->y, cost, n->neighbors_count);
+            starts[j] = i;
+            goals[j] = j;
+        }
+        ASPathCreateBatchWithNodeIDs(&pathSource, (void*)(&context), starts, goals, MAX_NODES, paths, &batchOptions);
+        for (j = 0; j < MAX_NODES; j++) {
+                ASPath path = paths[j];
+                hopCount = ASPathGetCount(path);
+                if (hopCount > 0) {
+                    found++;
+                    totalCost += ASPathGetCost(path, hopCount - 1);
                 }
                 ASPathDestroy(path);
-                ASPathDestroy(path_);
         }
-        system("clear");
     }
-    clock_t end = clock();
-    double time_spent = (double)(end - begin) / CLOCKS_PER_SEC;
-    //time_spent /= MAX_NODES*MAX_NODES;
-    //printf("path from %d to %d: cost=%f, hopCount=%d\n", i, j, cost, hopCount);
-    printf("Processing time: %f (avg: %f)\n", time_spent, time_spent/(MAX_NODES*MAX_NODES));
+    ASSearchPoolDestroy(pool);
+    printf("%zu paths, total cost %f\n", found, totalCost);
     return 0;
 }
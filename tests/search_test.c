@@ -0,0 +1,426 @@
+// Regression tests: runs the search variants on random inputs and checks every path against a plain Dijkstra over the same edges.
+// A path must exist exactly when Dijkstra reaches the goal, start and end at the query's nodes, cost what Dijkstra found and take the
+// cheapest edge between every pair of consecutive nodes. The graphs have parallel edges, self loops, one-way edges and nodes that
+// can't be reached.
+//
+// usage: search_test [case]   -- runs every case if none is given, returns nonzero if any check failed
+
+#include "AStar.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef struct {
+    uint32_t nodeCount;
+    size_t edgeCount;
+    ASGraphEdge *edges;         // sorted by from node
+    size_t *firstOut;           // nodeCount + 1 offsets into edges
+    size_t *inEdges;            // indexes into edges, sorted by to node
+    size_t *firstIn;            // nodeCount + 1 offsets into inEdges
+    float *positions;           // x, y of every node, no edge costs less than the distance between its ends
+} testGraph;
+
+static size_t failures;
+
+static void fail(const char *test, const char *what, uint32_t start, uint32_t goal) {
+    if (failures++ < 20) {
+        printf("%s: %s from %u to %u\n", test, what, start, goal);
+    }
+}
+
+static float distance(const float *positions, uint32_t a, uint32_t b) {
+    const float dx = positions[2 * a] - positions[2 * b];
+    const float dy = positions[2 * a + 1] - positions[2 * b + 1];
+    return sqrtf(dx * dx + dy * dy);
+}
+
+static testGraph graphCreate(uint32_t nodeCount, const ASGraphEdge *edges, size_t edgeCount, const float *positions) {
+    testGraph graph = {nodeCount, edgeCount};
+    graph.edges = malloc((edgeCount + 1) * sizeof(ASGraphEdge));
+    graph.inEdges = malloc((edgeCount + 1) * sizeof(size_t));
+    graph.firstOut = calloc(nodeCount + 1, sizeof(size_t));
+    graph.firstIn = calloc(nodeCount + 1, sizeof(size_t));
+    graph.positions = malloc(2 * nodeCount * sizeof(float));
+    memcpy(graph.positions, positions, 2 * nodeCount * sizeof(float));
+
+    // counting sort by from node, then the indexes by to node
+    size_t *outCursor = calloc(nodeCount + 1, sizeof(size_t));
+    size_t *inCursor = calloc(nodeCount + 1, sizeof(size_t));
+    for (size_t i = 0; i < edgeCount; i++) {
+        graph.firstOut[edges[i].from + 1]++;
+        graph.firstIn[edges[i].to + 1]++;
+    }
+    for (uint32_t n = 0; n < nodeCount; n++) {
+        graph.firstOut[n + 1] += graph.firstOut[n];
+        graph.firstIn[n + 1] += graph.firstIn[n];
+    }
+    memcpy(outCursor, graph.firstOut, (nodeCount + 1) * sizeof(size_t));
+    memcpy(inCursor, graph.firstIn, (nodeCount + 1) * sizeof(size_t));
+    for (size_t i = 0; i < edgeCount; i++) {
+        graph.edges[outCursor[edges[i].from]++] = edges[i];
+    }
+    for (size_t i = 0; i < edgeCount; i++) {
+        graph.inEdges[inCursor[graph.edges[i].to]++] = i;
+    }
+    free(outCursor);
+    free(inCursor);
+    return graph;
+}
+
+static void graphDestroy(testGraph *graph) {
+    free(graph->edges);
+    free(graph->inEdges);
+    free(graph->firstOut);
+    free(graph->firstIn);
+    free(graph->positions);
+}
+
+// up to 200 nodes on a 100x100 square, with edges to nearby nodes, a quarter of them doubled with another cost
+// some nodes get no edges, and undirected graphs hold every edge in both directions
+static testGraph randomGraph(int undirected) {
+    const uint32_t nodeCount = 1 + rand() % 200;
+    const size_t edgeCount = rand() % (4 * nodeCount + 1);
+    float *positions = malloc(2 * nodeCount * sizeof(float));
+    ASGraphEdge *edges = malloc(4 * (edgeCount + 1) * sizeof(ASGraphEdge));
+    size_t count = 0;
+
+    for (uint32_t n = 0; n < 2 * nodeCount; n++) {
+        positions[n] = (float)(rand() % 100);
+    }
+    for (size_t i = 0; i < edgeCount; i++) {
+        const uint32_t from = rand() % nodeCount;
+        uint32_t to = rand() % nodeCount;
+        for (int tries = 0; tries < 8 && distance(positions, from, to) > 20; tries++) {
+            to = rand() % nodeCount;
+        }
+        if (from % 16 == 15 || to % 16 == 15) {
+            continue;
+        }
+
+        const int copies = rand() % 4? 1 : 2;
+        for (int c = 0; c < copies; c++) {
+            const float cost = distance(positions, from, to) * (1 + (rand() % 100) / 50.f) + (rand() % 10) / 10.f;
+            edges[count++] = (ASGraphEdge){from, to, cost};
+            if (undirected) {
+                edges[count++] = (ASGraphEdge){to, from, cost};
+            }
+        }
+    }
+
+    testGraph graph = graphCreate(nodeCount, edges, count, positions);
+    free(positions);
+    free(edges);
+    return graph;
+}
+
+// the cost of the cheapest path from start to every node, INFINITY where there is none
+static void dijkstra(const testGraph *graph, uint32_t start, float *costs) {
+    uint8_t *done = calloc(graph->nodeCount, 1);
+    for (uint32_t n = 0; n < graph->nodeCount; n++) {
+        costs[n] = INFINITY;
+    }
+    costs[start] = 0;
+
+    for (;;) {
+        uint32_t best = ASNodeIDNull;
+        for (uint32_t n = 0; n < graph->nodeCount; n++) {
+            if (!done[n] && costs[n] < INFINITY && (best == ASNodeIDNull || costs[n] < costs[best])) {
+                best = n;
+            }
+        }
+        if (best == ASNodeIDNull) {
+            break;
+        }
+        done[best] = 1;
+        for (size_t i = graph->firstOut[best]; i < graph->firstOut[best + 1]; i++) {
+            const ASGraphEdge *edge = &graph->edges[i];
+            if (costs[best] + edge->cost < costs[edge->to]) {
+                costs[edge->to] = costs[best] + edge->cost;
+            }
+        }
+    }
+    free(done);
+}
+
+static void checkPath(const char *test, const testGraph *graph, ASPath path, uint32_t start, uint32_t goal, float expected) {
+    if (!path) {
+        if (expected < INFINITY) {
+            fail(test, "no path", start, goal);
+        }
+        return;
+    }
+    if (expected == INFINITY) {
+        fail(test, "path to an unreachable goal", start, goal);
+        return;
+    }
+
+    const size_t count = ASPathGetCount(path);
+    if (count == 0 || ASPathGetNodeID(path, 0) != start || ASPathGetNodeID(path, count - 1) != goal) {
+        fail(test, "path with the wrong ends", start, goal);
+        return;
+    }
+    if (fabsf(ASPathGetCost(path, count - 1) - expected) > 1e-3f * (1 + expected)) {
+        fail(test, "path of the wrong cost", start, goal);
+        return;
+    }
+    for (size_t i = 1; i < count; i++) {
+        const uint32_t from = ASPathGetNodeID(path, i - 1);
+        const uint32_t to = ASPathGetNodeID(path, i);
+        float cheapest = INFINITY;
+        for (size_t e = graph->firstOut[from]; e < graph->firstOut[from + 1]; e++) {
+            if (graph->edges[e].to == to && graph->edges[e].cost < cheapest) {
+                cheapest = graph->edges[e].cost;
+            }
+        }
+        if (fabsf(ASPathGetCost(path, i) - ASPathGetCost(path, i - 1) - cheapest) > 1e-3f * (1 + cheapest)) {
+            fail(test, "step that is not the cheapest edge", start, goal);
+            return;
+        }
+    }
+}
+
+// node id callbacks, the context is the testGraph -- edges of infinite cost were removed
+
+static void graphNeighbors(ASNeighborList neighbors, uint32_t node, float node_cost, uint32_t from_node, void *context) {
+    const testGraph *graph = (const testGraph *)context;
+    for (size_t i = graph->firstOut[node]; i < graph->firstOut[node + 1]; i++) {
+        if (graph->edges[i].cost < INFINITY) {
+            ASNeighborListAddID(neighbors, graph->edges[i].to, graph->edges[i].cost);
+        }
+    }
+}
+
+static void graphReverseNeighbors(ASNeighborList neighbors, uint32_t node, float node_cost, uint32_t from_node, void *context) {
+    const testGraph *graph = (const testGraph *)context;
+    for (size_t i = graph->firstIn[node]; i < graph->firstIn[node + 1]; i++) {
+        const ASGraphEdge *edge = &graph->edges[graph->inEdges[i]];
+        if (edge->cost < INFINITY) {
+            ASNeighborListAddID(neighbors, edge->from, edge->cost);
+        }
+    }
+}
+
+static float graphHeuristic(uint32_t fromNode, uint32_t toNode, void *context) {
+    return distance(((const testGraph *)context)->positions, fromNode, toNode);
+}
+
+static void testBidirectional(void) {
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+    const ASSearchOptions options = {.bidirectional = 1};
+    ASSearchWorkspaceSetOptions(workspace, &options);
+
+    for (int trial = 0; trial < 200; trial++) {
+        // directed graphs give the backward half the incoming edges, undirected ones leave it to walk the outgoing edges
+        const int undirected = trial % 3 == 0;
+        const int heuristic = trial % 2;
+        testGraph graph = randomGraph(undirected);
+        const ASPathNodeIDSource source = {graph.nodeCount, &graphNeighbors, heuristic? &graphHeuristic : NULL, NULL, undirected? NULL : &graphReverseNeighbors};
+        ASGraph compiled = ASGraphCreateWithEdges(graph.nodeCount, graph.edges, graph.edgeCount);
+        float *costs = malloc(graph.nodeCount * sizeof(float));
+
+        if (!undirected) {
+            ASGraphBuildReverseEdges(compiled);
+        }
+        if (heuristic) {
+            ASGraphSetPositions(compiled, graph.positions, ASGraphHeuristicEuclidean, 1);
+        }
+
+        for (int s = 0; s < 4; s++) {
+            const uint32_t start = rand() % graph.nodeCount;
+            dijkstra(&graph, start, costs);
+            for (int q = 0; q < 16; q++) {
+                const uint32_t goal = q? rand() % graph.nodeCount : start;
+                ASPath path = ASPathCreateWithNodeIDs(workspace, &source, &graph, start, goal);
+                checkPath("bidirectional ids", &graph, path, start, goal, costs[goal]);
+                ASPathDestroy(path);
+
+                path = ASPathCreateWithGraph(workspace, compiled, start, goal);
+                checkPath("bidirectional graph", &graph, path, start, goal, costs[goal]);
+                ASPathDestroy(path);
+            }
+        }
+
+        free(costs);
+        ASGraphDestroy(compiled);
+        graphDestroy(&graph);
+    }
+
+    ASSearchWorkspaceDestroy(workspace);
+}
+
+static void testContractionHierarchy(void) {
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+
+    for (int trial = 0; trial < 100; trial++) {
+        testGraph graph = randomGraph(trial % 3 == 0);
+        ASGraph compiled = ASGraphCreateWithEdges(graph.nodeCount, graph.edges, graph.edgeCount);
+        ASContractionHierarchy hierarchy = ASContractionHierarchyCreate(compiled);
+        float *costs = malloc(graph.nodeCount * sizeof(float));
+
+        // the hierarchy keeps its own copy of the edges
+        ASGraphDestroy(compiled);
+
+        for (int s = 0; s < 4; s++) {
+            const uint32_t start = rand() % graph.nodeCount;
+            dijkstra(&graph, start, costs);
+            for (int q = 0; q < 16; q++) {
+                const uint32_t goal = q? rand() % graph.nodeCount : start;
+                ASPath path = ASPathCreateWithContractionHierarchy(workspace, hierarchy, start, goal);
+                checkPath("contraction hierarchy", &graph, path, start, goal, costs[goal]);
+                ASPathDestroy(path);
+            }
+        }
+
+        free(costs);
+        ASContractionHierarchyDestroy(hierarchy);
+        graphDestroy(&graph);
+    }
+
+    ASSearchWorkspaceDestroy(workspace);
+}
+
+// the graph of the moves ASGridCreate() allows, no diagonal step may cut the corner of a blocked cell
+static testGraph gridGraph(uint32_t width, uint32_t height, const uint8_t *blocked, int diagonals) {
+    const uint32_t nodeCount = width * height;
+    float *positions = malloc(2 * nodeCount * sizeof(float));
+    ASGraphEdge *edges = malloc(8 * nodeCount * sizeof(ASGraphEdge));
+    size_t count = 0;
+
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            positions[2 * (y * width + x)] = (float)x;
+            positions[2 * (y * width + x) + 1] = (float)y;
+            if (blocked[y * width + x]) {
+                continue;
+            }
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    const int nx = x + dx, ny = y + dy;
+                    if ((!dx && !dy) || nx < 0 || nx >= (int)width || ny < 0 || ny >= (int)height || blocked[ny * width + nx]) {
+                        continue;
+                    }
+                    if (dx && dy && (!diagonals || blocked[y * width + nx] || blocked[ny * width + x])) {
+                        continue;
+                    }
+                    edges[count++] = (ASGraphEdge){y * width + x, ny * width + nx, (dx && dy)? (float)M_SQRT2 : 1.f};
+                }
+            }
+        }
+    }
+
+    testGraph graph = graphCreate(nodeCount, edges, count, positions);
+    free(positions);
+    free(edges);
+    return graph;
+}
+
+static void testJumpPointSearch(void) {
+    ASSearchWorkspace workspace = ASSearchWorkspaceCreate();
+
+    for (int trial = 0; trial < 200; trial++) {
+        const uint32_t width = 1 + rand() % 48;
+        const uint32_t height = 1 + rand() % 48;
+        const int diagonals = trial % 2;
+        const int density = rand() % 45;
+        uint8_t *blocked = malloc(width * height);
+        for (uint32_t i = 0; i < width * height; i++) {
+            blocked[i] = rand() % 100 < density;
+        }
+
+        testGraph graph = gridGraph(width, height, blocked, diagonals);
+        ASGrid grid = ASGridCreate(width, height, blocked, diagonals? ASGridEightConnected : ASGridFourConnected);
+        ASGrid jumpTableGrid = ASGridCreate(width, height, blocked, diagonals? ASGridEightConnected : ASGridFourConnected);
+        float *costs = malloc(graph.nodeCount * sizeof(float));
+        ASGridBuildJumpTable(jumpTableGrid);
+
+        for (int s = 0; s < 4; s++) {
+            const uint32_t start = rand() % graph.nodeCount;
+            dijkstra(&graph, start, costs);
+            for (int q = 0; q < 16; q++) {
+                const uint32_t goal = q? rand() % graph.nodeCount : start;
+                // no path starts or ends on a blocked cell, not even an empty one
+                const float expected = blocked[start] || blocked[goal]? INFINITY : costs[goal];
+                ASPath path = ASPathCreateWithGrid(workspace, grid, start, goal);
+                checkPath("jump point search", &graph, path, start, goal, expected);
+                ASPathDestroy(path);
+
+                path = ASPathCreateWithGrid(workspace, jumpTableGrid, start, goal);
+                checkPath("jump point search with table", &graph, path, start, goal, expected);
+                ASPathDestroy(path);
+            }
+        }
+
+        free(costs);
+        ASGridDestroy(grid);
+        ASGridDestroy(jumpTableGrid);
+        graphDestroy(&graph);
+        free(blocked);
+    }
+
+    ASSearchWorkspaceDestroy(workspace);
+}
+
+static void testPlanner(void) {
+    for (int trial = 0; trial < 200; trial++) {
+        const int heuristic = trial % 2;
+        testGraph graph = randomGraph(0);
+        const ASPathNodeIDSource source = {graph.nodeCount, &graphNeighbors, heuristic? &graphHeuristic : NULL, NULL, &graphReverseNeighbors};
+        float *costs = malloc(graph.nodeCount * sizeof(float));
+        uint32_t start = rand() % graph.nodeCount;
+        const uint32_t goal = rand() % graph.nodeCount;
+        ASPlanner planner = ASPlannerCreate(&source, &graph, start, goal);
+
+        for (int round = 0; round < 20; round++) {
+            dijkstra(&graph, start, costs);
+            ASPath path = ASPlannerCreatePath(planner);
+            checkPath("planner", &graph, path, start, goal, costs[goal]);
+
+            // step along the path
+            if (path && ASPathGetCount(path) > 1) {
+                start = ASPathGetNodeID(path, 1);
+                ASPlannerSetStart(planner, start);
+            }
+            ASPathDestroy(path);
+
+            // change the cost of a few edges, or remove them with an infinite cost, parallel edges included
+            for (int c = 0; c < 4 && graph.edgeCount; c++) {
+                ASGraphEdge *edge = &graph.edges[rand() % graph.edgeCount];
+                edge->cost = rand() % 4? distance(graph.positions, edge->from, edge->to) * (1 + (rand() % 100) / 25.f) : INFINITY;
+                ASPlannerUpdateEdge(planner, edge->from, edge->to);
+            }
+        }
+
+        ASPlannerDestroy(planner);
+        free(costs);
+        graphDestroy(&graph);
+    }
+}
+
+static const struct {
+    const char *name;
+    void (*run)(void);
+} tests[] = {
+    {"bidirectional", &testBidirectional},
+    {"contraction_hierarchy", &testContractionHierarchy},
+    {"jump_point_search", &testJumpPointSearch},
+    {"planner", &testPlanner},
+};
+
+int main(int argc, char** argv) {
+    int ran = 0;
+    for (size_t i = 0; i < sizeof(tests)/sizeof(tests[0]); i++) {
+        if (argc < 2 || strcmp(argv[1], tests[i].name) == 0) {
+            // the same inputs every run, whichever cases run before
+            srand(1);
+            tests[i].run();
+            ran++;
+        }
+    }
+    if (!ran) {
+        printf("no test named %s\n", argv[1]);
+        return 1;
+    }
+    printf("%zu failures\n", failures);
+    return failures != 0;
+}